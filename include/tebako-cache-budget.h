@@ -0,0 +1,100 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+namespace tebako {
+
+// sync_tebako_cache_budget
+// Process-wide budget for the decompressed data caches of all mounted memfs
+//
+// Each mounted memfs is a member with the cache size it asks for (its cachesize).
+// While the requests fit the budget, every member gets what it asked for; otherwise
+// each one gets min_cache_size and a part of the rest in proportion to its request
+// (if the budget cannot hold min_cache_size per member, it is split evenly). Shares
+// are recomputed when a memfs is mounted or unmounted and when the total changes,
+// and every member whose share has changed is told the new one, so the shares
+// never add up to more than the budget.
+// A part of the share may be fixed (dwarfs block cache that is sized once, when
+// filesystem_v2 is created): it is kept for the member, and only the rest of the
+// budget is shared in proportion to the requests.
+// The resize callback is called with the budget locked and shall not call it back.
+// Zero budget means no limit (each memfs gets its own cachesize)
+
+class sync_tebako_cache_budget {
+ public:
+  // The smallest share of a member while the budget can hold it
+  static constexpr size_t min_cache_size = static_cast<size_t>(1) << 20;
+
+  using resize_callback = std::function<void(size_t share)>;
+
+  struct budget {
+    size_t total{0};
+    size_t reserved{0};
+    size_t instances{0};
+  };
+
+ private:
+  struct member {
+    size_t requested;
+    size_t share;
+    resize_callback resize;
+    size_t fixed{0};
+  };
+
+  struct state {
+    size_t total{0};
+    uint64_t next_id{1};
+    std::map<uint64_t, member> members;
+  };
+
+  folly::Synchronized<state> s_budget;
+
+  static void rebalance(state& st, uint64_t except);
+
+ public:
+  static sync_tebako_cache_budget& get_tebako_cache_budget(void);
+
+  void set_total(size_t total);
+  budget get(void);
+
+  // Adds a member; share is set to its initial share
+  // returns
+  //  member id for release and get_share
+  uint64_t reserve(size_t requested, resize_callback resize, size_t& share);
+  void release(uint64_t id);
+  // Changes the size a member asks for (cachesize=auto decisions); the member
+  // is told its new share like the others
+  void request(uint64_t id, size_t requested);
+  // Sets the part of the share that the member cannot give back
+  void set_fixed(uint64_t id, size_t fixed);
+  size_t get_share(uint64_t id);
+};
+
+}  // namespace tebako
@@ -0,0 +1,74 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+namespace tebako {
+
+// tebako_cache_policy
+// Replacement policy of the memfs chunk cache (tebako_chunk_cache), over keys
+// only, so that the same code drives the cache and the trace-driven simulation
+// that compares the policies (tebako_cache_policy::hit_rate)
+//
+// dwarfs block cache is LRU; the memfs chunk cache in front of it can use
+//  lru    - least recently used, the reference
+//  2q     - 2Q: new keys enter a FIFO probation queue, keys seen again after they
+//           left it (ghost queue) enter the protected LRU queue
+//  s3fifo - S3-FIFO: new keys enter a small FIFO, keys accessed there move to the
+//           main FIFO, others leave a ghost; main keys accessed while resident
+//           are reinserted instead of being evicted
+// 2q and s3fifo are scan resistant: keys accessed once (a bulk scan or a copy)
+// leave through the small queue and do not evict the hot set
+
+class tebako_cache_policy {
+ public:
+  virtual ~tebako_cache_policy() = default;
+
+  // Records an access: returns true if the key is resident (a hit), otherwise
+  // admits it and appends the keys evicted to make room to evicted
+  virtual bool access(uint64_t key, std::vector<uint64_t>& evicted) = 0;
+  virtual bool contains(uint64_t key) const = 0;
+  virtual size_t size(void) const = 0;
+  // Changes the capacity; appends the keys evicted to fit it to evicted
+  virtual void resize(size_t capacity, std::vector<uint64_t>& evicted) = 0;
+
+  // Creates a policy for capacity keys; throws std::invalid_argument for an
+  // unknown name
+  static std::unique_ptr<tebako_cache_policy> create(const std::string& name, size_t capacity);
+  static bool is_valid_name(const std::string& name);
+
+  // Key of a chunk of file data (the chunk keys of tebako_disk_cache)
+  static uint64_t key(uint32_t inode, uint64_t chunk) { return (static_cast<uint64_t>(inode) << 40) | chunk; }
+  // Chunk keys touched by the ranges of a recorded manifest, in order
+  static std::vector<uint64_t> trace(const prefetch_manifest& ranges, size_t chunk_size);
+  // Replays the trace against a policy of capacity keys
+  static double hit_rate(const std::string& name, size_t capacity, const std::vector<uint64_t>& trace);
+};
+
+}  // namespace tebako
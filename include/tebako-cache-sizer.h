@@ -0,0 +1,103 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+namespace tebako {
+
+// tebako_cache_sizer
+// Online estimate of the block cache size needed for a target hit rate
+// (cachesize=auto)
+//
+// The miss-ratio curve is built SHARDS-style: file data is split into granules,
+// a fixed share of the granules (selected by key hash, so that every access to a
+// selected granule is seen) is tracked in an LRU stack and the reuse distance of
+// each access to it, scaled by the sampling rate, is added to a histogram.
+// The hit rate of a cache of S bytes is the share of accesses with reuse distance
+// below S. The histogram is halved at each evaluation, so that the estimate
+// follows the change from startup to steady state.
+//
+// dwarfs caches whole blocks and the block size is not known here, so the
+// estimate is approximate: it is the size of the file data in use
+
+class tebako_cache_sizer {
+ public:
+  static const size_t granule = static_cast<size_t>(256) << 10;
+  // Sampled accesses between evaluations
+  static const uint64_t evaluation_interval = 1024;
+
+  struct decision {
+    size_t size;
+    double hit_rate;  // estimated at size
+  };
+
+  tebako_cache_sizer(size_t min_bytes, size_t max_bytes, double target_hit_rate, unsigned int sampling_rate = 64);
+  tebako_cache_sizer(const tebako_cache_sizer&) = delete;
+  tebako_cache_sizer& operator=(const tebako_cache_sizer&) = delete;
+
+  // Records a read; returns true if an evaluation is due
+  bool record(uint32_t inode, uint64_t offset, size_t size) noexcept;
+  // Computes the smallest size within the bounds that reaches the target hit rate
+  // (the max bound if none does) and ages the histogram
+  decision evaluate(void);
+
+  double hit_rate(size_t bytes) const;
+  uint64_t get_sampled(void) const { return sampled.load(std::memory_order_relaxed); }
+  size_t get_min(void) const { return min_bytes; }
+  size_t get_max(void) const { return max_bytes; }
+  double get_target(void) const { return target_hit_rate; }
+
+ private:
+  static const uint32_t window = 1 << 16;
+
+  struct state {
+    std::unordered_map<uint64_t, uint32_t> last;  // granule key -> logical time
+    std::vector<uint32_t> marks;                  // Fenwick tree over logical time
+    uint32_t now{0};
+    std::vector<double> histogram;  // scaled reuse distance in granules
+    double cold{0};
+    double total{0};
+    uint64_t pending{0};
+  };
+
+  static void mark(std::vector<uint32_t>& marks, uint32_t t, int delta);
+  static uint32_t count_until(const std::vector<uint32_t>& marks, uint32_t t);
+  static void compact(state& s);
+  void access(state& s, uint64_t key);
+  double hit_rate_locked(const state& s, size_t bytes) const;
+
+  size_t min_bytes;
+  size_t max_bytes;
+  double target_hit_rate;
+  unsigned int sampling_rate;
+  std::atomic<uint64_t> sampled{0};
+  folly::Synchronized<state> s_state;
+};
+
+}  // namespace tebako
@@ -0,0 +1,96 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace tebako {
+
+// tebako_cache_counters
+// Read and cache counters of a memfs
+// Counters are sharded by thread (relaxed atomics on separate cache lines), so
+// that they can stay on in production; the shards are summed up when read
+//
+// dwarfs block cache does not expose its internal statistics, so the counters
+// are collected around it and are not block cache statistics: reads are timed in
+// memfs::inode_read (wall time, waiting for decompression included), and the
+// blocks are counted when the block cache releases their compressed data through
+// tebako::mfs (mm_release, that is the default unless cache_image is set)
+
+class tebako_cache_counters {
+ public:
+  enum counter {
+    reads,
+    bytes_read,
+    read_time_ns,
+    blocks_released,
+    released_bytes,
+    disk_cache_hits,
+    disk_cache_misses,
+    shm_cache_hits,
+    shm_cache_misses,
+    pinned_hits,
+    pressure_shrinks,
+    huge_page_bytes,
+    eager_hits,
+    eager_bytes,
+    eager_time_ns,
+    stream_reads,
+    stream_bytes,
+    chunk_cache_hits,
+    chunk_cache_misses,
+    n_counters
+  };
+
+  tebako_cache_counters() noexcept { reset(); }
+  tebako_cache_counters(const tebako_cache_counters&) = delete;
+  tebako_cache_counters& operator=(const tebako_cache_counters&) = delete;
+
+  void add(counter c, uint64_t value) noexcept
+  {
+    shards[shard_index()].values[c].fetch_add(value, std::memory_order_relaxed);
+  }
+  uint64_t get(counter c) const noexcept;
+  void reset(void) noexcept;
+
+ private:
+  static const size_t n_shards = 16;
+
+  struct alignas(64) shard {
+    std::atomic<uint64_t> values[n_counters];
+  };
+
+  static size_t shard_index(void) noexcept;
+
+  shard shards[n_shards];
+};
+
+}  // namespace tebako
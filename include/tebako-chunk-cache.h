@@ -0,0 +1,101 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+namespace tebako {
+
+class tebako_cache_policy;
+
+// tebako_chunk_cache
+// In-memory cache of decompressed file content with a selectable replacement
+// policy (see tebako_cache_policy), used instead of most of the dwarfs block cache
+// when memfs option cache_policy is set
+//
+// dwarfs block cache is LRU and cannot take another policy, so the cache works one
+// level up like tebako_disk_cache: file content is split into fixed-size chunks
+// keyed by the (root-relative) inode and the chunk number. Every lookup is an
+// access for the policy; a miss admits the key and the data is stored by put()
+// if the key is still resident. Chunks are shared, so the data is copied outside
+// of the lock
+//
+// Like the dwarfs block cache tidy thread, the data of the chunks not used for
+// max_age can be dropped (set_max_age, swept on put, and expire); their keys stay
+// with the policy and the next lookup is a miss that stores the data again
+
+class tebako_chunk_cache {
+ public:
+  static const size_t chunk_size = static_cast<size_t>(256) << 10;
+
+  tebako_chunk_cache(const std::string& policy, size_t max_bytes);
+  ~tebako_chunk_cache();
+  tebako_chunk_cache(const tebako_chunk_cache&) = delete;
+  tebako_chunk_cache& operator=(const tebako_chunk_cache&) = delete;
+
+  // Copies up to size bytes of the chunk starting at in_chunk to buf;
+  // length is set to the length of the chunk
+  bool get(uint32_t inode, uint64_t chunk, size_t in_chunk, char* buf, size_t size, size_t& length) noexcept;
+  void put(uint32_t inode, uint64_t chunk, const char* data, size_t length) noexcept;
+  // Changes the size cap, the chunks over it are evicted by the policy
+  void set_capacity(size_t max_bytes) noexcept;
+  // Drops the data of the chunks not used for max_age; returns the bytes dropped
+  size_t expire(std::chrono::milliseconds max_age) noexcept;
+  // Expires the chunks not used for max_age as new ones are stored (0 - never)
+  void set_max_age(std::chrono::milliseconds max_age) noexcept;
+
+  size_t get_bytes(void) const { return s_state.rlock()->bytes; }
+  // Chunks evicted by the policy (the expired ones are not counted)
+  uint64_t get_evictions(void) const { return s_state.rlock()->evictions; }
+  size_t get_capacity(void) const { return capacity; }  // in chunks
+  const std::string& get_policy(void) const { return policy_name; }
+
+ private:
+  struct entry {
+    std::shared_ptr<const std::vector<char>> data;
+    std::chrono::steady_clock::time_point used;
+  };
+
+  struct state {
+    std::unique_ptr<tebako_cache_policy> policy;
+    std::unordered_map<uint64_t, entry> chunks;
+    size_t bytes{0};
+    uint64_t evictions{0};
+    std::chrono::milliseconds max_age{0};
+    std::chrono::steady_clock::time_point expired;
+  };
+
+  static void drop(state& st, const std::vector<uint64_t>& evicted);
+  static size_t drop_older(state& st, std::chrono::steady_clock::time_point before);
+
+  std::string policy_name;
+  std::atomic<size_t> capacity;  // in chunks
+  folly::Synchronized<state> s_state;
+};
+
+}  // namespace tebako
@@ -76,6 +76,8 @@ class cmdline_args {
   void build_arguments_for_extract(const char* fs_mount_point);
   void build_arguments_for_run(const char* fs_mount_point, const char* fs_entry_point);
 
+  static size_t find_memfs_options(const std::string& target);
+
   std::vector<std::string> const& get_mountpoints() { return mountpoints; }
   std::vector<std::string> const& get_args() { return other_args; }
 
@@ -84,6 +84,8 @@ const size_t TEBAKO_DIR_CACHE_SIZE = 50;
 
 struct tebako_ds {
   tebako_dirent cache[TEBAKO_DIR_CACHE_SIZE];
+  // Stat of cached entries, collected by the same readdir pass (tebako_readdir_plus)
+  struct stat stats[TEBAKO_DIR_CACHE_SIZE];
   size_t dir_size;
   long dir_position;
   off_t cache_start;
@@ -120,6 +122,6 @@ class sync_tebako_dstable {
   long telldir(uintptr_t dirp) noexcept;
   int seekdir(uintptr_t dirp, long pos) noexcept;
   long dirfd(uintptr_t dirp) noexcept;
-  int readdir(uintptr_t dirp, tebako_dirent*& entry) noexcept;
+  int readdir(uintptr_t dirp, tebako_dirent*& entry, struct stat* st = nullptr) noexcept;
 };
 }  // namespace tebako
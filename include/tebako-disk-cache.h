@@ -0,0 +1,96 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+namespace tebako {
+
+// tebako_disk_cache
+// Persistent cache of decompressed file content, shared by the runs of the same
+// package (short-lived CLI tools decompress the same data on every invocation)
+//
+// dwarfs block cache cannot be fed from outside, so the cache works one level up:
+// file content is split into fixed-size chunks keyed by the image identity, the
+// (root-relative) inode and the chunk number. A chunk is stored in its own file
+//    <root>/v<format_version>-<image identity>/<inode>-<chunk>
+// with a header (format version, identity, key, length and checksum) that is
+// validated when the file is read. Files are written to a temporary name, synced
+// and renamed, so a crash leaves either a complete chunk or a stale temporary file.
+// The directory is trimmed to max_bytes by removing the least recently used files
+// (file mtime is refreshed when a chunk is read, at most once a minute)
+
+class tebako_disk_cache {
+ public:
+  static const uint32_t format_version = 1;
+  static const size_t chunk_size = static_cast<size_t>(256) << 10;
+
+  tebako_disk_cache(const std::string& root, uint64_t max_bytes, const void* image, size_t image_size);
+  ~tebako_disk_cache() = default;
+  tebako_disk_cache(const tebako_disk_cache&) = delete;
+  tebako_disk_cache& operator=(const tebako_disk_cache&) = delete;
+
+  // Looks up a chunk and reads its data into buffer
+  bool get(uint32_t inode, uint64_t chunk, std::vector<char>& buffer, size_t& length);
+  void put(uint32_t inode, uint64_t chunk, const char* data, size_t length) noexcept;
+
+  // Removes least recently used chunk files until the cache is within max_bytes;
+  // other files and directories under root are not touched
+  static void trim(const stdfs::path& root, uint64_t max_bytes) noexcept;
+
+  uint64_t get_identity(void) const { return identity; }
+  const stdfs::path& get_dir(void) const { return dir; }
+
+  static uint64_t image_identity(const void* image, size_t image_size);
+
+ private:
+  struct chunk_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t length;
+    uint64_t identity;
+    uint32_t inode;
+    uint32_t reserved;
+    uint64_t chunk;
+    uint64_t checksum;
+  };
+
+  static const char magic[8];
+  static uint64_t checksum(const char* data, size_t length);
+
+  stdfs::path chunk_path(uint32_t inode, uint64_t chunk) const;
+  void schedule_trim(void);
+
+  stdfs::path root;
+  stdfs::path dir;
+  uint64_t max_bytes;
+  uint64_t identity;
+  std::atomic<uint64_t> written{0};
+};
+
+}  // namespace tebako
@@ -41,8 +41,11 @@ struct tebako_fd {
   uint64_t pos;
   int lock;
   int* handle;
+  // Opened with O_DIRECT or stream_threshold bytes or larger, decided on open:
+  // reads do not go through the block cache (see memfs::stream_read)
+  bool stream;
 
-  tebako_fd() : pos(0), lock(0), handle(NULL) { memset(&st, 0, sizeof(st)); }
+  tebako_fd() : pos(0), lock(0), handle(NULL), stream(false) { memset(&st, 0, sizeof(st)); }
   ~tebako_fd()
   {
     if (handle) {
@@ -81,7 +84,11 @@ class sync_tebako_fdtable {
               off_t cache_start,
               size_t buffer_size,
               size_t& cache_size,
-              size_t& dir_size) noexcept;
+              size_t& dir_size,
+              struct stat* stats = nullptr) noexcept;
+#ifndef RB_W32
+  ssize_t getdents(int vfd, void* buf, size_t nbyte) noexcept;
+#endif
 #ifdef TEBAKO_HAS_READV
   ssize_t readv(int vfd, const struct ::iovec* iov, int iovcnt) noexcept;
 #endif
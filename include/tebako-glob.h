@@ -0,0 +1,85 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+namespace tebako {
+
+// glob_segment
+// A single path component of glob pattern
+//  LITERAL   - no wildcards, looked up by name
+//  WILDCARD  - '*', '?' and '[...]' matched against each directory entry name
+//  RECURSIVE - '**', matches zero or more directories
+
+class glob_segment {
+ public:
+  enum kind { LITERAL, WILDCARD, RECURSIVE };
+
+  glob_segment(const std::string& pattern, int flags);
+
+  kind get_kind() const { return k; }
+  const std::string& get_literal() const { return literal; }
+  bool match(std::string_view name) const;
+
+ private:
+  kind k;
+  std::string pattern;
+  std::string literal;
+  int flags;
+
+  int match_bracket(size_t p, char ch, size_t& next) const;
+  bool chars_equal(char a, char b) const;
+};
+
+// glob_pattern
+// Compiled brace-free glob pattern
+// The leading components without wildcards form the prefix, which is resolved
+// once; the rest is matched against directory entries segment by segment
+
+class glob_pattern {
+ public:
+  glob_pattern(const std::string& pattern, int flags);
+
+  // Expands braces and compiles each of the resulting patterns
+  static std::vector<glob_pattern> compile(const std::string& pattern, int flags);
+  static void expand_braces(const std::string& pattern, bool noescape, std::vector<std::string>& out);
+
+  const std::string& get_prefix() const { return prefix; }
+  const std::vector<glob_segment>& get_segments() const { return segments; }
+  bool dirs_only() const { return trailing_slash; }
+  bool dotmatch() const { return (flags & TEBAKO_GLOB_DOTMATCH) != 0; }
+
+ private:
+  std::string prefix;
+  std::vector<glob_segment> segments;
+  bool trailing_slash;
+  int flags;
+};
+
+}  // namespace tebako
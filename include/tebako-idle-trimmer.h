@@ -0,0 +1,95 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+namespace tebako {
+
+// tebako_idle_trimmer
+// Idle-time cache trimming for long-running processes
+//
+// While it is enabled the block caches of all memfs evict the blocks that have
+// not been used for max_age (dwarfs block cache tidy thread, see
+// memfs::apply_cache_tidy), and a background timer drops the chunk cache data
+// of the same age and returns the freed heap memory to the OS (malloc_trim,
+// glibc only) when no memfs has been read since the previous tick. Bytes
+// reclaimed are the chunk cache data dropped by the trims only; the memory
+// returned to the OS, the blocks evicted by the dwarfs tidy threads included, is
+// measured as the drop of the resident set size across the trim (Linux only)
+
+class tebako_idle_trimmer {
+ public:
+  struct stats {
+    bool enabled{false};
+    std::chrono::milliseconds max_age{0};
+    uint64_t checks{0};
+    uint64_t trims{0};
+    uint64_t bytes_reclaimed{0};
+    uint64_t rss_reclaimed{0};
+  };
+
+  static tebako_idle_trimmer& get_tebako_idle_trimmer(void);
+
+  ~tebako_idle_trimmer();
+
+  // Starts trimming the blocks not used for max_age; restarts if it is running
+  void start(std::chrono::milliseconds max_age);
+  void stop(void);
+  // One timer check: trims if the memfs have been idle since the previous one;
+  // returns the number of chunk cache bytes dropped
+  uint64_t check(void);
+
+  std::chrono::milliseconds get_max_age(void) const { return std::chrono::milliseconds(max_age_ms.load()); }
+  stats get_stats(void);
+
+ private:
+  tebako_idle_trimmer() = default;
+  void run(void);
+  static uint64_t total_reads(void);
+  static uint64_t resident_bytes(void);
+
+  std::mutex mtx;
+  std::mutex check_mtx;
+  std::condition_variable cv;
+  std::thread thread;
+  bool stopping{false};
+  std::atomic<int64_t> max_age_ms{0};
+
+  uint64_t last_reads{0};
+  uint64_t checks{0};
+  uint64_t trims{0};
+  uint64_t bytes_reclaimed{0};
+  uint64_t rss_reclaimed{0};
+};
+
+}  // namespace tebako
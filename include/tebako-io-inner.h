@@ -63,4 +63,14 @@ struct tebako_dirent;
 #else
 union tebako_dirent;
 #endif
+
+// Directory tree walk callback (memfs::inode_walk)
+// Receives a path relative to the walk root, entry stat and nesting level (1 for
+// direct children of the walk root)
+typedef std::function<int(const std::string& path, const struct stat* st, int level)> walk_callback;
+
+// Glob match callback (memfs::inode_glob)
+// Receives the matched path (pattern prefix followed by the matched components)
+// and entry stat
+typedef std::function<int(const std::string& path, const struct stat* st)> glob_callback;
 }  // namespace tebako
@@ -30,6 +30,11 @@
 #pragma once
 
 namespace tebako {
+class glob_pattern;
+class prefetch_job;
+struct memfs_options;
+struct prefetch_range;
+
 int mount_root_memfs(const void* data,
                      const unsigned int size,
                      const char* debuglevel,
@@ -39,6 +44,15 @@ int mount_root_memfs(const void* data,
                      const char* decompress_ratio,
                      const char* image_offset);
 
+int mount_root_memfs_async(const void* data,
+                           const unsigned int size,
+                           const char* debuglevel,
+                           const char* cachesize,
+                           const char* workers,
+                           const char* mlock,
+                           const char* decompress_ratio,
+                           const char* image_offset);
+
 int mount_memfs(const void* data, const unsigned int size, const char* image_offset, const char* path);
 
 int mount_memfs(const void* data,
@@ -47,8 +61,17 @@ int mount_memfs(const void* data,
                 uint32_t parent_inode,
                 const char* path);
 
+int mount_memfs(const void* data,
+                const unsigned int size,
+                const char* image_offset,
+                uint32_t parent_inode,
+                const char* path,
+                const memfs_options& opts);
+
 void unmount_root_memfs(void);
 
+std::shared_ptr<prefetch_job> prefetch_memfs(uint32_t index, const std::vector<prefetch_range>& manifest);
+
 int dwarfs_access(const std::string&, int amode, uid_t uid, gid_t gid, std::string& lnk) noexcept;
 int dwarfs_lstat(const std::string&, struct stat* buf, std::string& lnk) noexcept;
 int dwarfs_readlink(const std::string& path, std::string& link, std::string& lnk) noexcept;
@@ -61,12 +84,21 @@ int dwarfs_inode_relative_stat(uint32_t inode,
                                struct stat* buf,
                                std::string& lnk,
                                bool follow) noexcept;
-ssize_t dwarfs_inode_read(uint32_t inode, void* buf, size_t size, off_t offset) noexcept;
+ssize_t dwarfs_inode_read(uint32_t inode, void* buf, size_t size, off_t offset, bool stream = false) noexcept;
+bool dwarfs_inode_streamed(const struct stat* st) noexcept;
+int dwarfs_inode_prefetch(uint32_t inode, uint64_t offset, uint64_t length, std::vector<char>& scratch) noexcept;
+int dwarfs_inode_pin(uint32_t inode, bool pin) noexcept;
 int dwarfs_inode_readdir(uint32_t inode,
                          tebako::tebako_dirent* cache,
                          off_t cache_start,
                          size_t buffer_size,
                          size_t& cache_size,
-                         size_t& dir_size) noexcept;
+                         size_t& dir_size,
+                         struct stat* stats = nullptr) noexcept;
+int dwarfs_inode_walk(uint32_t inode, const walk_callback& fn, bool parallel) noexcept;
+int dwarfs_inode_glob(uint32_t inode, const glob_pattern& pattern, std::string& path, const glob_callback& fn) noexcept;
+#ifndef RB_W32
+int dwarfs_inode_getdents(uint32_t inode, void* buf, size_t size, uint64_t& pos) noexcept;
+#endif
 
 }  // namespace tebako
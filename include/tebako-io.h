@@ -53,6 +53,24 @@ int mount_root_memfs(const void* data,
                      const char* decompress_ratio,
                      const char* image_offset);
 
+/* mount_root_memfs_async starts mount_root_memfs on a background thread and returns
+    immediately (0, or -1 if the thread cannot be started), so that loading the
+    filesystem overlaps with the application startup
+    tebako_* calls that need memfs (and tebako_getcwd) wait until the mount completes
+   mount_root_memfs_wait waits for the mount and returns the result of the last
+    asynchronous mount: 0, or -1 with errno set as mount_root_memfs would have;
+    it returns 0 if there has been no asynchronous mount
+*/
+int mount_root_memfs_async(const void* data,
+                           const unsigned int size,
+                           const char* debuglevel,
+                           const char* cachesize,
+                           const char* workers,
+                           const char* mlock,
+                           const char* decompress_ratio,
+                           const char* image_offset);
+int mount_root_memfs_wait(void);
+
 int mount_memfs_at_root(const void* data, const unsigned int size, const char* image_offset, const char* path);
 
 int mount_memfs(const void* data,
@@ -61,8 +79,271 @@ int mount_memfs(const void* data,
                 unsigned int parent_inode,
                 const char* path);
 
+/* mount_memfs_with_options mounts memfs with its own cache and worker settings
+    options is a comma-separated list like "cachesize=16M,workers=1"
+    Supported keys: cachesize, workers, mlock, decompress_ratio, perfmon,
+    disk_cache, disk_cache_size, shm_cache_size, cachesize_min, cachesize_max,
+    target_hit_rate, pressure_max_age, madvise, hugepages, lazy_workers,
+    lazy_threshold, eager, stream_threshold, stream_buffers, cache_policy
+    The options that are not specified are inherited from mount_root_memfs
+*/
+int mount_memfs_with_options(const void* data,
+                             const unsigned int size,
+                             const char* image_offset,
+                             unsigned int parent_inode,
+                             const char* path,
+                             const char* options);
+
 void unmount_root_memfs(void);
 
+/* tebako_set_cache_budget sets process-wide limit for the decompressed data caches of
+    all memfs (like "1G"); NULL or "0" removes the limit
+    While the cachesize of the mounted memfs add up to no more than the budget, each
+    one gets its cachesize; otherwise each gets 1M and a part of the rest in proportion
+    to its cachesize. The shares are recomputed when memfs is mounted or unmounted and
+    when the budget changes, and the caches of the memfs are resized to them
+    A memfs share covers its block cache, chunk cache, pinned files, streaming buffers
+    and eager arena. dwarfs block cache cannot be resized, so with a budget memfs
+    keeps a small block cache (a quarter of its initial share, up to 16M, fixed at
+    mount and kept out of the shares of other memfs) and the rest in the chunk cache
+    (lru unless tebako_set_cache_policy selects another one); pinned files and the
+    eager arena are not evicted, so they can take memfs over its share, and a memfs
+    mounted before the budget is set with cache_policy=dwarfs keeps its block cache
+*/
+int tebako_set_cache_budget(const char* budget);
+
+/* tebako_set_disk_cache enables persistent cache of decompressed file content for
+    the memfs mounted after the call; dir is the cache directory (NULL disables the
+    cache), max_size is its size cap like "256M" (NULL - 1G)
+    The cache is keyed by image identity, so it may be shared by different packages
+    and their versions; least recently used data is removed when it grows over the cap
+*/
+int tebako_set_disk_cache(const char* dir, const char* max_size);
+
+/* tebako_set_shm_cache enables decompressed file content cache in POSIX shared memory
+    for the memfs mounted after the call; the processes that mount the same image
+    (prefork workers) attach to the same segment and read the data decompressed by
+    any of them. max_size like "256M" is used by the process that creates the segment
+    and caps it for all of them (NULL or "0" disables the cache)
+    Only a segment owned by the effective user and not writable by group or others
+    is attached. The segment is unlinked when the last attached process unmounts;
+    a process killed without unmounting keeps it attached until reboot or
+    tebako_unlink_shm_cache, which removes the name of the segment used by memfs #index
+    (attached processes keep using it, the memory is freed when the last one detaches)
+*/
+int tebako_set_shm_cache(const char* max_size);
+int tebako_unlink_shm_cache(int index);
+
+/* tebako_set_memory_monitor starts watching cgroup v2 memory usage and PSI memory
+    pressure of the process every interval_ms (0 - 1 s); cgroup_dir is the cgroup
+    directory or "auto" to find it through /proc/self/cgroup, NULL stops watching
+    Under pressure (memory.current over 90% of memory.high or memory.max, or PSI
+    "some" avg10 over 10%) the block caches of all memfs evict the blocks not used
+    for pressure_max_age (memfs option, 2000 ms), and regrow when the usage falls
+    below 80% and PSI below 5%
+   tebako_get_memory_pressure reports the state, the last sample and the number
+    of shrink events
+*/
+struct tebako_memory_pressure {
+  int enabled;
+  int under_pressure;
+  unsigned long long checks;
+  unsigned long long shrink_events;
+  unsigned long long memory_current;
+  unsigned long long memory_limit;
+  double psi_some_avg10;
+};
+
+int tebako_set_memory_monitor(const char* cgroup_dir, unsigned int interval_ms);
+int tebako_get_memory_pressure(struct tebako_memory_pressure* st);
+
+/* tebako_set_idle_trim enables idle-time trimming for long-running processes
+    (0 disables it): the block caches of all memfs evict the blocks not used for
+    max_age_ms, and every max_age_ms, if no memfs has been read since the previous
+    check, the freed heap memory is returned to the OS (glibc malloc_trim)
+   tebako_get_idle_trim reports the number of checks and trims, bytes_reclaimed -
+    the chunk cache data dropped by the trims only (see tebako_set_cache_policy,
+    so it stays 0 with the dwarfs block cache), and rss_reclaimed - the drop of
+    the process resident memory across the trims (Linux only, 0 elsewhere)
+*/
+struct tebako_idle_trim {
+  int enabled;
+  unsigned int max_age_ms;
+  unsigned long long checks;
+  unsigned long long trims;
+  unsigned long long bytes_reclaimed;
+  unsigned long long rss_reclaimed;
+};
+
+int tebako_set_idle_trim(unsigned int max_age_ms);
+int tebako_get_idle_trim(struct tebako_idle_trim* st);
+
+/* tebako_get_pool_stats reports the state of the shared thread pool that runs
+    parallel walks and prefetch, and the number of dwarfs decompression
+    workers reserved by the mounted memfs (capped by cpu_quota less one slot
+    that the memfs granted no workers share for their reads)
+*/
+struct tebako_pool_stats {
+  size_t threads;
+  size_t busy;
+  size_t queue_depth;
+  size_t background_depth;
+  unsigned long long tasks_completed;
+  unsigned long long busy_time_ns;
+  size_t decompression_workers;
+  size_t cpu_quota;
+};
+
+int tebako_get_pool_stats(struct tebako_pool_stats* st);
+
+/* tebako_set_perfmon enables (or disables) dwarfs performance monitor for the memfs
+    mounted after the call (mount_root_memfs and the nested ones that do not override
+    it with "perfmon=0")
+   tebako_perfmon_summary writes per-operation timings (samples, overall time and
+    latency percentiles for find, getattr, readdir, readlink and read) of memfs #index
+    (0 is the root one) to buf
+    Returns the length of the summary like snprintf does, so that the caller can
+    retry with a larger buffer; -1 and ENOENT if there is no such memfs, ENOTSUP
+    if perfmon is not enabled for it
+*/
+void tebako_set_perfmon(int enable);
+int tebako_perfmon_summary(int index, char* buf, size_t size);
+
+/* tebako_set_lazy_workers makes memfs mounted after the call start its dwarfs
+    decompression workers on demand instead of at mount (memfs options lazy_workers
+    and lazy_threshold): reads smaller than threshold (NULL - 1M) start one worker,
+    the first larger read or concurrent reads start all of them
+    This cuts the fixed startup cost of short-lived tools that read a few small files
+*/
+int tebako_set_lazy_workers(int enable, const char* threshold);
+
+/* tebako_set_eager sets eager decompression for memfs mounted after the call
+    (memfs option eager): "mount" (or "1") decompresses all regular files of the
+    image in parallel (by up to "workers" decompression workers, with a private
+    block cache of stream_buffers bytes) into a flat read-only arena before mount returns,
+    "background" (or "2") does it right after mount while reads go through the
+    block cache, NULL or "0" turns it off
+    Once the arena is ready reads are served from it by memcpy and bypass the block
+    cache; the cost is reported by tebako_get_cache_stats (eager_bytes held in
+    memory and eager_time_ns spent)
+*/
+int tebako_set_eager(const char* mode);
+
+/* tebako_set_stream makes memfs mounted after the call read the files of threshold
+    bytes or more (NULL or "0" - none) around the block cache (memfs options
+    stream_threshold and stream_buffers): their blocks are decompressed into a
+    private cache of buffers bytes (NULL - 16M) and are not admitted to the block
+    cache, so that a one-shot read of a large file does not evict the hot blocks
+    of the others
+    The files opened with O_DIRECT are read this way regardless of their size
+*/
+int tebako_set_stream(const char* threshold, const char* buffers);
+
+/* tebako_set_cache_policy selects the cache replacement policy of memfs mounted
+    after the call (mount_root_memfs and the nested ones that do not override it
+    with memfs option cache_policy)
+    "dwarfs" (or NULL) keeps dwarfs LRU block cache; "lru", "2q" or "s3fifo" put a
+    chunk cache with this policy in front of it that takes most of cachesize
+    2q and s3fifo are scan resistant: data read once by bulk scans or copies does
+    not evict the data that is read again and again
+*/
+int tebako_set_cache_policy(const char* policy);
+
+/* Startup prefetch manifest
+   tebako_prefetch_record starts recording the file ranges read from the root memfs
+    during the next 'seconds' seconds (0 stops recording); this is the training run
+    made at package time
+   tebako_prefetch_record_save saves the recorded manifest to a host file, in the
+    format of the optional prefetch section of tebako::package_descriptor
+    (package_descriptor::serialize_manifest)
+   tebako_prefetch_manifest queues the manifest ranges of the root memfs on the
+    background workers, so that their blocks are decompressed ahead of demand;
+    it returns immediately with a prefetch handle (see tebako_prefetch)
+*/
+int tebako_prefetch_record(unsigned int seconds);
+int tebako_prefetch_record_save(const char* path);
+int tebako_prefetch_manifest(const void* manifest, size_t size);
+
+/* tebako_get_cache_stats reports read and cache counters of memfs #index
+    (0 is the root one) or the sum over all mounted memfs if index is -1
+    dwarfs block cache does not expose its hits, misses, evictions or decompression
+    time, so none of the counters below is a block cache statistic: read_time_ns is
+    the wall time of memfs reads (decompression and waits for it included),
+    blocks_released and released_bytes count the blocks whose compressed data the
+    block cache released after decompressing them completely (always 0 if the memfs
+    caches the whole image), disk_cache_hits and disk_cache_misses count the chunks
+    found and not found in the persistent disk cache, shm_cache_hits and
+    shm_cache_misses - in the shared memory cache, pinned_hits count the reads
+    served by pinned files (see tebako_pin) and pinned_bytes is their size,
+    pressure_shrinks counts the block cache shrinks under memory pressure,
+    huge_page_bytes is the size of the image metadata remapped onto transparent
+    huge pages (memfs option hugepages=1), eager_hits counts the reads served by
+    the eager arena, eager_bytes is its size and eager_time_ns the time spent to
+    fill it (see tebako_set_eager), stream_reads and stream_bytes count the reads
+    made around the block cache (see tebako_set_stream), chunk_cache_hits and
+    chunk_cache_misses count the chunks found and not found in the chunk cache,
+    chunk_cache_bytes is the size of the data it holds and chunk_cache_evictions
+    counts the chunks evicted by its policy (see tebako_set_cache_policy),
+    cache_size is the block cache limit granted, workers - the decompression workers
+    granted and workers_started - the ones started (see tebako_set_lazy_workers)
+    Counters are reset when memfs is (re)loaded
+*/
+struct tebako_cache_stats {
+  unsigned long long reads;
+  unsigned long long bytes_read;
+  unsigned long long read_time_ns;
+  unsigned long long blocks_released;
+  unsigned long long released_bytes;
+  unsigned long long disk_cache_hits;
+  unsigned long long disk_cache_misses;
+  unsigned long long shm_cache_hits;
+  unsigned long long shm_cache_misses;
+  unsigned long long pinned_hits;
+  size_t pinned_bytes;
+  unsigned long long pressure_shrinks;
+  size_t huge_page_bytes;
+  unsigned long long eager_hits;
+  size_t eager_bytes;
+  unsigned long long eager_time_ns;
+  unsigned long long stream_reads;
+  unsigned long long stream_bytes;
+  unsigned long long chunk_cache_hits;
+  unsigned long long chunk_cache_misses;
+  size_t chunk_cache_bytes;
+  unsigned long long chunk_cache_evictions;
+  size_t cache_size;
+  size_t workers;
+  size_t workers_started;
+  unsigned int memfs_count;
+};
+
+int tebako_get_cache_stats(int index, struct tebako_cache_stats* st);
+
+/* tebako_get_cache_sizing reports cachesize=auto state of memfs #index
+    (cachesize "auto" for mount_root_memfs or the memfs option, with cachesize_min,
+    cachesize_max and target_hit_rate options): the working set is estimated from
+    sampled reads and the cache size that reaches the target hit rate within the
+    bounds is recommended. dwarfs block cache cannot be resized while mounted, so
+    with cachesize=auto memfs keeps most of the cache in the chunk cache (lru unless
+    tebako_set_cache_policy selects another one): the recommendation resizes it at
+    once, within the cache budget (see tebako_set_cache_budget), and is the initial
+    size when the image is mounted again in the process
+    auto_mode is 0 and the estimates are 0 if the memfs uses a fixed cachesize
+*/
+struct tebako_cache_sizing {
+  int auto_mode;
+  size_t cache_size;
+  size_t recommended;
+  size_t min_size;
+  size_t max_size;
+  double target_hit_rate;
+  double estimated_hit_rate;
+  unsigned long long sampled;
+  unsigned int decisions;
+};
+
+int tebako_get_cache_sizing(int index, struct tebako_cache_sizing* st);
+
 char* tebako_getcwd(char* buf, size_t size);
 int tebako_chdir(const char* path);
 
@@ -132,11 +413,100 @@ int tebako_lstat(const char* path, struct STAT_TYPE* buf);
 #ifdef TEBAKO_HAS_FSTATAT
 int tebako_fstatat(int fd, const char* path, struct stat* buf, int flag);
 #endif
+
+/* tebako_walk walks memfs directory tree (pre-order) without path resolution
+    The callback gets the path relative to the walk root (in a buffer reused
+    between calls), stat of the entry and the nesting level (1 for direct children).
+    It shall return
+      TEBAKO_WALK_CONTINUE  to proceed,
+      TEBAKO_WALK_PRUNE     to skip the subtree of a directory,
+      any other value       to stop the walk; tebako_walk returns this value
+    With TEBAKO_WALK_PARALLEL flag the subtrees are walked by several threads
+    and the callback shall be thread-safe.
+    The walk does not follow symlinks and does not cross mount points.
+*/
+#define TEBAKO_WALK_CONTINUE 0
+#define TEBAKO_WALK_PRUNE 1
+
+#define TEBAKO_WALK_PARALLEL 0x01
+
+typedef int (*tebako_walk_fn)(const char* path, const struct stat* st, int level, void* ctx);
+int tebako_walk(const char* path, tebako_walk_fn fn, int flags, void* ctx);
+
+/* tebako_glob matches a pattern against memfs directory tree
+    Supports '*', '?', '[...]', '{a,b}' and '**' (zero or more directories).
+    Flag values are the same as Ruby File::FNM_* ones.
+    The callback gets the matched path (the pattern prefix as written followed
+    by the matched names) and stat of the entry; non-zero value stops the glob
+    and tebako_glob returns it.
+    Names starting with '.' are matched only explicitly unless TEBAKO_GLOB_DOTMATCH
+    is set. With TEBAKO_GLOB_CASEFOLD the names below the memfs root are matched
+    case-insensitively, the mount point itself is matched as written.
+    The glob does not follow symlinks and does not cross mount points.
+*/
+#define TEBAKO_GLOB_NOESCAPE 0x01
+#define TEBAKO_GLOB_DOTMATCH 0x04
+#define TEBAKO_GLOB_CASEFOLD 0x08
+
+typedef int (*tebako_glob_fn)(const char* path, const struct stat* st, void* ctx);
+int tebako_glob(const char* pattern, int flags, tebako_glob_fn fn, void* ctx);
+
+/* tebako_prefetch queues decompression of the blocks covered by a memfs file or
+    by all files of a directory subtree (only the files of the directory itself with
+    TEBAKO_PREFETCH_NORECURSE) on the low-priority background queue
+   tebako_prefetch_glob does the same for the files matching a pattern (flags are
+    TEBAKO_GLOB_* ones)
+    Both return immediately (the subtree is walked in the background) with a
+    positive handle, or -1 if the path is not in memfs [errno is set]
+   tebako_prefetch_wait waits for the prefetch to complete
+   tebako_prefetch_cancel stops it as soon as the ranges being read are done
+   tebako_prefetch_done returns 1 if the prefetch has completed, 0 otherwise
+    These return -1 and EINVAL for a handle that has not been issued
+    Prefetch does not follow symlinks and does not cross mount points; it is
+    cancelled when memfs is unmounted.
+*/
+#define TEBAKO_PREFETCH_NORECURSE 0x01
+
+int tebako_prefetch(const char* path, int flags);
+int tebako_prefetch_glob(const char* pattern, int flags);
+int tebako_prefetch_wait(int handle);
+int tebako_prefetch_cancel(int handle);
+int tebako_prefetch_done(int handle);
+
+/* tebako_pin decompresses a memfs file (or all files of a directory subtree)
+    completely and keeps its content in the pinned pool of its memfs: reads of the
+    file are served from there and do not compete for the block cache, so bulk
+    reads cannot evict it. Pinned memory is reported by tebako_get_cache_stats
+    and is counted in the cache size of its memfs (the chunk cache shrinks to make
+    room for it, if there is one), but it is not evicted to meet the cache budget
+   tebako_unpin releases it
+    Both return 0 on success and -1 if the path is not in memfs or the file
+    cannot be read (or is not pinned) [errno is set]
+*/
+int tebako_pin(const char* path);
+int tebako_unpin(const char* path);
 #endif
 
 int tebako_close(int vfd);
 ssize_t tebako_readlink(const char* path, char* buf, size_t bufsiz);
 
+/* tebako_getdents fills buf with as many directory records as fit
+    The records are binary compatible with Linux struct linux_dirent64
+    and are aligned at 8 bytes; iterate using d_reclen
+    Directory position is shared with tebako_lseek (entry index)
+*/
+#ifndef RB_W32
+struct tebako_dirent64 {
+  unsigned long long d_ino;
+  long long d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[];
+};
+
+ssize_t tebako_getdents(int vfd, void* buf, size_t nbyte);
+#endif
+
 /* DIR and struct dirent is defined only if dirent.h has been included
     In Ruby eenvironment
         tebako_opendir
@@ -160,6 +530,31 @@ struct direct* tebako_readdir(DIR* dirp, void* enc);
 struct dirent* tebako_readdir(DIR* dirp);
 #endif  // RB_W32
 
+/* tebako_readdir_plus returns the next entry together with its stat (as lstat
+    reports it). For memfs directories the stat is collected by the same metadata
+    pass as the entry itself, so there is no path resolution; other directories
+    fall back to readdir and fstatat; if fstatat fails the entry is returned with
+    st zeroed (st_mode is 0).
+    tebako_scandir_plus is scandir built on top of it; the namelist and the records
+    are allocated as a single block that is released with tebako_scandir_plus_free.
+*/
+#if defined(TEBAKO_HAS_READDIR) && !defined(RB_W32) && (defined(_SYS_STAT_H) || defined(_SYS_STAT_H_))
+struct tebako_dirent_plus {
+  struct stat d_stat;
+  struct dirent d_ent;
+};
+
+struct dirent* tebako_readdir_plus(DIR* dirp, struct stat* st);
+
+#if defined(TEBAKO_HAS_OPENDIR) && defined(TEBAKO_HAS_CLOSEDIR)
+int tebako_scandir_plus(const char* dir,
+                        struct tebako_dirent_plus*** namelist,
+                        int (*sel)(const struct tebako_dirent_plus*),
+                        int (*compar)(const struct tebako_dirent_plus**, const struct tebako_dirent_plus**));
+void tebako_scandir_plus_free(struct tebako_dirent_plus** namelist);
+#endif
+#endif
+
 long tebako_telldir(DIR* dirp);
 void tebako_seekdir(DIR* dirp, long loc);
 int tebako_closedir(DIR* dirp);
@@ -169,6 +564,9 @@ int tebako_dirfd(DIR* dirp);
 #endif
 
 #ifdef TEBAKO_HAS_SCANDIR
+/* tebako_scandir is scandir over memfs: each entry and the namelist are released
+    with free() as POSIX requires; sel and compar are called on the calling thread
+*/
 int tebako_scandir(const char* dir,
                    struct dirent*** namelist,
                    int (*sel)(const struct dirent*),
@@ -42,6 +42,8 @@ class sync_tebako_memfs_table {
  private:
   folly::Synchronized<tebako_memfs_table> s_tebako_memfs_table;
 
+  sync_tebako_memfs_table();
+
  public:
   static sync_tebako_memfs_table& get_tebako_memfs_table(void);
 
@@ -62,6 +64,7 @@ class sync_tebako_memfs_table {
   void clear(void);
   void erase(uint32_t index);
   std::shared_ptr<memfs> get(uint32_t index);
+  std::vector<std::shared_ptr<memfs>> get_all(void);
   bool insert(uint32_t index, std::shared_ptr<memfs> fs);
   uint32_t insert_auto(std::shared_ptr<memfs> fs);
 };
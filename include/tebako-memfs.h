@@ -36,46 +36,186 @@
 #include "dwarfs/metadata_v2.h"
 #include "dwarfs/mmap.h"
 #include "dwarfs/options.h"
+#include "dwarfs/performance_monitor.h"
 #include "dwarfs/util.h"
 
+#include <tebako-cache-stats.h>
+#include <tebako-package-descriptor.h>
+
+#include <tebako-io-inner.h>
+
 void tebako_init_cwd(dwarfs::logger& lgr, bool need_debug_policy);
 void tebako_drop_cwd(void);
 
 namespace tebako {
 
+class glob_pattern;
+class mfs;
+class tebako_disk_cache;
+class tebako_shm_cache;
+class tebako_chunk_cache;
+class tebako_cache_sizer;
+
 struct memfs_options {
   int readonly{0};
   int cache_image{0};
   int enable_nlink{0};
   size_t cachesize{(static_cast<size_t>(512) << 20)};
+  // cachesize=auto: cache size is estimated between the bounds for the target hit rate
+  // and applied to the chunk cache while mounted (see memfs::evaluate_cache_size)
+  int cachesize_auto{0};
+  size_t cachesize_min{(static_cast<size_t>(32) << 20)};
+  size_t cachesize_max{(static_cast<size_t>(512) << 20)};
+  double target_hit_rate{0.9};
+  // Under memory pressure the blocks not used for this time are evicted
+  std::chrono::milliseconds pressure_max_age{2000};
   size_t workers{2};
+  // Lazy workers: none are started at mount, reads below lazy_threshold start one,
+  // the first larger one starts all of them (see memfs::fs_read)
+  int lazy_workers{0};
+  size_t lazy_threshold{(static_cast<size_t>(1) << 20)};
   dwarfs::mlock_mode lock_mode{dwarfs::mlock_mode::NONE};
   double decompress_ratio{0.8};
+  int perfmon{0};
+  // madvise hints over the image sections (see tebako::mfs)
+  int madvise{1};
+  // Image metadata is remapped onto transparent huge pages (see mfs::use_huge_pages)
+  int hugepages{0};
+  // All regular files are decompressed into a flat arena (see memfs::decompress_all):
+  // 0 - off, 1 - at mount, 2 - in the background after mount
+  int eager{0};
+  // Reads of the files of stream_threshold bytes or more (0 - none) go through a
+  // private block cache of stream_buffers bytes (see memfs::stream_read)
+  size_t stream_threshold{0};
+  size_t stream_buffers{(static_cast<size_t>(16) << 20)};
+  // Replacement policy of the chunk cache that takes most of cachesize
+  // (see tebako_chunk_cache); "dwarfs" - no chunk cache, dwarfs LRU block cache only
+  // (lru chunk cache with cachesize=auto or the global cache budget, see apply_budget_share)
+  std::string cache_policy{"dwarfs"};
+  std::string disk_cache;
+  size_t disk_cache_size{(static_cast<size_t>(1) << 30)};
+  size_t shm_cache_size{0};
   dwarfs::logger::level_type debuglevel{dwarfs::logger::level_type::INFO};
 };
 
+// Latest decision of cachesize=auto
+struct memfs_cache_sizing {
+  size_t recommended{0};
+  double hit_rate{0};
+  unsigned int decisions{0};
+};
+
 class memfs {
  private:
   const void* data;
   const unsigned int size;
   uint32_t dwarfs_root_inode;
 
+  memfs_options mopts;
+  // Member of the global cache budget and its current share (see apply_budget_share)
+  uint64_t budget_id{0};
+  std::atomic<size_t> budget_share{0};
+  // dwarfs block cache in front of the chunk cache (0 without a chunk cache)
+  std::atomic<size_t> block_cache_bytes{0};
+  size_t reserved_workers{0};
   dwarfs::filesystem_options fsopts;
+  // Declared before fs, so that they outlive filesystem_v2 that samples into them
+  std::shared_ptr<dwarfs::performance_monitor> perfmon;
+  tebako_cache_counters counters;
   dwarfs::filesystem_v2 fs;
+  // Image view of fs; other filesystem_v2 over the image take their views from it
+  std::shared_ptr<tebako::mfs> image_mm;
+
+  // Startup prefetch training: reads are recorded until the deadline
+  struct training_state {
+    std::chrono::steady_clock::time_point until;
+    prefetch_manifest ranges;
+    std::map<uint32_t, size_t> last;  // inode -> its last range
+  };
+  std::atomic<bool> training{false};
+  folly::Synchronized<training_state> s_training;
+
+  std::unique_ptr<tebako_disk_cache> disk_cache;
+  std::unique_ptr<tebako_shm_cache> shm_cache;
+  std::unique_ptr<tebako_chunk_cache> chunk_cache;
+
+  // Pinned files: decompressed content kept outside of the block cache
+  std::atomic<bool> has_pins{false};
+  std::atomic<size_t> pinned_bytes{0};
+  folly::Synchronized<std::map<uint32_t, std::shared_ptr<const std::vector<char>>>> s_pinned;
+
+  std::unique_ptr<tebako_cache_sizer> sizer;
+
+  std::atomic<bool> loaded{false};
+  std::atomic<bool> memory_pressure{false};
 
-  //  std::shared_ptr<dwarfs::performance_monitor> perfmon;
+  // Decompression workers started (lazy_workers): the reads made before all of them
+  // are started hold workers_mtx shared, so that no read is in flight when the
+  // worker group is replaced
+  std::atomic<size_t> workers_started{0};
+  std::atomic<int> lazy_reads{0};
+  std::shared_mutex workers_mtx;
+
+  // eager: content of all regular files, read-only once it is published
+  struct flat_image {
+    std::unique_ptr<char[]> data;
+    std::map<uint32_t, std::pair<size_t, size_t>> files;  // inode -> offset, size
+  };
+  std::unique_ptr<flat_image> flat;
+  std::atomic<const flat_image*> p_flat{nullptr};
+  std::thread eager_thread;
+  std::atomic<bool> eager_stopping{false};
+  // Bytes held by eager decompression (its block cache, then the arena)
+  std::atomic<size_t> eager_bytes{0};
+
+  // Streaming reads: filesystem_v2 created on the first one
+  std::mutex stream_mtx;
+  std::unique_ptr<dwarfs::filesystem_v2> stream_fs;
+  std::atomic<dwarfs::filesystem_v2*> p_stream{nullptr};
+  size_t reserved_stream_workers{0};
+
+  folly::Synchronized<memfs_cache_sizing> s_sizing;
 
  public:
   static void set_cachesize(const char* cachesize);
   static void set_debuglevel(const char* debuglevel);
   static void set_decompress_ratio(const char* decompress_ratio);
   static void set_lock_mode(const char* mlock);
+  static void set_perfmon(bool enable);
   static void set_workers(const char* workers);
 
   static dwarfs::stream_logger& logger();
   static memfs_options& options();
 
+  static void set_option(memfs_options& opts, const std::string& key, const std::string& value);
+  static memfs_options parse_options(const char* spec);
+  static void set_options(std::initializer_list<std::pair<const char*, const char*>> values);
+
   memfs(const void* dt, const unsigned int sz, uint32_t df_root = 0);
+  memfs(const void* dt, const unsigned int sz, const memfs_options& opts, uint32_t df_root = 0);
+  ~memfs();
+
+  const memfs_options& get_options(void) const { return mopts; }
+  // Cache size (block and chunk caches) and decompression workers actually granted
+  // (see sync_tebako_cache_budget and tebako_thread_pool)
+  size_t get_cache_size(void) const { return budget_share.load(std::memory_order_relaxed); }
+  size_t get_workers(void) const { return fsopts.block_cache.num_workers; }
+  size_t get_workers_started(void) const { return workers_started.load(std::memory_order_relaxed); }
+  size_t get_budget_share(void) const { return budget_share.load(std::memory_order_relaxed); }
+  int perfmon_summary(std::ostream& os) const noexcept;
+  const tebako_cache_counters& get_counters(void) const { return counters; }
+  int unlink_shm_cache(void) noexcept;
+  size_t get_pinned_bytes(void) const { return pinned_bytes.load(std::memory_order_relaxed); }
+  const tebako_chunk_cache* get_chunk_cache(void) const { return chunk_cache.get(); }
+  size_t get_chunk_cache_bytes(void) const;
+  uint64_t get_chunk_cache_evictions(void) const;
+  const tebako_cache_sizer* get_cache_sizer(void) const { return sizer.get(); }
+  memfs_cache_sizing get_cache_sizing(void) const { return *s_sizing.rlock(); }
+  void set_memory_pressure(bool pressure) noexcept;
+  // Applies the block and chunk cache tidy config for the idle trimmer and memory pressure state
+  void apply_cache_tidy(void) noexcept;
+  // Drops the chunk cache data not used for the tidy age (idle trimmer ticks)
+  size_t expire_chunk_cache(void) noexcept;
 
   int load(const char* image_offset = "auto");
   void set_image_offset_str(const char* image_offset = "auto");
@@ -84,14 +224,27 @@ class memfs {
 
   int access(const std::string& path, int amode, uid_t uid, gid_t gid, std::string& lnk) noexcept;
   int inode_access(uint32_t inode, int amode, uid_t uid, gid_t gid) noexcept;
-  ssize_t inode_read(uint32_t inode, void* buf, size_t size, off_t offset) noexcept;
+  ssize_t inode_read(uint32_t inode, void* buf, size_t size, off_t offset, bool stream = false) noexcept;
+  int inode_streamed(uint32_t inode, const struct stat* st) const noexcept;
   int inode_readdir(uint32_t inode,
                     tebako_dirent* cache,
                     off_t cache_start,
                     size_t buffer_size,
                     size_t& cache_size,
-                    size_t& dir_size) noexcept;
+                    size_t& dir_size,
+                    struct stat* stats) noexcept;
+#ifndef RB_W32
+  int inode_getdents(uint32_t inode, void* buf, size_t size, uint64_t& pos) noexcept;
+#endif
   int inode_readlink(uint32_t inode, std::string& lnk) noexcept;
+  int inode_walk(uint32_t inode, const walk_callback& fn, bool parallel) noexcept;
+  int inode_prefetch(uint32_t inode, uint64_t offset, uint64_t length, std::vector<char>& scratch) noexcept;
+  int inode_pin(uint32_t inode) noexcept;
+  int inode_unpin(uint32_t inode) noexcept;
+
+  void start_training(unsigned int seconds);
+  prefetch_manifest get_training(void);
+  int inode_glob(uint32_t inode, const glob_pattern& pattern, std::string& path, const glob_callback& fn) noexcept;
 
   int stat(const std::string& path, struct stat* st, std::string& lnk, bool follow) noexcept
   {
@@ -120,6 +273,19 @@ class memfs {
   int readlink(const std::string& path, std::string& link, std::string& lnk) noexcept;
 
  private:
+  void release_budget(void);
+  void apply_budget_share(void) noexcept;
+  std::chrono::milliseconds cache_max_age(void) const;
+  void record_read(uint32_t inode, uint64_t offset, size_t length) noexcept;
+  int chunk_cache_read(uint32_t inode, char* buf, size_t size, off_t offset, bool prefetch = false);
+  int fs_read(uint32_t inode, char* buf, size_t size, off_t offset);
+  const char* flat_content(uint32_t inode, size_t& length) const noexcept;
+  void decompress_all(void);
+  void stop_eager(void);
+  int stream_read(uint32_t inode, char* buf, size_t size, off_t offset);
+  void start_workers(size_t count);
+  std::shared_ptr<const std::vector<char>> get_pinned(uint32_t inode);
+  void evaluate_cache_size(void);
   int i_access(int amode, struct stat* st);
 
   int dwarfs_file_stat(dwarfs::inode_view& inode, struct stat* st);
@@ -144,6 +310,25 @@ class memfs {
                     stdfs::path& p_path);
   int process_link(std::string& lnk, stdfs::path::iterator& p_iterator, stdfs::path& p_path);
 
+  typedef std::vector<std::pair<dwarfs::inode_view, std::string>> walk_subtrees;
+  int walk_dir(dwarfs::inode_view& dir_inode,
+               std::string& path,
+               int level,
+               const walk_callback& fn,
+               const std::atomic<int>* stop,
+               walk_subtrees* deferred);
+
+  int glob_dir(dwarfs::inode_view& dir_inode,
+               const glob_pattern& pattern,
+               size_t index,
+               std::string& path,
+               const glob_callback& fn);
+  int glob_entry(dwarfs::inode_view& entry,
+                 const glob_pattern& pattern,
+                 size_t index,
+                 std::string& path,
+                 const glob_callback& fn);
+
   template <typename Functor, class... Args>
   int safe_dwarfs_call(Functor&& fn, const char* caller, uint32_t inode, Args&&... args);
 };
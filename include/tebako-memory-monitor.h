@@ -0,0 +1,105 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+namespace tebako {
+
+// tebako_memory_monitor
+// Watches cgroup v2 memory accounting of the process (memory.current against
+// memory.high, or memory.max if there is no high limit) and PSI memory pressure
+// (memory.pressure, "some" avg10) on a background thread
+//
+// When the usage reaches high_watermark of the limit or PSI reaches psi_threshold,
+// all mounted memfs shed their block caches (see memfs::set_memory_pressure);
+// when the usage falls below low_watermark and PSI below half of the threshold,
+// the caches are allowed to regrow. Each transition to pressure is a shrink event
+//
+// The cgroup directory is a parameter, so that a fake one can be used in tests
+
+class tebako_memory_monitor {
+ public:
+  static constexpr double high_watermark = 0.9;
+  static constexpr double low_watermark = 0.8;
+  static constexpr double psi_threshold = 10.0;
+
+  struct sample {
+    bool valid{false};
+    uint64_t current{0};
+    uint64_t limit{0};  // 0 - no limit
+    double psi_some_avg10{0};
+  };
+
+  struct stats {
+    bool enabled{false};
+    bool under_pressure{false};
+    uint64_t checks{0};
+    uint64_t shrink_events{0};
+    sample last;
+  };
+
+  static tebako_memory_monitor& get_tebako_memory_monitor(void);
+  // cgroup v2 directory of the process (/sys/fs/cgroup/<path from /proc/self/cgroup>)
+  static std::string detect_cgroup_dir(void);
+  static sample read_sample(const std::string& dir);
+
+  ~tebako_memory_monitor();
+
+  // Starts watching dir every interval; restarts the watch if it is running
+  void start(const std::string& dir, std::chrono::milliseconds interval);
+  void stop(void);
+  // Checks the pressure once; returns true if the state has changed
+  bool check(void);
+
+  bool is_under_pressure(void) const { return under_pressure.load(std::memory_order_relaxed); }
+  stats get_stats(void);
+
+ private:
+  tebako_memory_monitor() = default;
+  void run(void);
+
+  std::mutex mtx;
+  std::mutex check_mtx;
+  std::condition_variable cv;
+  std::thread thread;
+  std::string dir;
+  std::chrono::milliseconds interval{1000};
+  bool stopping{false};
+
+  std::atomic<bool> under_pressure{false};
+  uint64_t checks{0};
+  uint64_t shrink_events{0};
+  sample last;
+};
+
+}  // namespace tebako
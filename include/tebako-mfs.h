@@ -31,14 +31,44 @@
 
 #include <cstddef>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "dwarfs/mmif.h"
 
+#include <tebako-cache-stats.h>
+
 namespace tebako {
 
+// mfs
+// dwarfs::mmif over the image embedded into the executable
+//
+// The image is not mapped by mfs, so the page management is done by madvise hints
+// over the sections found through the image section index:
+// - metadata sections are prefetched (MADV_WILLNEED) when the image is mounted
+// - blocks are mostly decompressed in the image order, so the block following the
+//   one just decompressed is prefetched (MADV_WILLNEED); the block area gets no
+//   access pattern advice, random reads would suffer from it, and advice per block
+//   would split the mapping of the image into as many
+// - compressed pages of a decompressed block are deactivated (MADV_COLD) when the
+//   block cache releases them, that is unless cache_image is set; if MADV_COLD is
+//   not supported they are dropped (MADV_DONTNEED) from file backed mappings only,
+//   anonymous ones would lose the data
+// The mapping type is found through /proc/self/maps by the mfs that gives hints;
+// other views of the same image (another filesystem_v2 over it) reuse it
+//
+// use_huge_pages remaps the metadata of a file backed image onto transparent huge
+// pages: the image in the executable is mapped with small pages, and dwarfs
+// metadata lookups are random accesses over all of it
+
 class mfs : public dwarfs::mmif {
  public:
-  mfs(const void* addr, size_t size);
+  // [offset, offset + size) in the image
+  using range = std::pair<size_t, size_t>;
+
+  mfs(const void* addr, size_t size, tebako_cache_counters* counters = nullptr, bool advise = true);
+  // Another view of the image of mm: the sections and the mapping type are not searched again
+  mfs(const mfs& mm, tebako_cache_counters* counters, bool advise);
   ~mfs() = default;
 
   void const* addr() const override;
@@ -50,10 +80,33 @@ class mfs : public dwarfs::mmif {
 
   std::filesystem::path const& path() const override;
 
+  // dwarfs section_header_v2; it carries the checksums of the section data
+  static constexpr size_t section_header_size = 64;
+
+  // Sections found through the section index (headers included); empty if there is no index
+  const range& metadata() const { return metadata_; }
+  const std::vector<range>& blocks() const { return blocks_; }
+  // Known if the mfs gives hints (false otherwise)
+  bool is_file_backed() const { return file_backed_; }
+
+  static const size_t huge_page_size = static_cast<size_t>(2) << 20;
+  // Replaces the huge pages entirely within the metadata with anonymous read-only
+  // huge pages holding the same data; returns the number of bytes remapped
+  size_t use_huge_pages(void);
+
  private:
+  void find_sections(void);
+  void advise_range(size_t offset, size_t size, int advice) const;
+  void advise_released(size_t offset, size_t size) const;
+
   size_t size_;
   const void* addr_;
   off_t const page_size_;
+  tebako_cache_counters* counters_;
+  bool advise_;
+  bool file_backed_{false};
+  range metadata_{0, 0};
+  std::vector<range> blocks_;
 };
 
 }  // namespace tebako
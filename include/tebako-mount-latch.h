@@ -0,0 +1,86 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace tebako {
+
+// tebako_mount_latch
+// Ready latch of the asynchronous root memfs mount (mount_root_memfs_async)
+//
+// The mount runs on a background thread; memfs lookups (sync_tebako_memfs_table)
+// and the current directory wait for it to complete, so the first tebako_* call
+// that needs memfs blocks until the filesystem is ready. The calls made by the
+// mounting thread itself do not wait
+// The result and errno of the mount are kept, so a failed mount is reported the
+// same way by every wait
+
+class tebako_mount_latch {
+ public:
+  static tebako_mount_latch& get_tebako_mount_latch(void);
+
+  ~tebako_mount_latch();
+
+  // Runs mount on a background thread; waits for the previous one first
+  // Concurrent calls are serialized, each of them waits for the mount started before
+  void start(std::function<int(void)> mount);
+  // Waits for the pending mount; returns its result (0 or -1 with errno set)
+  int wait(void);
+  bool is_pending(void) const { return pending.load(std::memory_order_acquire); }
+
+ private:
+  tebako_mount_latch() = default;
+  void join(void);
+
+  // Held by start across wait, join and the thread assignment
+  std::mutex start_mtx;
+  std::mutex mtx;
+  std::condition_variable cv;
+  std::thread thread;
+  std::atomic<bool> pending{false};
+  int result{0};
+  int error{0};
+};
+
+// Waits for the asynchronous root memfs mount if there is one in progress
+inline void wait_for_mount(void)
+{
+  auto& latch = tebako_mount_latch::get_tebako_mount_latch();
+  if (latch.is_pending()) {
+    latch.wait();
+  }
+}
+
+}  // namespace tebako
@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <optional>
 #include <string>
 #include <cstring>
@@ -38,6 +39,21 @@
 
 namespace tebako {
 
+// A range of file data read at startup; inode is relative to the memfs root
+// (dwarfs inode number), so the manifest is valid for the image it was recorded on
+struct prefetch_range {
+  uint32_t inode;
+  uint64_t offset;
+  uint32_t length;
+
+  bool operator==(const prefetch_range& other) const
+  {
+    return inode == other.inode && offset == other.offset && length == other.length;
+  }
+};
+
+using prefetch_manifest = std::vector<prefetch_range>;
+
 class package_descriptor {
  private:
   uint16_t ruby_version_major;
@@ -49,6 +65,8 @@ class package_descriptor {
   std::string mount_point;
   std::string entry_point;
   std::optional<std::string> cwd;
+  std::optional<prefetch_manifest> manifest;
+  std::optional<std::vector<std::string>> pin_list;
 
  public:
   // Deleted default constructor
@@ -61,7 +79,8 @@ class package_descriptor {
                      const std::string& tebako_version,
                      const std::string& mount_point,
                      const std::string& entry_point,
-                     const std::optional<std::string>& cwd);
+                     const std::optional<std::string>& cwd,
+                     const std::optional<prefetch_manifest>& manifest = std::nullopt);
   // Serialize the object to a binary format
   std::vector<char> serialize() const;
 
@@ -74,6 +93,16 @@ class package_descriptor {
   const std::string& get_mount_point() const { return mount_point; }
   const std::string& get_entry_point() const { return entry_point; }
   const std::optional<std::string>& get_cwd() const { return cwd; }
+  const std::optional<prefetch_manifest>& get_prefetch_manifest() const { return manifest; }
+  void set_prefetch_manifest(const std::optional<prefetch_manifest>& m) { manifest = m; }
+  // Files pinned at startup (tebako_pin), paths are relative to the mount point
+  const std::optional<std::vector<std::string>>& get_pin_list() const { return pin_list; }
+  void set_pin_list(const std::optional<std::vector<std::string>>& p) { pin_list = p; }
+
+  // Startup prefetch manifest alone, as it is recorded by the training run
+  // (tebako_prefetch_record_save) and stored in the optional descriptor section
+  static std::vector<char> serialize_manifest(const prefetch_manifest& m);
+  static prefetch_manifest deserialize_manifest(const std::vector<char>& buffer);
 
   static bool is_little_endian()
   {
@@ -102,6 +131,8 @@ class package_descriptor {
   }
 
   static const char* signature;
+  static const char* manifest_signature;
+  static const char* pin_list_signature;
 };
 
 }  // namespace tebako
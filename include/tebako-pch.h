@@ -74,4 +74,7 @@ typedef SSIZE_T ssize_t;
 #include <sys/uio.h>
 #include <sys/file.h>
 #include <ftw.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 #endif
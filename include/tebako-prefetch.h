@@ -0,0 +1,114 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include <tebako-package-descriptor.h>
+
+namespace tebako {
+
+// prefetch_job
+// Reads a list of ranges on the background queue of the shared thread pool, so
+// that the blocks they cover are decompressed into the block cache ahead of
+// demand. Ranges refer to global inode numbers (memfs index in the upper bits),
+// so a job may span several memfs; ranges of a memfs that has been unmounted
+// are skipped. The job stops when it is cancelled or when the pool is stopped
+//
+// The list is either known upfront (startup manifest) or built by a collector
+// that runs as the first background task (tebako_prefetch, tebako_prefetch_glob),
+// so that starting a job does not wait for directory walks
+
+class prefetch_job {
+ public:
+  typedef std::function<void(prefetch_job& job)> collector;
+
+  prefetch_job() = default;
+
+  // Submit n_tasks background tasks (0 - one per pool thread)
+  static std::shared_ptr<prefetch_job> start(prefetch_manifest ranges, size_t n_tasks = 0);
+  static std::shared_ptr<prefetch_job> start(collector collect, size_t n_tasks = 0);
+
+  // To be called by the collector only
+  void add(uint32_t inode, uint64_t offset, uint64_t length);
+
+  void cancel(void) { cancelled = true; }
+  bool is_cancelled(void) const { return cancelled.load(); }
+  bool is_done(void);
+  void wait(void);
+
+  size_t get_total(void) const { return total.load(); }
+  size_t get_completed(void) const { return completed.load(); }
+
+ private:
+  void fan_out(const std::shared_ptr<prefetch_job>& self, size_t n_tasks);
+  void run(void);
+  void task_done(void);
+
+  prefetch_manifest ranges;
+  std::atomic<size_t> total{0};
+  std::atomic<size_t> next{0};
+  std::atomic<size_t> completed{0};
+  std::atomic<bool> cancelled{false};
+
+  std::mutex mtx;
+  std::condition_variable cv;
+  size_t running{0};
+};
+
+// sync_tebako_prefetch_table
+// Handles of the prefetch jobs started by the C API
+// Finished jobs are dropped when new ones are added; waiting for or cancelling
+// a handle that has been dropped succeeds
+
+class sync_tebako_prefetch_table {
+ private:
+  struct prefetch_table {
+    int next_handle{1};
+    std::map<int, std::shared_ptr<prefetch_job>> jobs;
+  };
+  folly::Synchronized<prefetch_table> s_table;
+
+ public:
+  static sync_tebako_prefetch_table& get_tebako_prefetch_table(void);
+
+  int insert(std::shared_ptr<prefetch_job> job);
+  // returns nullptr and sets found to false for the handles that were never issued
+  std::shared_ptr<prefetch_job> get(int handle, bool& found);
+  void erase(int handle);
+  void cancel_all(void);
+};
+
+}  // namespace tebako
@@ -0,0 +1,124 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+namespace tebako {
+
+// tebako_shm_cache
+// Decompressed file content shared by the processes that run the same package
+// (prefork workers would otherwise decompress and cache the same data N times)
+//
+// The cache uses the chunk keys of tebako_disk_cache (image identity, root-relative
+// inode, chunk number) and lives in a POSIX shared memory segment named after the
+// image identity. The first process creates the segment and fixes its capacity,
+// so max_bytes of the creator is the global size cap; others attach to it.
+// Only a segment owned by the effective user and not writable by group or others
+// is attached. The header counts the attached processes; the last one to detach
+// unlinks the segment (a process killed without unmounting leaves its count, and
+// the segment stays until tebako_unlink_shm_cache or reboot).
+//
+// The index is an open-addressed table of slots, one chunk per slot. Each slot is
+// a seqlock: a writer claims it by moving the sequence to an odd value with CAS and
+// publishes the data with the next even value; readers copy the data and retry the
+// lookup as a miss if the sequence has changed. A slot left odd by a crashed writer
+// is reclaimed once its pid is gone. Eviction picks the least recently used slot
+// within the probe window.
+
+class tebako_shm_cache {
+ public:
+  static const uint32_t format_version = 2;
+  static const size_t chunk_size = static_cast<size_t>(256) << 10;
+  static constexpr size_t max_probe = 16;
+
+  tebako_shm_cache(uint64_t max_bytes, uint64_t identity);
+  ~tebako_shm_cache();
+  tebako_shm_cache(const tebako_shm_cache&) = delete;
+  tebako_shm_cache& operator=(const tebako_shm_cache&) = delete;
+
+  // Copies up to size bytes of the chunk starting at in_chunk to buf;
+  // length is set to the length of the chunk
+  bool get(uint32_t inode, uint64_t chunk, size_t in_chunk, char* buf, size_t size, size_t& length) noexcept;
+  void put(uint32_t inode, uint64_t chunk, const char* data, size_t length) noexcept;
+
+  size_t get_slot_count(void) const { return slot_count; }
+  bool is_creator(void) const { return creator; }
+  uint64_t get_identity(void) const { return identity; }
+  const std::string& get_name(void) const { return name; }
+
+  static std::string segment_name(uint64_t identity);
+  // Removes the segment name; processes that are attached keep using it
+  static int unlink(uint64_t identity) noexcept;
+
+ private:
+  struct segment_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t slot_count;
+    uint64_t identity;
+    uint64_t chunk_size;
+    std::atomic<int32_t> creator_pid;
+    std::atomic<uint32_t> ready;
+    std::atomic<uint32_t> attached;
+    std::atomic<uint64_t> clock;
+  };
+
+  struct slot {
+    std::atomic<uint64_t> seq;  // odd while the slot is written
+    std::atomic<uint64_t> key;  // 0 - empty
+    std::atomic<uint64_t> tick;
+    std::atomic<uint32_t> length;
+    std::atomic<int32_t> writer;
+  };
+
+  static const char magic[8];
+  static size_t data_offset(size_t slot_count);
+  static uint64_t make_key(uint32_t inode, uint64_t chunk);
+  static bool is_alive(int32_t pid);
+
+  bool create(size_t count);
+  bool attach(void);
+  void map(int fd, size_t size);
+  char* chunk_data(size_t index) const
+  {
+    return static_cast<char*>(addr) + data_offset(slot_count) + index * chunk_size;
+  }
+
+  uint64_t identity;
+  std::string name;
+  void* addr{nullptr};
+  size_t mapped{0};
+  ino_t segment_ino{0};
+  size_t slot_count{0};
+  bool creator{false};
+  segment_header* header{nullptr};
+  slot* slots{nullptr};
+};
+
+}  // namespace tebako
@@ -0,0 +1,110 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace tebako {
+
+// tebako_thread_pool
+// One process-wide pool for the background work of all memfs instances
+// (parallel walks, prefetch)
+// Threads are started on the first submit, the pool size follows the CPU quota
+// of the process (affinity mask and cgroup cpu.max)
+// Background (low priority) tasks run only when there is no regular task queued
+// and are dropped when the pool is stopped
+//
+// dwarfs block cache keeps its own decompression worker group per filesystem_v2,
+// so the pool does not run decompression itself, it only caps it: memfs reserves
+// workers on load out of the CPU quota less one slot; a memfs granted none runs
+// a single dwarfs worker and makes its reads in the last slot, shared by all such
+// memfs, so that the decompression in flight does not exceed the quota whatever
+// the number of mounts
+
+class tebako_thread_pool {
+ public:
+  struct stats {
+    size_t threads{0};
+    size_t busy{0};
+    size_t queue_depth{0};
+    size_t background_depth{0};
+    uint64_t tasks_completed{0};
+    uint64_t busy_time_ns{0};
+    size_t decompression_workers{0};
+    size_t cpu_quota{0};
+  };
+
+  static tebako_thread_pool& get_tebako_thread_pool(void);
+  static size_t detect_cpu_quota(void);
+
+  ~tebako_thread_pool();
+
+  void submit(std::function<void()> task);
+  void submit_background(std::function<void()> task);
+  // Runs worker on the calling thread and on up to n_helpers pool threads,
+  // returns when all of them are done; worker shall share the work itself
+  // (e.g. through an atomic index)
+  void parallel_run(size_t n_helpers, const std::function<void()>& worker);
+
+  size_t reserve_workers(size_t requested);
+  void release_workers(size_t reserved);
+  // Holds the shared decompression slot for a read of a memfs that was granted
+  // no workers (reserved == 0), returns an empty lock otherwise
+  std::unique_lock<std::mutex> share_worker(size_t reserved);
+
+  size_t get_size(void) const { return size; }
+  // Long-running tasks shall check it and return early
+  bool is_stopping(void) const { return stopping.load(); }
+  stats get_stats(void);
+
+ private:
+  tebako_thread_pool();
+  void start(void);
+  void run(void);
+
+  size_t size;
+  std::mutex mtx;
+  std::condition_variable cv;
+  std::deque<std::function<void()>> queue;
+  std::deque<std::function<void()>> background;
+  std::vector<std::thread> threads;
+  std::atomic<bool> stopping{false};
+
+  size_t busy{0};
+  uint64_t tasks_completed{0};
+  uint64_t busy_time_ns{0};
+  size_t workers_reserved{0};
+  std::mutex shared_worker_mtx;
+};
+
+}  // namespace tebako
@@ -33,6 +33,8 @@
 #include <tebako-dirent.h>
 #include <tebako-io.h>
 #include <tebako-io-inner.h>
+#include <tebako-glob.h>
+#include <tebako-prefetch.h>
 #include <tebako-io-rb-w32-inner.h>
 #include <tebako-io-root.h>
 #include <tebako-fd.h>
@@ -155,6 +157,115 @@ struct dirent* tebako_readdir(DIR* dirp)
 }
 #endif
 
+#if defined(TEBAKO_HAS_READDIR) && !defined(RB_W32)
+struct dirent* tebako_readdir_plus(DIR* dirp, struct stat* st)
+{
+  if (st == NULL) {
+    return tebako_readdir(dirp);
+  }
+
+  struct dirent* entry = NULL;
+  tebako_dirent* e = NULL;
+  uintptr_t uip = reinterpret_cast<uintptr_t>(dirp);
+  int ret = sync_tebako_dstable::get_tebako_dstable().readdir(uip, e, st);
+  if (ret == DWARFS_INVALID_FD) {
+    if (!sync_tebako_kfdtable::get_tebako_kfdtable().check(uip)) {
+      TEBAKO_SET_LAST_ERROR(EBADF);
+    }
+    else {
+#if defined(TEBAKO_HAS_FSTATAT) && defined(TEBAKO_HAS_DIRFD)
+      // An entry that cannot be stat'ed (removed meanwhile, no permission) is still
+      // returned, with st zeroed
+      int err = errno;
+      entry = ::readdir(dirp);
+      if (entry != NULL && ::fstatat(::dirfd(dirp), entry->d_name, st, AT_SYMLINK_NOFOLLOW) != 0) {
+        memset(st, 0, sizeof(*st));
+        errno = err;
+      }
+#else
+      TEBAKO_SET_LAST_ERROR(ENOTSUP);
+#endif
+    }
+  }
+  else {
+    entry = e ? &e->e : nullptr;
+  }
+  return entry;
+}
+
+#if defined(TEBAKO_HAS_OPENDIR) && defined(TEBAKO_HAS_CLOSEDIR)
+typedef int (*qsort_compar_plus)(const void*, const void*);
+
+// tebako_scandir_plus
+//  The namelist and the records are allocated as a single block:
+//  [n pointers][n records]
+//  It shall be released with tebako_scandir_plus_free (or free(namelist))
+int tebako_scandir_plus(const char* dirname,
+                        struct tebako_dirent_plus*** namelist,
+                        int (*sel)(const struct tebako_dirent_plus*),
+                        int (*compar)(const struct tebako_dirent_plus**, const struct tebako_dirent_plus**))
+{
+  int ret = DWARFS_IO_ERROR;
+  if (namelist == NULL) {
+    TEBAKO_SET_LAST_ERROR(EFAULT);
+    return ret;
+  }
+
+  DIR* dirp = tebako_opendir(dirname);
+  if (dirp != NULL) {
+    std::vector<tebako_dirent_plus> list;
+    bool ok = true;
+    try {
+      tebako_dirent_plus rec;
+      struct dirent* ent = NULL;
+      while ((ent = tebako_readdir_plus(dirp, &rec.d_stat)) != NULL) {
+        memcpy((void*)&rec.d_ent, (void*)ent, offsetof(struct dirent, d_name));
+        strncpy(rec.d_ent.d_name, ent->d_name, sizeof(rec.d_ent.d_name) - 1);
+        rec.d_ent.d_name[sizeof(rec.d_ent.d_name) - 1] = '\0';
+        rec.d_ent.d_reclen = sizeof(struct dirent);
+        if (!sel || sel(&rec)) {
+          list.push_back(rec);
+        }
+      }
+    }
+    catch (...) {
+      ok = false;
+    }
+    tebako_closedir(dirp);
+
+    size_t n = list.size();
+    size_t header = (std::max(n, size_t(1)) * sizeof(tebako_dirent_plus*) + alignof(tebako_dirent_plus) - 1) &
+                    ~(alignof(tebako_dirent_plus) - 1);
+    char* block = ok ? (char*)malloc(header + n * sizeof(tebako_dirent_plus)) : NULL;
+    if (block == NULL) {
+      TEBAKO_SET_LAST_ERROR(ENOMEM);
+    }
+    else {
+      tebako_dirent_plus** result = reinterpret_cast<tebako_dirent_plus**>(block);
+      tebako_dirent_plus* records = reinterpret_cast<tebako_dirent_plus*>(block + header);
+      if (n > 0) {
+        memcpy((void*)records, (void*)list.data(), n * sizeof(tebako_dirent_plus));
+      }
+      for (size_t i = 0; i < n; ++i) {
+        result[i] = &records[i];
+      }
+      if (compar && n > 1) {
+        qsort((void*)result, n, sizeof(tebako_dirent_plus*), (qsort_compar_plus)compar);
+      }
+      *namelist = result;
+      ret = static_cast<int>(n);
+    }
+  }
+  return ret;
+}
+
+void tebako_scandir_plus_free(struct tebako_dirent_plus** namelist)
+{
+  free(namelist);
+}
+#endif
+#endif
+
 #if defined(TEBAKO_HAS_TELLDIR) || defined(RB_W32)
 long tebako_telldir(DIR* dirp)
 {
@@ -210,6 +321,326 @@ int tebako_dirfd(DIR* dirp)
 }
 #endif
 
+int tebako_walk(const char* path, tebako_walk_fn fn, int flags, void* ctx)
+{
+  int ret = DWARFS_IO_ERROR;
+  if (path == NULL) {
+    TEBAKO_SET_LAST_ERROR(ENOENT);
+  }
+  else if (fn == NULL) {
+    TEBAKO_SET_LAST_ERROR(EINVAL);
+  }
+  else {
+    tebako_path_t t_path;
+    const char* p_path = to_tebako_path(t_path, path);
+    if (p_path) {
+      std::string lnk;
+      struct stat st;
+      ret = dwarfs_stat(p_path, &st, lnk, true);
+      if (ret == DWARFS_IO_CONTINUE) {
+        ret = dwarfs_inode_walk(
+            st.st_ino,
+            [fn, ctx](const std::string& p, const struct stat* s, int level) { return fn(p.c_str(), s, level, ctx); },
+            (flags & TEBAKO_WALK_PARALLEL) != 0);
+      }
+      else if (ret == DWARFS_S_LINK_OUTSIDE) {
+        ret = DWARFS_IO_ERROR;
+        TEBAKO_SET_LAST_ERROR(EXDEV);
+      }
+    }
+    else {
+      // [EXDEV] The walker works over memfs metadata only
+      TEBAKO_SET_LAST_ERROR(EXDEV);
+    }
+  }
+  return ret;
+}
+
+int tebako_glob(const char* pattern, int flags, tebako_glob_fn fn, void* ctx)
+{
+  int ret = DWARFS_IO_ERROR;
+  if (pattern == NULL) {
+    TEBAKO_SET_LAST_ERROR(ENOENT);
+  }
+  else if (fn == NULL) {
+    TEBAKO_SET_LAST_ERROR(EINVAL);
+  }
+  else {
+    try {
+      auto callback = [fn, ctx](const std::string& p, const struct stat* s) { return fn(p.c_str(), s, ctx); };
+      ret = 0;
+      for (const auto& ptrn : glob_pattern::compile(pattern, flags)) {
+        std::string path = ptrn.get_prefix();
+        if (path.empty() && ptrn.get_segments().empty()) {
+          continue;
+        }
+        tebako_path_t t_path;
+        const char* p_path = to_tebako_path(t_path, path.empty() ? "." : path.c_str());
+        if (!p_path) {
+          // [EXDEV] The glob works over memfs metadata only
+          ret = DWARFS_IO_ERROR;
+          TEBAKO_SET_LAST_ERROR(EXDEV);
+          break;
+        }
+
+        std::string lnk;
+        struct stat st;
+        if (ptrn.get_segments().empty()) {
+          // No wildcards, just check that the path exists
+          if (dwarfs_stat(p_path, &st, lnk, false) == DWARFS_IO_CONTINUE &&
+              (!ptrn.dirs_only() || S_ISDIR(st.st_mode))) {
+            if (ptrn.dirs_only() && path.back() != '/') {
+              path.push_back('/');
+            }
+            ret = callback(path, &st);
+          }
+        }
+        else {
+          int r = dwarfs_stat(p_path, &st, lnk, true);
+          if (r == DWARFS_IO_CONTINUE && S_ISDIR(st.st_mode)) {
+            ret = dwarfs_inode_glob(st.st_ino, ptrn, path, callback);
+          }
+          else if (r == DWARFS_S_LINK_OUTSIDE) {
+            ret = DWARFS_IO_ERROR;
+            TEBAKO_SET_LAST_ERROR(EXDEV);
+          }
+        }
+        if (ret != 0) {
+          break;
+        }
+      }
+    }
+    catch (...) {
+      ret = DWARFS_IO_ERROR;
+      TEBAKO_SET_LAST_ERROR(ENOMEM);
+    }
+  }
+  return ret;
+}
+
+int tebako_prefetch(const char* path, int flags)
+{
+  int ret = DWARFS_IO_ERROR;
+  if (path == NULL) {
+    TEBAKO_SET_LAST_ERROR(ENOENT);
+    return ret;
+  }
+
+  tebako_path_t t_path;
+  const char* p_path = to_tebako_path(t_path, path);
+  if (!p_path) {
+    // [EXDEV] Prefetch works over memfs only
+    TEBAKO_SET_LAST_ERROR(EXDEV);
+    return ret;
+  }
+
+  std::string lnk;
+  struct stat st;
+  int r = dwarfs_stat(p_path, &st, lnk, true);
+  if (r == DWARFS_S_LINK_OUTSIDE) {
+    TEBAKO_SET_LAST_ERROR(EXDEV);
+  }
+  else if (r == DWARFS_IO_CONTINUE) {
+    try {
+      bool recurse = (flags & TEBAKO_PREFETCH_NORECURSE) == 0;
+      auto job = prefetch_job::start([st, recurse](prefetch_job& job) {
+        if (S_ISREG(st.st_mode)) {
+          job.add(st.st_ino, 0, st.st_size);
+        }
+        else if (S_ISDIR(st.st_mode)) {
+          dwarfs_inode_walk(
+              st.st_ino,
+              [&job, recurse](const std::string&, const struct stat* s, int) {
+                if (job.is_cancelled()) {
+                  return -1;
+                }
+                if (S_ISREG(s->st_mode)) {
+                  job.add(s->st_ino, 0, s->st_size);
+                }
+                return (S_ISDIR(s->st_mode) && !recurse) ? TEBAKO_WALK_PRUNE : TEBAKO_WALK_CONTINUE;
+              },
+              false);
+        }
+      });
+      ret = sync_tebako_prefetch_table::get_tebako_prefetch_table().insert(job);
+    }
+    catch (...) {
+      TEBAKO_SET_LAST_ERROR(ENOMEM);
+    }
+  }
+  return ret;
+}
+
+int tebako_prefetch_glob(const char* pattern, int flags)
+{
+  int ret = DWARFS_IO_ERROR;
+  if (pattern == NULL) {
+    TEBAKO_SET_LAST_ERROR(ENOENT);
+    return ret;
+  }
+
+  try {
+    std::string ptrn{pattern};
+    // Check upfront that the pattern is not outside of memfs
+    for (const auto& p : glob_pattern::compile(pattern, flags)) {
+      tebako_path_t t_path;
+      if (!to_tebako_path(t_path, p.get_prefix().empty() ? "." : p.get_prefix().c_str())) {
+        TEBAKO_SET_LAST_ERROR(EXDEV);
+        return ret;
+      }
+    }
+    auto job = prefetch_job::start([ptrn, flags](prefetch_job& job) {
+      tebako_glob(
+          ptrn.c_str(), flags,
+          [](const char*, const struct stat* s, void* ctx) {
+            auto job = static_cast<prefetch_job*>(ctx);
+            if (job->is_cancelled()) {
+              return -1;
+            }
+            if (S_ISREG(s->st_mode)) {
+              job->add(s->st_ino, 0, s->st_size);
+            }
+            return 0;
+          },
+          &job);
+    });
+    ret = sync_tebako_prefetch_table::get_tebako_prefetch_table().insert(job);
+  }
+  catch (...) {
+    TEBAKO_SET_LAST_ERROR(ENOMEM);
+  }
+  return ret;
+}
+
+// Finds the prefetch job by handle
+// returns
+//  DWARFS_IO_CONTINUE - success [job is set, or nullptr if it has completed and was dropped]
+//  DWARFS_IO_ERROR - the handle has not been issued [errno is set]
+static int get_prefetch_job(int handle, std::shared_ptr<prefetch_job>& job)
+{
+  bool found = false;
+  job = sync_tebako_prefetch_table::get_tebako_prefetch_table().get(handle, found);
+  if (!found) {
+    TEBAKO_SET_LAST_ERROR(EINVAL);
+    return DWARFS_IO_ERROR;
+  }
+  return DWARFS_IO_CONTINUE;
+}
+
+int tebako_prefetch_wait(int handle)
+{
+  std::shared_ptr<prefetch_job> job;
+  int ret = get_prefetch_job(handle, job);
+  if (job != nullptr) {
+    job->wait();
+    sync_tebako_prefetch_table::get_tebako_prefetch_table().erase(handle);
+  }
+  return ret;
+}
+
+int tebako_prefetch_cancel(int handle)
+{
+  std::shared_ptr<prefetch_job> job;
+  int ret = get_prefetch_job(handle, job);
+  if (job != nullptr) {
+    job->cancel();
+    sync_tebako_prefetch_table::get_tebako_prefetch_table().erase(handle);
+  }
+  return ret;
+}
+
+int tebako_prefetch_done(int handle)
+{
+  std::shared_ptr<prefetch_job> job;
+  int ret = get_prefetch_job(handle, job);
+  if (ret == DWARFS_IO_CONTINUE) {
+    ret = (job == nullptr || job->is_done()) ? 1 : 0;
+  }
+  return ret;
+}
+
+// Pins or unpins a memfs file or the files of a directory subtree
+static int pin_path(const char* path, bool pin)
+{
+  int ret = DWARFS_IO_ERROR;
+  if (path == NULL) {
+    TEBAKO_SET_LAST_ERROR(ENOENT);
+    return ret;
+  }
+
+  tebako_path_t t_path;
+  const char* p_path = to_tebako_path(t_path, path);
+  if (!p_path) {
+    // [EXDEV] Pinning works over memfs only
+    TEBAKO_SET_LAST_ERROR(EXDEV);
+    return ret;
+  }
+
+  std::string lnk;
+  struct stat st;
+  int r = dwarfs_stat(p_path, &st, lnk, true);
+  if (r == DWARFS_S_LINK_OUTSIDE) {
+    TEBAKO_SET_LAST_ERROR(EXDEV);
+  }
+  else if (r == DWARFS_IO_CONTINUE) {
+    if (S_ISDIR(st.st_mode)) {
+      // Files of a directory that are not pinned are skipped by unpin
+      int err = 0;
+      ret = dwarfs_inode_walk(
+          st.st_ino,
+          [pin, &err](const std::string&, const struct stat* s, int) {
+            if (S_ISREG(s->st_mode) && dwarfs_inode_pin(s->st_ino, pin) != DWARFS_IO_CONTINUE &&
+                (pin || errno != ENOENT)) {
+              err = errno;
+              return -1;
+            }
+            return TEBAKO_WALK_CONTINUE;
+          },
+          false);
+      if (err != 0) {
+        TEBAKO_SET_LAST_ERROR(err);
+        ret = DWARFS_IO_ERROR;
+      }
+    }
+    else {
+      ret = dwarfs_inode_pin(st.st_ino, pin);
+    }
+  }
+  return ret;
+}
+
+int tebako_pin(const char* path)
+{
+  return pin_path(path, true);
+}
+
+int tebako_unpin(const char* path)
+{
+  return pin_path(path, false);
+}
+
+#ifndef RB_W32
+ssize_t tebako_getdents(int vfd, void* buf, size_t nbyte)
+{
+  ssize_t ret = DWARFS_IO_ERROR;
+  if (buf == NULL) {
+    TEBAKO_SET_LAST_ERROR(EFAULT);
+  }
+  else {
+    ret = sync_tebako_fdtable::get_tebako_fdtable().getdents(vfd, buf, nbyte);
+    if (ret == DWARFS_INVALID_FD) {
+#if defined(__linux__) && defined(SYS_getdents64)
+      ret = ::syscall(SYS_getdents64, vfd, buf, nbyte);
+#else
+      ret = DWARFS_IO_ERROR;
+      TEBAKO_SET_LAST_ERROR(EBADF);
+#endif
+    }
+  }
+  return ret;
+}
+#endif
+
 #ifdef TEBAKO_HAS_SCANDIR
 typedef int (*qsort_compar)(const void*, const void*);
 
@@ -220,6 +651,42 @@ static struct dirent* internal_readdir(DIR* dirp)
   return entry ? &entry->e : nullptr;
 }
 
+// Memfs dirents are cached with the full tebako_path_t name buffer
+// Only the used part of it is copied, d_reclen is set accordingly
+static struct dirent* copy_dirent(const struct dirent* ent)
+{
+  size_t size = offsetof(struct dirent, d_name) + strlen(ent->d_name) + 1;
+  size = (size + alignof(struct dirent) - 1) & ~(alignof(struct dirent) - 1);
+  struct dirent* p = (struct dirent*)malloc(size);
+  if (p != NULL) {
+    memcpy((void*)p, (void*)ent, offsetof(struct dirent, d_name));
+    strcpy(p->d_name, ent->d_name);
+    p->d_reclen = static_cast<unsigned short>(size);
+  }
+  return p;
+}
+
+// dwarfs keeps directory entries sorted by name (byte order), so alphasort
+// in "C" collation is a no-op unless there are names that sort before "." and ".."
+static bool scandir_presorted(int (*compar)(const struct dirent**, const struct dirent**),
+                              struct dirent** list,
+                              size_t n)
+{
+  if (compar != alphasort) {
+    return false;
+  }
+  const char* collate = setlocale(LC_COLLATE, NULL);
+  if (collate == NULL || (strcmp(collate, "C") != 0 && strcmp(collate, "POSIX") != 0)) {
+    return false;
+  }
+  for (size_t i = 1; i < n; ++i) {
+    if (strcmp(list[i - 1]->d_name, list[i]->d_name) > 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
 int tebako_scandir(const char* dirname,
                    struct dirent*** namelist,
                    int (*sel)(const struct dirent*),
@@ -252,38 +719,46 @@ int tebako_scandir(const char* dirname,
           size_t size;
           dirp = reinterpret_cast<DIR*>(sync_tebako_dstable::get_tebako_dstable().opendir(vfd, size));
           if (dirp != NULL) {
-            int n = 0;
-            dirent** list = (dirent**)malloc(sizeof(dirent*) * size);
-            dirent *ent = 0, *p = 0;
-            while (list != NULL && (ent = internal_readdir(dirp)) != NULL) {
-              if (sel && !sel(ent))
-                continue;
-              p = (struct dirent*)malloc(ent->d_reclen);
-              if (p == NULL) {
-                while (--n >= 0) {
-                  free(list[n]);
+            std::vector<struct dirent*> list;
+            bool ok = true;
+            try {
+              list.reserve(size);
+              struct dirent* ent = NULL;
+              while ((ent = internal_readdir(dirp)) != NULL) {
+                if (sel && !sel(ent)) {
+                  continue;
                 }
-                free(list);
-                list = NULL;
-              }
-              else {
-                memcpy((void*)p, (void*)ent, ent->d_reclen);
-                list[n++] = p;
+                struct dirent* p = copy_dirent(ent);
+                if (p == NULL) {
+                  ok = false;
+                  break;
+                }
+                list.push_back(p);
               }
             }
+            catch (...) {
+              ok = false;
+            }
             sync_tebako_dstable::get_tebako_dstable().closedir(reinterpret_cast<uintptr_t>(dirp));
-            if (list == NULL) {
+
+            struct dirent** result = NULL;
+            if (ok) {
+              result = (struct dirent**)malloc(std::max(list.size(), size_t(1)) * sizeof(struct dirent*));
+            }
+            if (result == NULL) {
+              for (auto p : list) {
+                free(p);
+              }
               TEBAKO_SET_LAST_ERROR(ENOMEM);
             }
             else {
-              *namelist = (struct dirent**)realloc((void*)list, std::max(n, 1) * sizeof(struct dirent*));
-              if (*namelist == NULL) {
-                *namelist = list;
-              }
-              if (compar && n > 0) {
-                qsort((void*)*namelist, n, sizeof(dirent*), (qsort_compar)compar);
+              size_t n = list.size();
+              std::copy(list.begin(), list.end(), result);
+              if (compar && n > 1 && !scandir_presorted(compar, result, n)) {
+                qsort((void*)result, n, sizeof(struct dirent*), (qsort_compar)compar);
               }
-              ret = n;
+              *namelist = result;
+              ret = static_cast<int>(n);
             }
           }
         }
@@ -0,0 +1,153 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <tebako-pch.h>
+#include <tebako-pch-pp.h>
+#include <tebako-common.h>
+#include <tebako-cache-budget.h>
+
+namespace tebako {
+
+sync_tebako_cache_budget& sync_tebako_cache_budget::get_tebako_cache_budget(void)
+{
+  static sync_tebako_cache_budget cache_budget{};
+  return cache_budget;
+}
+
+// sync_tebako_cache_budget::rebalance
+//  Recomputes the shares of the members and tells the new ones to all members
+//  but except (the one being added, it takes its share from reserve)
+//  The fixed parts are kept, the rest of the budget is shared by the rest of the
+//  requests
+void sync_tebako_cache_budget::rebalance(state& st, uint64_t except)
+{
+  size_t requested = 0;
+  size_t fixed = 0;
+  for (const auto& m : st.members) {
+    requested += std::max(m.second.requested, m.second.fixed);
+    fixed += m.second.fixed;
+  }
+  size_t n = st.members.size();
+  size_t flexible = st.total > fixed ? st.total - fixed : 0;
+  size_t assigned = 0;
+  for (auto& m : st.members) {
+    size_t share = std::max(m.second.requested, m.second.fixed);
+    if (st.total > 0 && requested > st.total) {
+      size_t wanted = share - m.second.fixed;
+      size_t part_share;
+      if (flexible >= n * min_cache_size) {
+        double part = requested > fixed ? static_cast<double>(wanted) / static_cast<double>(requested - fixed) : 0.0;
+        part_share = min_cache_size + static_cast<size_t>(part * static_cast<double>(flexible - n * min_cache_size));
+      }
+      else {
+        part_share = flexible / n;
+      }
+      // Rounding shall not take the sum over the budget
+      part_share = std::min(std::min(part_share, wanted), flexible - assigned);
+      assigned += part_share;
+      share = m.second.fixed + part_share;
+    }
+    if (share != m.second.share && m.first != except && m.second.resize) {
+      m.second.resize(share);
+    }
+    m.second.share = share;
+  }
+}
+
+void sync_tebako_cache_budget::set_total(size_t total)
+{
+  auto p_budget = s_budget.wlock();
+  p_budget->total = total;
+  rebalance(*p_budget, 0);
+}
+
+sync_tebako_cache_budget::budget sync_tebako_cache_budget::get(void)
+{
+  auto p_budget = s_budget.rlock();
+  budget b;
+  b.total = p_budget->total;
+  b.instances = p_budget->members.size();
+  for (const auto& m : p_budget->members) {
+    b.reserved += m.second.share;
+  }
+  return b;
+}
+
+// sync_tebako_cache_budget::reserve
+//  Adds a memfs that is being mounted and shares the budget again
+//  resize is called when the share of the member changes later on
+uint64_t sync_tebako_cache_budget::reserve(size_t requested, resize_callback resize, size_t& share)
+{
+  auto p_budget = s_budget.wlock();
+  uint64_t id = p_budget->next_id++;
+  p_budget->members.emplace(id, member{requested, 0, std::move(resize)});
+  rebalance(*p_budget, id);
+  share = p_budget->members.at(id).share;
+  return id;
+}
+
+// sync_tebako_cache_budget::release
+//  Removes a memfs that is being unmounted; other members get their part of its share
+//  No callback of the member is called after release returns
+void sync_tebako_cache_budget::release(uint64_t id)
+{
+  auto p_budget = s_budget.wlock();
+  if (p_budget->members.erase(id) > 0) {
+    rebalance(*p_budget, 0);
+  }
+}
+
+void sync_tebako_cache_budget::request(uint64_t id, size_t requested)
+{
+  auto p_budget = s_budget.wlock();
+  auto it = p_budget->members.find(id);
+  if (it != p_budget->members.end() && it->second.requested != requested) {
+    it->second.requested = requested;
+    rebalance(*p_budget, 0);
+  }
+}
+
+void sync_tebako_cache_budget::set_fixed(uint64_t id, size_t fixed)
+{
+  auto p_budget = s_budget.wlock();
+  auto it = p_budget->members.find(id);
+  if (it != p_budget->members.end() && it->second.fixed != fixed) {
+    it->second.fixed = fixed;
+    rebalance(*p_budget, 0);
+  }
+}
+
+size_t sync_tebako_cache_budget::get_share(uint64_t id)
+{
+  auto p_budget = s_budget.rlock();
+  auto it = p_budget->members.find(id);
+  return it != p_budget->members.end() ? it->second.share : 0;
+}
+
+}  // namespace tebako
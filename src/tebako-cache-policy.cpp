@@ -0,0 +1,349 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <tebako-pch.h>
+#include <tebako-pch-pp.h>
+#include <tebako-common.h>
+#include <tebako-package-descriptor.h>
+#include <tebako-cache-policy.h>
+
+#include <list>
+#include <unordered_map>
+
+namespace tebako {
+
+namespace {
+
+class lru_policy : public tebako_cache_policy {
+ public:
+  explicit lru_policy(size_t capacity) : capacity(std::max(capacity, static_cast<size_t>(1))) {}
+
+  bool access(uint64_t key, std::vector<uint64_t>& evicted) override
+  {
+    auto it = index.find(key);
+    if (it != index.end()) {
+      queue.splice(queue.begin(), queue, it->second);
+      return true;
+    }
+    queue.push_front(key);
+    index[key] = queue.begin();
+    evict(evicted);
+    return false;
+  }
+
+  bool contains(uint64_t key) const override { return index.count(key) != 0; }
+  size_t size(void) const override { return queue.size(); }
+
+  void resize(size_t cap, std::vector<uint64_t>& evicted) override
+  {
+    capacity = std::max(cap, static_cast<size_t>(1));
+    evict(evicted);
+  }
+
+ private:
+  void evict(std::vector<uint64_t>& evicted)
+  {
+    while (queue.size() > capacity) {
+      evicted.push_back(queue.back());
+      index.erase(queue.back());
+      queue.pop_back();
+    }
+  }
+
+  size_t capacity;
+  std::list<uint64_t> queue;  // most recent first
+  std::unordered_map<uint64_t, std::list<uint64_t>::iterator> index;
+};
+
+// 2Q (Johnson, Shasha), full version: a1in is the FIFO of the keys seen once
+// (a quarter of the capacity), a1out remembers the keys evicted from it (half of
+// the capacity), am is the LRU of the keys seen again
+class two_queue_policy : public tebako_cache_policy {
+ public:
+  explicit two_queue_policy(size_t capacity)
+      : capacity(std::max(capacity, static_cast<size_t>(2))),
+        in_capacity(std::max(this->capacity / 4, static_cast<size_t>(1))),
+        out_capacity(std::max(this->capacity / 2, static_cast<size_t>(1)))
+  {
+  }
+
+  bool access(uint64_t key, std::vector<uint64_t>& evicted) override
+  {
+    auto it = index.find(key);
+    if (it != index.end()) {
+      if (it->second.queue == &am) {
+        am.splice(am.begin(), am, it->second.pos);
+      }
+      return true;
+    }
+    auto ghost = out_index.find(key);
+    if (ghost != out_index.end()) {
+      a1out.erase(ghost->second);
+      out_index.erase(ghost);
+      am.push_front(key);
+      index[key] = entry{&am, am.begin()};
+    }
+    else {
+      a1in.push_front(key);
+      index[key] = entry{&a1in, a1in.begin()};
+    }
+    while (a1in.size() + am.size() > capacity) {
+      reclaim(evicted);
+    }
+    return false;
+  }
+
+  bool contains(uint64_t key) const override { return index.count(key) != 0; }
+  size_t size(void) const override { return a1in.size() + am.size(); }
+
+  void resize(size_t cap, std::vector<uint64_t>& evicted) override
+  {
+    capacity = std::max(cap, static_cast<size_t>(2));
+    in_capacity = std::max(capacity / 4, static_cast<size_t>(1));
+    out_capacity = std::max(capacity / 2, static_cast<size_t>(1));
+    while (a1in.size() + am.size() > capacity) {
+      reclaim(evicted);
+    }
+    while (a1out.size() > out_capacity) {
+      out_index.erase(a1out.back());
+      a1out.pop_back();
+    }
+  }
+
+ private:
+  struct entry {
+    std::list<uint64_t>* queue;
+    std::list<uint64_t>::iterator pos;
+  };
+
+  void reclaim(std::vector<uint64_t>& evicted)
+  {
+    if (a1in.size() > in_capacity || am.empty()) {
+      uint64_t key = a1in.back();
+      a1in.pop_back();
+      index.erase(key);
+      evicted.push_back(key);
+      a1out.push_front(key);
+      out_index[key] = a1out.begin();
+      if (a1out.size() > out_capacity) {
+        out_index.erase(a1out.back());
+        a1out.pop_back();
+      }
+    }
+    else {
+      uint64_t key = am.back();
+      am.pop_back();
+      index.erase(key);
+      evicted.push_back(key);
+    }
+  }
+
+  size_t capacity;
+  size_t in_capacity;
+  size_t out_capacity;
+  std::list<uint64_t> a1in;
+  std::list<uint64_t> a1out;
+  std::list<uint64_t> am;
+  std::unordered_map<uint64_t, entry> index;
+  std::unordered_map<uint64_t, std::list<uint64_t>::iterator> out_index;
+};
+
+// S3-FIFO (Yang et al., SOSP'23): small is a tenth of the capacity, ghost
+// remembers as many keys as main holds; an access frequency of up to 3 is kept
+// per resident key
+class s3fifo_policy : public tebako_cache_policy {
+ public:
+  explicit s3fifo_policy(size_t capacity)
+      : capacity(std::max(capacity, static_cast<size_t>(2))),
+        small_capacity(std::max(this->capacity / 10, static_cast<size_t>(1)))
+  {
+  }
+
+  bool access(uint64_t key, std::vector<uint64_t>& evicted) override
+  {
+    auto it = index.find(key);
+    if (it != index.end()) {
+      it->second.freq = std::min(it->second.freq + 1, 3);
+      return true;
+    }
+    auto ghost_it = ghost_index.find(key);
+    bool in_ghost = ghost_it != ghost_index.end();
+    if (in_ghost) {
+      ghost.erase(ghost_it->second);
+      ghost_index.erase(ghost_it);
+    }
+    while (small.size() + main.size() >= capacity) {
+      reclaim(evicted);
+    }
+    if (in_ghost) {
+      main.push_front(key);
+      index[key] = entry{false, 0};
+    }
+    else {
+      small.push_front(key);
+      index[key] = entry{true, 0};
+    }
+    return false;
+  }
+
+  bool contains(uint64_t key) const override { return index.count(key) != 0; }
+  size_t size(void) const override { return small.size() + main.size(); }
+
+  void resize(size_t cap, std::vector<uint64_t>& evicted) override
+  {
+    capacity = std::max(cap, static_cast<size_t>(2));
+    small_capacity = std::max(capacity / 10, static_cast<size_t>(1));
+    while (small.size() + main.size() > capacity) {
+      reclaim(evicted);
+    }
+    while (ghost.size() > capacity - small_capacity) {
+      ghost_index.erase(ghost.back());
+      ghost.pop_back();
+    }
+  }
+
+ private:
+  struct entry {
+    bool small;
+    int freq;
+  };
+
+  void reclaim(std::vector<uint64_t>& evicted)
+  {
+    if (small.size() >= small_capacity || main.empty()) {
+      evict_small(evicted);
+    }
+    else {
+      evict_main(evicted);
+    }
+  }
+
+  void evict_small(std::vector<uint64_t>& evicted)
+  {
+    while (!small.empty()) {
+      uint64_t key = small.back();
+      small.pop_back();
+      auto& e = index[key];
+      if (e.freq > 0) {
+        // Accessed while in small: promote
+        e = entry{false, 0};
+        main.push_front(key);
+        if (main.size() > capacity - small_capacity) {
+          evict_main(evicted);
+        }
+      }
+      else {
+        index.erase(key);
+        evicted.push_back(key);
+        ghost.push_front(key);
+        ghost_index[key] = ghost.begin();
+        if (ghost.size() > capacity - small_capacity) {
+          ghost_index.erase(ghost.back());
+          ghost.pop_back();
+        }
+        return;
+      }
+    }
+  }
+
+  void evict_main(std::vector<uint64_t>& evicted)
+  {
+    while (!main.empty()) {
+      uint64_t key = main.back();
+      main.pop_back();
+      auto& e = index[key];
+      if (e.freq > 0) {
+        e.freq--;
+        main.push_front(key);
+      }
+      else {
+        index.erase(key);
+        evicted.push_back(key);
+        return;
+      }
+    }
+  }
+
+  size_t capacity;
+  size_t small_capacity;
+  std::list<uint64_t> small;
+  std::list<uint64_t> main;
+  std::list<uint64_t> ghost;
+  std::unordered_map<uint64_t, entry> index;
+  std::unordered_map<uint64_t, std::list<uint64_t>::iterator> ghost_index;
+};
+
+}  // namespace
+
+bool tebako_cache_policy::is_valid_name(const std::string& name)
+{
+  return name == "lru" || name == "2q" || name == "s3fifo";
+}
+
+std::unique_ptr<tebako_cache_policy> tebako_cache_policy::create(const std::string& name, size_t capacity)
+{
+  if (name == "lru") {
+    return std::make_unique<lru_policy>(capacity);
+  }
+  if (name == "2q") {
+    return std::make_unique<two_queue_policy>(capacity);
+  }
+  if (name == "s3fifo") {
+    return std::make_unique<s3fifo_policy>(capacity);
+  }
+  throw std::invalid_argument("unknown cache policy '" + name + "'");
+}
+
+std::vector<uint64_t> tebako_cache_policy::trace(const prefetch_manifest& ranges, size_t chunk_size)
+{
+  std::vector<uint64_t> keys;
+  for (const auto& r : ranges) {
+    uint64_t last = (r.offset + std::max(r.length, static_cast<uint32_t>(1)) - 1) / chunk_size;
+    for (uint64_t chunk = r.offset / chunk_size; chunk <= last; ++chunk) {
+      keys.push_back(key(r.inode, chunk));
+    }
+  }
+  return keys;
+}
+
+double tebako_cache_policy::hit_rate(const std::string& name, size_t capacity, const std::vector<uint64_t>& trace)
+{
+  auto policy = create(name, capacity);
+  std::vector<uint64_t> evicted;
+  size_t hits = 0;
+  for (uint64_t k : trace) {
+    if (policy->access(k, evicted)) {
+      ++hits;
+    }
+    evicted.clear();
+  }
+  return trace.empty() ? 0.0 : static_cast<double>(hits) / trace.size();
+}
+
+}  // namespace tebako
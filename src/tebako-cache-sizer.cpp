@@ -0,0 +1,194 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <tebako-pch.h>
+#include <tebako-pch-pp.h>
+#include <tebako-common.h>
+#include <tebako-cache-sizer.h>
+
+#include <folly/hash/Hash.h>
+
+namespace tebako {
+
+tebako_cache_sizer::tebako_cache_sizer(size_t min_bytes,
+                                       size_t max_bytes,
+                                       double target_hit_rate,
+                                       unsigned int sampling_rate)
+    : min_bytes(std::min(min_bytes, max_bytes)),
+      max_bytes(max_bytes),
+      target_hit_rate(target_hit_rate),
+      sampling_rate(std::max(sampling_rate, 1u))
+{
+  auto p_state = s_state.wlock();
+  p_state->marks.assign(window + 1, 0);
+  // The last bucket collects the distances beyond max_bytes
+  p_state->histogram.assign(max_bytes / granule + 1, 0);
+}
+
+void tebako_cache_sizer::mark(std::vector<uint32_t>& marks, uint32_t t, int delta)
+{
+  for (; t < marks.size(); t += t & (~t + 1)) {
+    marks[t] += delta;
+  }
+}
+
+// Number of marks at logical time t or before
+uint32_t tebako_cache_sizer::count_until(const std::vector<uint32_t>& marks, uint32_t t)
+{
+  uint32_t count = 0;
+  for (; t > 0; t -= t & (~t + 1)) {
+    count += marks[t];
+  }
+  return count;
+}
+
+// tebako_cache_sizer::compact
+//  Renumbers the tracked granules when logical time reaches the window; if
+//  the stack is large, its older half is forgotten (these accesses are cold then)
+void tebako_cache_sizer::compact(state& s)
+{
+  std::vector<std::pair<uint32_t, uint64_t>> order;
+  order.reserve(s.last.size());
+  for (const auto& e : s.last) {
+    order.emplace_back(e.second, e.first);
+  }
+  std::sort(order.begin(), order.end());
+  size_t keep = order.size() > window / 2 ? order.size() / 2 : order.size();
+  s.last.clear();
+  std::fill(s.marks.begin(), s.marks.end(), 0);
+  s.now = 0;
+  for (size_t i = order.size() - keep; i < order.size(); ++i) {
+    s.last.emplace(order[i].second, ++s.now);
+    mark(s.marks, s.now, 1);
+  }
+}
+
+void tebako_cache_sizer::access(state& s, uint64_t key)
+{
+  if (s.now >= window) {
+    compact(s);
+  }
+  uint32_t t = ++s.now;
+  auto it = s.last.find(key);
+  if (it == s.last.end()) {
+    s.cold += 1;
+    s.last.emplace(key, t);
+  }
+  else {
+    // Distinct sampled granules accessed since the previous access to this one
+    uint64_t distance = s.last.size() - count_until(s.marks, it->second);
+    size_t bucket = static_cast<size_t>(std::min<uint64_t>(distance * sampling_rate, s.histogram.size() - 1));
+    s.histogram[bucket] += 1;
+    mark(s.marks, it->second, -1);
+    it->second = t;
+  }
+  mark(s.marks, t, 1);
+  s.total += 1;
+  s.pending++;
+}
+
+bool tebako_cache_sizer::record(uint32_t inode, uint64_t offset, size_t size) noexcept
+{
+  bool due = false;
+  if (size == 0) {
+    return due;
+  }
+  try {
+    uint64_t first = offset / granule;
+    uint64_t last = (offset + size - 1) / granule;
+    std::vector<uint64_t> keys;
+    for (uint64_t g = first; g <= last; ++g) {
+      uint64_t key = (static_cast<uint64_t>(inode) << 40) | (g & ((static_cast<uint64_t>(1) << 40) - 1));
+      if (folly::hash::twang_mix64(key) % sampling_rate == 0) {
+        keys.push_back(key);
+      }
+    }
+    if (!keys.empty()) {
+      sampled.fetch_add(keys.size(), std::memory_order_relaxed);
+      auto p_state = s_state.wlock();
+      for (auto key : keys) {
+        access(*p_state, key);
+      }
+      due = p_state->pending >= evaluation_interval;
+    }
+  }
+  catch (...) {
+    // The access is not sampled
+  }
+  return due;
+}
+
+double tebako_cache_sizer::hit_rate_locked(const state& s, size_t bytes) const
+{
+  if (s.total <= 0) {
+    return 0;
+  }
+  size_t n = std::min(bytes / granule, s.histogram.size() - 1);
+  double hits = 0;
+  for (size_t i = 0; i < n; ++i) {
+    hits += s.histogram[i];
+  }
+  return hits / s.total;
+}
+
+double tebako_cache_sizer::hit_rate(size_t bytes) const
+{
+  return hit_rate_locked(*s_state.rlock(), bytes);
+}
+
+tebako_cache_sizer::decision tebako_cache_sizer::evaluate(void)
+{
+  auto p_state = s_state.wlock();
+  decision d{max_bytes, 0};
+  if (p_state->total > 0) {
+    size_t min_g = std::max<size_t>((min_bytes + granule - 1) / granule, 1);
+    size_t max_g = max_bytes / granule;
+    double hits = 0;
+    for (size_t g = 1; g <= max_g; ++g) {
+      hits += p_state->histogram[g - 1];
+      if (g >= min_g && hits >= target_hit_rate * p_state->total) {
+        d.size = g * granule;
+        break;
+      }
+    }
+    d.size = std::max(std::min(d.size, max_bytes), min_bytes);
+    d.hit_rate = hit_rate_locked(*p_state, d.size);
+
+    // Aging
+    for (auto& h : p_state->histogram) {
+      h /= 2;
+    }
+    p_state->cold /= 2;
+    p_state->total /= 2;
+  }
+  p_state->pending = 0;
+  return d;
+}
+
+}  // namespace tebako
@@ -0,0 +1,166 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <tebako-pch.h>
+#include <tebako-pch-pp.h>
+#include <tebako-common.h>
+#include <tebako-package-descriptor.h>
+#include <tebako-cache-policy.h>
+#include <tebako-chunk-cache.h>
+
+namespace tebako {
+
+tebako_chunk_cache::tebako_chunk_cache(const std::string& policy, size_t max_bytes)
+    : policy_name(policy), capacity(std::max(max_bytes / chunk_size, static_cast<size_t>(2)))
+{
+  s_state.wlock()->policy = tebako_cache_policy::create(policy, capacity);
+}
+
+tebako_chunk_cache::~tebako_chunk_cache() = default;
+
+void tebako_chunk_cache::drop(state& st, const std::vector<uint64_t>& evicted)
+{
+  for (uint64_t k : evicted) {
+    auto it = st.chunks.find(k);
+    if (it != st.chunks.end()) {
+      st.bytes -= it->second.data->size();
+      st.chunks.erase(it);
+      ++st.evictions;
+    }
+  }
+}
+
+size_t tebako_chunk_cache::drop_older(state& st, std::chrono::steady_clock::time_point before)
+{
+  size_t dropped = 0;
+  for (auto it = st.chunks.begin(); it != st.chunks.end();) {
+    if (it->second.used < before) {
+      dropped += it->second.data->size();
+      it = st.chunks.erase(it);
+    }
+    else {
+      ++it;
+    }
+  }
+  st.bytes -= dropped;
+  return dropped;
+}
+
+bool tebako_chunk_cache::get(uint32_t inode,
+                             uint64_t chunk,
+                             size_t in_chunk,
+                             char* buf,
+                             size_t size,
+                             size_t& length) noexcept
+{
+  std::shared_ptr<const std::vector<char>> data;
+  try {
+    uint64_t key = tebako_cache_policy::key(inode, chunk);
+    std::vector<uint64_t> evicted;
+    auto p_state = s_state.wlock();
+    if (p_state->policy->access(key, evicted)) {
+      auto it = p_state->chunks.find(key);
+      if (it != p_state->chunks.end()) {
+        data = it->second.data;
+        it->second.used = std::chrono::steady_clock::now();
+      }
+    }
+    drop(*p_state, evicted);
+  }
+  catch (...) {
+    return false;
+  }
+
+  if (!data) {
+    return false;
+  }
+  length = data->size();
+  if (in_chunk < length) {
+    std::memcpy(buf, data->data() + in_chunk, std::min(length - in_chunk, size));
+  }
+  return true;
+}
+
+void tebako_chunk_cache::put(uint32_t inode, uint64_t chunk, const char* data, size_t length) noexcept
+{
+  try {
+    uint64_t key = tebako_cache_policy::key(inode, chunk);
+    auto content = std::make_shared<const std::vector<char>>(data, data + length);
+    auto p_state = s_state.wlock();
+    // The key may have been evicted since the miss that admitted it
+    auto now = std::chrono::steady_clock::now();
+    if (p_state->policy->contains(key)) {
+      auto& slot = p_state->chunks[key];
+      if (slot.data) {
+        p_state->bytes -= slot.data->size();
+      }
+      slot.data = std::move(content);
+      slot.used = now;
+      p_state->bytes += length;
+    }
+    auto interval = std::max(p_state->max_age / 4, std::chrono::milliseconds(100));
+    if (p_state->max_age.count() > 0 && now - p_state->expired >= interval) {
+      drop_older(*p_state, now - p_state->max_age);
+      p_state->expired = now;
+    }
+  }
+  catch (...) {
+    // The cache is an optimization, a chunk that is not stored is read again
+  }
+}
+
+void tebako_chunk_cache::set_capacity(size_t max_bytes) noexcept
+{
+  try {
+    size_t chunks = std::max(max_bytes / chunk_size, static_cast<size_t>(2));
+    std::vector<uint64_t> evicted;
+    auto p_state = s_state.wlock();
+    p_state->policy->resize(chunks, evicted);
+    drop(*p_state, evicted);
+    capacity = chunks;
+  }
+  catch (...) {
+    // The cap is kept, the policy is unchanged
+  }
+}
+
+size_t tebako_chunk_cache::expire(std::chrono::milliseconds max_age) noexcept
+{
+  auto now = std::chrono::steady_clock::now();
+  auto p_state = s_state.wlock();
+  p_state->expired = now;
+  return drop_older(*p_state, now - max_age);
+}
+
+void tebako_chunk_cache::set_max_age(std::chrono::milliseconds max_age) noexcept
+{
+  s_state.wlock()->max_age = max_age;
+}
+
+}  // namespace tebako
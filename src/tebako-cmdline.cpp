@@ -293,6 +293,20 @@ void cmdline_args::process_mountpoints()
         sync_tebako_mount_table::get_tebako_mount_table().insert(st.st_ino, filename, target);
       }
       else {  // assume that  (separator == '>')
+        // Per-memfs options may follow the image path:
+        //   mountpoint>image?cachesize=16M,workers=1
+        memfs_options opts;
+        size_t options_pos = find_memfs_options(target);
+        try {
+          opts = memfs::parse_options(options_pos != std::string::npos ? target.c_str() + options_pos + 1 : nullptr);
+        }
+        catch (std::exception& e) {
+          throw std::invalid_argument("Invalid memfs options in " + item + ": " + e.what());
+        }
+        if (options_pos != std::string::npos) {
+          target.resize(options_pos);
+        }
+
         std::ifstream file(target, std::ios::binary | std::ios::ate);
         if (!file) {
           throw std::invalid_argument("Path " + target + " does not exist");
@@ -307,7 +321,7 @@ void cmdline_args::process_mountpoints()
           throw std::invalid_argument("Failed to load filesystem image from " + target);
         }
 
-        int ret = mount_memfs(buffer.data(), size, "auto", st.st_ino, filename.c_str());
+        int ret = mount_memfs(buffer.data(), size, "auto", st.st_ino, filename.c_str(), opts);
         if (ret < 1) {
           throw std::invalid_argument("Failed to mount filesystem image from " + target);
         }
@@ -319,6 +333,37 @@ void cmdline_args::process_mountpoints()
   }
 }
 
+// cmdline_args::find_memfs_options
+//  Finds the '?' that starts per-memfs options in the target of a '>' mount
+//  Image paths may contain '?' themselves, so only a '?' followed by a key and '='
+//  starts the options: the first one that follows an existing file, or the first
+//  one at all if the image does not exist (the error is reported on load); a target
+//  that names an existing file has no options
+// returns
+//  position of '?' or std::string::npos if there are no options
+size_t cmdline_args::find_memfs_options(const std::string& target)
+{
+  std::error_code ec;
+  if (stdfs::is_regular_file(target, ec)) {
+    return std::string::npos;
+  }
+
+  size_t first = std::string::npos;
+  for (size_t pos = target.find('?'); pos != std::string::npos; pos = target.find('?', pos + 1)) {
+    size_t key_end = target.find_first_not_of("abcdefghijklmnopqrstuvwxyz_", pos + 1);
+    if (key_end == pos + 1 || key_end == std::string::npos || target[key_end] != '=') {
+      continue;
+    }
+    if (stdfs::is_regular_file(target.substr(0, pos), ec)) {
+      return pos;
+    }
+    if (first == std::string::npos) {
+      first = pos;
+    }
+  }
+  return first;
+}
+
 void cmdline_args::process_package()
 {
   std::ifstream file(app_image, std::ios::binary | std::ios::ate);
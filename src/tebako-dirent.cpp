@@ -134,7 +134,7 @@ long sync_tebako_dstable::dirfd(uintptr_t dirp) noexcept
   return ret;
 }
 
-int sync_tebako_dstable::readdir(uintptr_t dirp, tebako_dirent*& entry) noexcept
+int sync_tebako_dstable::readdir(uintptr_t dirp, tebako_dirent*& entry, struct stat* st) noexcept
 {
   int ret = DWARFS_INVALID_FD;
   entry = NULL;
@@ -170,6 +170,9 @@ int sync_tebako_dstable::readdir(uintptr_t dirp, tebako_dirent*& entry) noexcept
           entry = &p_ds->second->cache[p_ds->second->dir_position++ - p_ds->second->cache_start];
           ret = DWARFS_IO_CONTINUE;
         }
+        if (entry && st) {
+          *st = p_ds->second->stats[entry - p_ds->second->cache];
+        }
       }
     }
   }
@@ -179,7 +182,7 @@ int sync_tebako_dstable::readdir(uintptr_t dirp, tebako_dirent*& entry) noexcept
 int tebako_ds::load_cache(int new_cache_start, bool set_pos) noexcept
 {
   int ret = sync_tebako_fdtable::get_tebako_fdtable().readdir(vfd, cache, new_cache_start, TEBAKO_DIR_CACHE_SIZE,
-                                                              cache_size, dir_size);
+                                                              cache_size, dir_size, stats);
 
   if (ret == DWARFS_IO_CONTINUE) {
     if (set_pos) {
@@ -0,0 +1,323 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <tebako-pch.h>
+#include <tebako-pch-pp.h>
+#include <tebako-common.h>
+#include <tebako-disk-cache.h>
+#include <tebako-mfs.h>
+#include <tebako-thread-pool.h>
+
+#include <iomanip>
+
+#include <folly/hash/SpookyHashV2.h>
+#include <folly/portability/Fcntl.h>
+#include <folly/portability/SysStat.h>
+#include <folly/portability/Unistd.h>
+
+namespace tebako {
+
+const char tebako_disk_cache::magic[8] = {'T', 'B', 'K', 'D', 'C', 'A', 'C', 'H'};
+
+namespace {
+
+#ifdef O_BINARY
+const int open_binary = O_BINARY;
+#else
+const int open_binary = 0;
+#endif
+
+bool write_all(int fd, const char* data, size_t length)
+{
+  while (length > 0) {
+    ssize_t n = ::write(fd, data, length);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    data += n;
+    length -= n;
+  }
+  return true;
+}
+
+}  // namespace
+
+// Image identity: size, the headers of all blocks and the metadata of the image
+// The header of each section holds the xxh3 and sha2-512/256 checksums of its data,
+// so two builds that differ in any block get different identities without hashing
+// all the data; an image without the section index is hashed entirely
+uint64_t tebako_disk_cache::image_identity(const void* image, size_t image_size)
+{
+  const char* p = static_cast<const char*>(image);
+  mfs sections(image, image_size, nullptr, false);
+  const auto& blocks = sections.blocks();
+  const auto& metadata = sections.metadata();
+  if (blocks.empty() || metadata.second == 0) {
+    return folly::hash::SpookyHashV2::Hash64(p, image_size, image_size);
+  }
+  uint64_t h = image_size;
+  for (const auto& block : blocks) {
+    h = folly::hash::SpookyHashV2::Hash64(p + block.first, std::min(block.second, mfs::section_header_size), h);
+  }
+  return folly::hash::SpookyHashV2::Hash64(p + metadata.first, metadata.second, h);
+}
+
+uint64_t tebako_disk_cache::checksum(const char* data, size_t length)
+{
+  return folly::hash::SpookyHashV2::Hash64(data, length, format_version);
+}
+
+tebako_disk_cache::tebako_disk_cache(const std::string& root, uint64_t max_bytes, const void* image, size_t image_size)
+    : root(root), max_bytes(max_bytes), identity(image_identity(image, image_size))
+{
+  std::stringstream name;
+  name << "v" << format_version << "-" << std::hex << std::setw(16) << std::setfill('0') << identity;
+  dir = this->root / name.str();
+  stdfs::create_directories(dir);
+  schedule_trim();
+}
+
+stdfs::path tebako_disk_cache::chunk_path(uint32_t inode, uint64_t chunk) const
+{
+  return dir / (std::to_string(inode) + "-" + std::to_string(chunk));
+}
+
+// tebako_disk_cache::get
+//  Reads a chunk file into the buffer and validates its header and checksum
+//  Invalid files (older format, another image, torn or corrupted data) are removed
+//  Nothing stays mapped or open, so a long-running process does not accumulate
+//  a mapping per chunk it has read
+bool tebako_disk_cache::get(uint32_t inode, uint64_t chunk, std::vector<char>& buffer, size_t& length)
+{
+  auto path = chunk_path(inode, chunk);
+  int fd = ::open(path.string().c_str(), O_RDONLY | open_binary);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  chunk_header h;
+  bool ok = ::fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(h) &&
+            static_cast<size_t>(st.st_size) - sizeof(h) <= chunk_size &&
+            ::pread(fd, &h, sizeof(h), 0) == static_cast<ssize_t>(sizeof(h));
+  if (ok) {
+    buffer.resize(st.st_size - sizeof(h));
+    ok = ::pread(fd, buffer.data(), buffer.size(), sizeof(h)) == static_cast<ssize_t>(buffer.size()) &&
+         std::memcmp(h.magic, magic, sizeof(magic)) == 0 && h.version == format_version && h.identity == identity &&
+         h.inode == inode && h.chunk == chunk && h.length == buffer.size() &&
+         h.checksum == checksum(buffer.data(), h.length);
+  }
+  ::close(fd);
+
+  std::error_code ec;
+  if (ok) {
+    length = h.length;
+    // LRU: the file is used by this run; mtime is refreshed at most once a minute
+    if (st.st_mtime + 60 < ::time(nullptr)) {
+      stdfs::last_write_time(path, stdfs::file_time_type::clock::now(), ec);
+    }
+  }
+  else {
+    stdfs::remove(path, ec);
+  }
+  return ok;
+}
+
+void tebako_disk_cache::put(uint32_t inode, uint64_t chunk, const char* data, size_t length) noexcept
+{
+  try {
+    chunk_header h;
+    std::memcpy(h.magic, magic, sizeof(magic));
+    h.version = format_version;
+    h.length = static_cast<uint32_t>(length);
+    h.identity = identity;
+    h.inode = inode;
+    h.reserved = 0;
+    h.chunk = chunk;
+    h.checksum = checksum(data, length);
+
+    auto path = chunk_path(inode, chunk);
+    std::stringstream tmp_name;
+    tmp_name << path.filename().string() << ".tmp" << ::getpid() << "-" << std::this_thread::get_id();
+    auto tmp_path = dir / tmp_name.str();
+    int fd = ::open(tmp_path.string().c_str(), O_WRONLY | O_CREAT | O_TRUNC | open_binary, 0644);
+    if (fd < 0) {
+      return;
+    }
+    // The data reaches the disk before the rename, so that a crash cannot leave
+    // a chunk file with a valid name and torn content
+    bool ok = write_all(fd, reinterpret_cast<const char*>(&h), sizeof(h)) && write_all(fd, data, length) &&
+              ::fsync(fd) == 0;
+    ::close(fd);
+    std::error_code ec;
+    if (!ok) {
+      stdfs::remove(tmp_path, ec);
+      return;
+    }
+    stdfs::rename(tmp_path, path, ec);
+    if (ec) {
+      stdfs::remove(tmp_path, ec);
+    }
+    else if ((written += sizeof(h) + length) > max_bytes / 8) {
+      written = 0;
+      schedule_trim();
+    }
+  }
+  catch (...) {
+    // The chunk is not cached, it will be decompressed next time
+  }
+}
+
+void tebako_disk_cache::schedule_trim(void)
+{
+  try {
+    tebako_thread_pool::get_tebako_thread_pool().submit_background(
+        [root = root, max_bytes = max_bytes]() { trim(root, max_bytes); });
+  }
+  catch (...) {
+    // Trimmed next time
+  }
+}
+
+namespace {
+
+// Skips the digits (of base 10 or 16) at pos; returns the position after them or npos if there are none
+size_t skip_number(const std::string& s, size_t pos, int base)
+{
+  size_t end = pos;
+  while (end < s.size() && (base == 16 ? std::isxdigit(static_cast<unsigned char>(s[end]))
+                                       : std::isdigit(static_cast<unsigned char>(s[end])))) {
+    ++end;
+  }
+  return end > pos ? end : std::string::npos;
+}
+
+// v<format_version>-<16 hex digits of the image identity>
+bool is_image_dir_name(const std::string& name)
+{
+  size_t pos = name.size() == 0 || name[0] != 'v' ? std::string::npos : skip_number(name, 1, 10);
+  if (pos == std::string::npos || pos >= name.size() || name[pos] != '-') {
+    return false;
+  }
+  size_t end = skip_number(name, pos + 1, 16);
+  return end == name.size() && end - pos - 1 == 16;
+}
+
+// <inode>-<chunk>; tmp is set for <inode>-<chunk>.tmp<pid>-<thread id>
+bool is_chunk_file_name(const std::string& name, bool& tmp)
+{
+  size_t pos = skip_number(name, 0, 10);
+  if (pos == std::string::npos || pos >= name.size() || name[pos] != '-') {
+    return false;
+  }
+  pos = skip_number(name, pos + 1, 10);
+  if (pos == name.size()) {
+    tmp = false;
+    return true;
+  }
+  if (pos == std::string::npos || name.compare(pos, 4, ".tmp") != 0) {
+    return false;
+  }
+  pos = skip_number(name, pos + 4, 10);
+  tmp = pos != std::string::npos && pos < name.size() && name[pos] == '-';
+  return tmp;
+}
+
+}  // namespace
+
+// tebako_disk_cache::trim
+//  Removes the least recently used chunk files (of any image and format version)
+//  until the cache is within 90% of max_bytes, and temporary files left by
+//  crashed runs
+//  Only the image directories and the files written by tebako_disk_cache are
+//  considered, so a root shared with other data (~/.cache, /tmp) is safe
+void tebako_disk_cache::trim(const stdfs::path& root, uint64_t max_bytes) noexcept
+{
+  try {
+    struct entry {
+      stdfs::file_time_type mtime;
+      uint64_t size;
+      stdfs::path path;
+    };
+    std::vector<entry> entries;
+    uint64_t total = 0;
+    auto stale = stdfs::file_time_type::clock::now() - std::chrono::hours(1);
+    std::error_code ec;
+
+    for (auto dir = stdfs::directory_iterator(root, ec); !ec && dir != stdfs::directory_iterator(); dir.increment(ec)) {
+      if (dir->is_symlink(ec) || !dir->is_directory(ec) || !is_image_dir_name(dir->path().filename().string())) {
+        ec.clear();
+        continue;
+      }
+      std::error_code dir_ec;
+      for (auto it = stdfs::directory_iterator(dir->path(), dir_ec); !dir_ec && it != stdfs::directory_iterator();
+           it.increment(dir_ec)) {
+        bool tmp;
+        if (it->is_symlink(dir_ec) || !it->is_regular_file(dir_ec) ||
+            !is_chunk_file_name(it->path().filename().string(), tmp)) {
+          dir_ec.clear();
+          continue;
+        }
+        entry e{it->last_write_time(dir_ec), it->file_size(dir_ec), it->path()};
+        if (dir_ec) {
+          dir_ec.clear();
+          continue;
+        }
+        if (tmp) {
+          if (e.mtime < stale) {
+            stdfs::remove(e.path, dir_ec);
+          }
+          continue;
+        }
+        total += e.size;
+        entries.push_back(std::move(e));
+      }
+    }
+
+    if (total > max_bytes) {
+      std::sort(entries.begin(), entries.end(), [](const entry& a, const entry& b) { return a.mtime < b.mtime; });
+      uint64_t target = max_bytes - max_bytes / 10;
+      for (const auto& e : entries) {
+        if (total <= target) {
+          break;
+        }
+        if (stdfs::remove(e.path, ec)) {
+          total -= e.size;
+        }
+      }
+    }
+  }
+  catch (...) {
+    // Trimming is best effort
+  }
+}
+
+}  // namespace tebako
@@ -71,6 +71,10 @@ int sync_tebako_fdtable::open(const char* path, int flags, std::string& lnk) noe
           TEBAKO_SET_LAST_ERROR(ELOOP);
         }
         else {
+#ifdef O_DIRECT
+          fd->stream = (flags & O_DIRECT) != 0;
+#endif
+          fd->stream = fd->stream || dwarfs_inode_streamed(&fd->st);
           fd->handle = new int;
           if (fd->handle == NULL) {
             TEBAKO_SET_LAST_ERROR(ENOMEM);
@@ -162,6 +166,10 @@ int sync_tebako_fdtable::openat(int vfd, const char* path, int flags, std::strin
                 TEBAKO_SET_LAST_ERROR(ELOOP);
               }
               else {
+#ifdef O_DIRECT
+                fd->stream = (flags & O_DIRECT) != 0;
+#endif
+                fd->stream = fd->stream || dwarfs_inode_streamed(&fd->st);
                 fd->handle = new int;
                 if (fd->handle == NULL) {
                   TEBAKO_SET_LAST_ERROR(ENOMEM);
@@ -253,7 +261,7 @@ ssize_t sync_tebako_fdtable::read(int vfd, void* buf, size_t nbyte) noexcept
   auto p_fdtable = s_tebako_fdtable.rlock();
   auto p_fd = p_fdtable->find(vfd);
   if (p_fd != p_fdtable->end()) {
-    ret = dwarfs_inode_read(p_fd->second->st.st_ino, buf, nbyte, p_fd->second->pos);
+    ret = dwarfs_inode_read(p_fd->second->st.st_ino, buf, nbyte, p_fd->second->pos, p_fd->second->stream);
     if (ret > 0) {
       p_fd->second->pos += ret;
     }
@@ -265,8 +273,9 @@ ssize_t sync_tebako_fdtable::pread(int vfd, void* buf, size_t nbyte, off_t offse
 {
   auto p_fdtable = s_tebako_fdtable.rlock();
   auto p_fd = p_fdtable->find(vfd);
-  return (p_fd != p_fdtable->end()) ? dwarfs_inode_read(p_fd->second->st.st_ino, buf, nbyte, offset)
-                                    : DWARFS_INVALID_FD;
+  return (p_fd != p_fdtable->end())
+             ? dwarfs_inode_read(p_fd->second->st.st_ino, buf, nbyte, offset, p_fd->second->stream)
+             : DWARFS_INVALID_FD;
 }
 
 int sync_tebako_fdtable::readdir(int vfd,
@@ -274,15 +283,37 @@ int sync_tebako_fdtable::readdir(int vfd,
                                  off_t cache_start,
                                  size_t buffer_size,
                                  size_t& cache_size,
-                                 size_t& dir_size) noexcept
+                                 size_t& dir_size,
+                                 struct stat* stats) noexcept
 {
   auto p_fdtable = s_tebako_fdtable.rlock();
   auto p_fd = p_fdtable->find(vfd);
-  return (p_fd != p_fdtable->end())
-             ? dwarfs_inode_readdir(p_fd->second->st.st_ino, cache, cache_start, buffer_size, cache_size, dir_size)
-             : DWARFS_INVALID_FD;
+  return (p_fd != p_fdtable->end()) ? dwarfs_inode_readdir(p_fd->second->st.st_ino, cache, cache_start, buffer_size,
+                                                           cache_size, dir_size, stats)
+                                    : DWARFS_INVALID_FD;
 }
 
+#ifndef RB_W32
+ssize_t sync_tebako_fdtable::getdents(int vfd, void* buf, size_t nbyte) noexcept
+{
+  ssize_t ret = DWARFS_INVALID_FD;
+  auto p_fdtable = s_tebako_fdtable.rlock();
+  auto p_fd = p_fdtable->find(vfd);
+  if (p_fd != p_fdtable->end()) {
+    if (!S_ISDIR(p_fd->second->st.st_mode)) {
+      TEBAKO_SET_LAST_ERROR(ENOTDIR);
+      ret = DWARFS_IO_ERROR;
+    }
+    else {
+      // Directory position is stored as the index of the next entry
+      // the same way as lseek on kernel directories works
+      ret = dwarfs_inode_getdents(p_fd->second->st.st_ino, buf, nbyte, p_fd->second->pos);
+    }
+  }
+  return ret;
+}
+#endif
+
 #ifdef TEBAKO_HAS_READV
 ssize_t sync_tebako_fdtable::readv(int vfd, const struct ::iovec* iov, int iovcnt) noexcept
 {
@@ -305,7 +336,8 @@ ssize_t sync_tebako_fdtable::readv(int vfd, const struct ::iovec* iov, int iovcn
     if (p_fd != p_fdtable->end()) {
       ret = 0;
       for (int i = 0; i < iovcnt; ++i) {
-        ssize_t ssize = dwarfs_inode_read(p_fd->second->st.st_ino, iov[i].iov_base, iov[i].iov_len, p_fd->second->pos);
+        ssize_t ssize = dwarfs_inode_read(p_fd->second->st.st_ino, iov[i].iov_base, iov[i].iov_len, p_fd->second->pos,
+                                          p_fd->second->stream);
         if (ssize > 0) {
           if (p_fd->second->pos > std::numeric_limits<off_t>::max() - ssize) {
             TEBAKO_SET_LAST_ERROR(EOVERFLOW);
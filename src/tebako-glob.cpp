@@ -0,0 +1,348 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <tebako-pch.h>
+#include <tebako-pch-pp.h>
+#include <tebako-common.h>
+#include <tebako-io.h>
+#include <tebako-glob.h>
+
+namespace tebako {
+
+glob_segment::glob_segment(const std::string& ptrn, int flgs) : k(LITERAL), pattern(ptrn), flags(flgs)
+{
+  bool noescape = (flags & TEBAKO_GLOB_NOESCAPE) != 0;
+  if (pattern == "**") {
+    k = RECURSIVE;
+  }
+  else {
+    for (size_t i = 0; i < pattern.size() && k == LITERAL; ++i) {
+      char c = pattern[i];
+      if (c == '\\' && !noescape && i + 1 < pattern.size()) {
+        literal.push_back(pattern[++i]);
+      }
+      else if (c == '*' || c == '?' || c == '[') {
+        k = WILDCARD;
+      }
+      else {
+        literal.push_back(c);
+      }
+    }
+    // Case-insensitive names cannot be looked up directly
+    if (k == LITERAL && (flags & TEBAKO_GLOB_CASEFOLD)) {
+      k = WILDCARD;
+    }
+  }
+}
+
+bool glob_segment::chars_equal(char a, char b) const
+{
+  if (flags & TEBAKO_GLOB_CASEFOLD) {
+    return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+  }
+  return a == b;
+}
+
+// glob_segment::match_bracket
+//  Matches a character against bracket expression starting at pattern[p]
+// returns
+//  1 - match, 0 - no match [next is set to the position after ']']
+//  -1 - there is no closing ']', so '[' shall be treated as a literal
+int glob_segment::match_bracket(size_t p, char ch, size_t& next) const
+{
+  bool noescape = (flags & TEBAKO_GLOB_NOESCAPE) != 0;
+  bool casefold = (flags & TEBAKO_GLOB_CASEFOLD) != 0;
+  size_t q = p + 1;
+  bool negate = false;
+  bool matched = false;
+
+  if (q < pattern.size() && (pattern[q] == '!' || pattern[q] == '^')) {
+    negate = true;
+    ++q;
+  }
+  // ']' right after '[' or '[!' is a literal
+  bool first = true;
+  while (q < pattern.size() && (first || pattern[q] != ']')) {
+    first = false;
+    char lo = pattern[q];
+    if (lo == '\\' && !noescape && q + 1 < pattern.size()) {
+      lo = pattern[++q];
+    }
+    char hi = lo;
+    if (q + 2 < pattern.size() && pattern[q + 1] == '-' && pattern[q + 2] != ']') {
+      q += 2;
+      hi = pattern[q];
+      if (hi == '\\' && !noescape && q + 1 < pattern.size()) {
+        hi = pattern[++q];
+      }
+    }
+    unsigned char c = static_cast<unsigned char>(ch);
+    if (c >= static_cast<unsigned char>(lo) && c <= static_cast<unsigned char>(hi)) {
+      matched = true;
+    }
+    else if (casefold) {
+      unsigned char cl = std::tolower(c);
+      unsigned char cu = std::toupper(c);
+      if ((cl >= static_cast<unsigned char>(lo) && cl <= static_cast<unsigned char>(hi)) ||
+          (cu >= static_cast<unsigned char>(lo) && cu <= static_cast<unsigned char>(hi))) {
+        matched = true;
+      }
+    }
+    ++q;
+  }
+  if (q >= pattern.size()) {
+    return -1;
+  }
+  next = q + 1;
+  return matched != negate ? 1 : 0;
+}
+
+// glob_segment::match
+//  Matches directory entry name against the segment
+//  Names starting with '.' are matched only explicitly unless TEBAKO_GLOB_DOTMATCH
+//  is set
+bool glob_segment::match(std::string_view name) const
+{
+  bool noescape = (flags & TEBAKO_GLOB_NOESCAPE) != 0;
+
+  if (k == LITERAL) {
+    return name == literal;
+  }
+  if (name.empty()) {
+    return false;
+  }
+  if (name[0] == '.' && !(flags & TEBAKO_GLOB_DOTMATCH)) {
+    bool explicit_dot = (!pattern.empty() && pattern[0] == '.') ||
+                        (!noescape && pattern.size() > 1 && pattern[0] == '\\' && pattern[1] == '.');
+    if (!explicit_dot) {
+      return false;
+    }
+  }
+
+  // Iterative matching with backtracking to the last '*'
+  size_t p = 0;
+  size_t s = 0;
+  size_t star_p = std::string::npos;
+  size_t star_s = 0;
+  while (s < name.size()) {
+    if (p < pattern.size()) {
+      char c = pattern[p];
+      if (c == '*') {
+        star_p = ++p;
+        star_s = s;
+        continue;
+      }
+      if (c == '?') {
+        ++p;
+        ++s;
+        continue;
+      }
+      size_t next = p;
+      int res = (c == '[') ? match_bracket(p, name[s], next) : -1;
+      if (res == 1) {
+        p = next;
+        ++s;
+        continue;
+      }
+      if (res == -1) {
+        size_t q = p;
+        if (c == '\\' && !noescape && q + 1 < pattern.size()) {
+          ++q;
+        }
+        if (chars_equal(pattern[q], name[s])) {
+          p = q + 1;
+          ++s;
+          continue;
+        }
+      }
+    }
+    if (star_p == std::string::npos) {
+      return false;
+    }
+    p = star_p;
+    s = ++star_s;
+  }
+  while (p < pattern.size() && pattern[p] == '*') {
+    ++p;
+  }
+  return p == pattern.size();
+}
+
+// On Windows backslash is a path separator, so there is no escaping
+#ifdef _WIN32
+static const char* glob_separators = "/\\";
+#else
+static const char* glob_separators = "/";
+#endif
+
+// Checks if the path is the mount point or one of the directories above it
+// Their components are matched literally even with TEBAKO_GLOB_CASEFOLD, the
+// names below the memfs root are case-folded
+static bool on_mount_point(const std::string& path)
+{
+#ifdef _WIN32
+  const std::string mount_point = TEBAKO_MOUNT_POINT_S;
+  std::string p = path;
+  std::replace(p.begin(), p.end(), '\\', '/');
+#else
+  const std::string mount_point = TEBAKO_MOUNT_POINT;
+  const std::string& p = path;
+#endif
+  return !p.empty() && mount_point.compare(0, p.size(), p) == 0 &&
+         (p.size() == mount_point.size() || p.back() == '/' || mount_point[p.size()] == '/');
+}
+
+glob_pattern::glob_pattern(const std::string& pattern, int flgs) : trailing_slash(false), flags(flgs)
+{
+#ifdef _WIN32
+  flags |= TEBAKO_GLOB_NOESCAPE;
+#endif
+  std::vector<std::string> parts;
+  size_t start = 0;
+  while (start <= pattern.size()) {
+    size_t end = pattern.find_first_of(glob_separators, start);
+    if (end == std::string::npos) {
+      end = pattern.size();
+    }
+    if (end > start) {
+      parts.push_back(pattern.substr(start, end - start));
+    }
+    start = end + 1;
+  }
+
+  if (!pattern.empty() && strchr(glob_separators, pattern[0])) {
+    prefix = pattern.substr(0, 1);
+  }
+  trailing_slash = pattern.size() > 1 && strchr(glob_separators, pattern.back());
+
+  size_t i = 0;
+  for (; i < parts.size(); ++i) {
+    std::string next = prefix;
+    if (!next.empty() && !strchr(glob_separators, next.back())) {
+      next.push_back('/');
+    }
+    glob_segment segment(parts[i], flags);
+    if (segment.get_kind() != glob_segment::LITERAL && (flags & TEBAKO_GLOB_CASEFOLD)) {
+      glob_segment exact(parts[i], flags & ~TEBAKO_GLOB_CASEFOLD);
+      if (exact.get_kind() == glob_segment::LITERAL && on_mount_point(next + exact.get_literal())) {
+        segment = exact;
+      }
+    }
+    if (segment.get_kind() != glob_segment::LITERAL) {
+      break;
+    }
+    prefix = next + segment.get_literal();
+  }
+
+  for (; i < parts.size(); ++i) {
+    // Trailing '**' is the same as '*', consecutive '**' are the same as one
+    if (parts[i] == "**") {
+      if (i + 1 == parts.size()) {
+        segments.emplace_back("*", flags);
+        continue;
+      }
+      if (!segments.empty() && segments.back().get_kind() == glob_segment::RECURSIVE) {
+        continue;
+      }
+    }
+    segments.emplace_back(parts[i], flags);
+  }
+}
+
+std::vector<glob_pattern> glob_pattern::compile(const std::string& pattern, int flags)
+{
+  std::vector<std::string> expanded;
+#ifdef _WIN32
+  expand_braces(pattern, true, expanded);
+#else
+  expand_braces(pattern, (flags & TEBAKO_GLOB_NOESCAPE) != 0, expanded);
+#endif
+
+  std::vector<glob_pattern> compiled;
+  compiled.reserve(expanded.size());
+  for (const auto& p : expanded) {
+    compiled.emplace_back(p, flags);
+  }
+  return compiled;
+}
+
+// glob_pattern::expand_braces
+//  Expands the first top-level brace group and recurses for the rest
+//  "a{b,c{d,e}}f" --> "abf", "acdf", "acef"
+//  Unbalanced braces are kept as is
+void glob_pattern::expand_braces(const std::string& pattern, bool noescape, std::vector<std::string>& out)
+{
+  size_t open = std::string::npos;
+  size_t close = std::string::npos;
+  int depth = 0;
+  for (size_t i = 0; i < pattern.size() && close == std::string::npos; ++i) {
+    char c = pattern[i];
+    if (c == '\\' && !noescape) {
+      ++i;
+    }
+    else if (c == '{') {
+      if (depth++ == 0) {
+        open = i;
+      }
+    }
+    else if (c == '}' && depth > 0) {
+      if (--depth == 0) {
+        close = i;
+      }
+    }
+  }
+
+  if (close == std::string::npos) {
+    out.push_back(pattern);
+    return;
+  }
+
+  std::string head = pattern.substr(0, open);
+  std::string tail = pattern.substr(close + 1);
+  size_t start = open + 1;
+  depth = 0;
+  for (size_t i = open + 1; i <= close; ++i) {
+    char c = pattern[i];
+    if (c == '\\' && !noescape && i < close) {
+      ++i;
+    }
+    else if (c == '{') {
+      ++depth;
+    }
+    else if (c == '}' && depth > 0) {
+      --depth;
+    }
+    else if ((c == ',' && depth == 0) || i == close) {
+      expand_braces(head + pattern.substr(start, i - start) + tail, noescape, out);
+      start = i + 1;
+    }
+  }
+}
+
+}  // namespace tebako
@@ -0,0 +1,171 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <tebako-pch.h>
+#include <tebako-pch-pp.h>
+#include <tebako-common.h>
+#include <tebako-idle-trimmer.h>
+#include <tebako-memfs.h>
+#include <tebako-memfs-table.h>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace tebako {
+
+tebako_idle_trimmer& tebako_idle_trimmer::get_tebako_idle_trimmer(void)
+{
+  static tebako_idle_trimmer trimmer{};
+  return trimmer;
+}
+
+tebako_idle_trimmer::~tebako_idle_trimmer()
+{
+  stop();
+}
+
+uint64_t tebako_idle_trimmer::total_reads(void)
+{
+  uint64_t reads = 0;
+  for (const auto& fs : sync_tebako_memfs_table::get_tebako_memfs_table().get_all()) {
+    reads += fs->get_counters().get(tebako_cache_counters::reads);
+  }
+  return reads;
+}
+
+// tebako_idle_trimmer::resident_bytes
+//  Resident set size of the process (/proc/self/statm), 0 if it is not known
+uint64_t tebako_idle_trimmer::resident_bytes(void)
+{
+#if defined(__linux__)
+  std::ifstream statm("/proc/self/statm");
+  uint64_t size = 0, resident = 0;
+  if (statm >> size >> resident) {
+    return resident * static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+  }
+#endif
+  return 0;
+}
+
+static void apply_to_all_memfs(void)
+{
+  for (const auto& fs : sync_tebako_memfs_table::get_tebako_memfs_table().get_all()) {
+    fs->apply_cache_tidy();
+  }
+}
+
+void tebako_idle_trimmer::start(std::chrono::milliseconds max_age)
+{
+  stop();
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    max_age_ms = std::max(max_age.count(), static_cast<int64_t>(1));
+    stopping = false;
+    thread = std::thread(&tebako_idle_trimmer::run, this);
+  }
+  apply_to_all_memfs();
+}
+
+// tebako_idle_trimmer::stop
+//  Stops trimming; the block caches keep the blocks until they are full again
+void tebako_idle_trimmer::stop(void)
+{
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stopping = true;
+  }
+  cv.notify_all();
+  if (thread.joinable()) {
+    thread.join();
+  }
+  if (max_age_ms.exchange(0) != 0) {
+    apply_to_all_memfs();
+  }
+}
+
+// The timer checks every max_age: blocks evicted by the tidy threads during the
+// period are returned to the OS at the end of it
+void tebako_idle_trimmer::run(void)
+{
+  std::unique_lock<std::mutex> lock(mtx);
+  while (!stopping) {
+    cv.wait_for(lock, get_max_age(), [this] { return stopping; });
+    if (!stopping) {
+      lock.unlock();
+      check();
+      lock.lock();
+    }
+  }
+}
+
+uint64_t tebako_idle_trimmer::check(void)
+{
+  std::lock_guard<std::mutex> check_lock(check_mtx);
+  uint64_t reclaimed = 0;
+  uint64_t rss = 0;
+  uint64_t reads = total_reads();
+  bool idle = reads == last_reads;
+  last_reads = reads;
+  if (idle) {
+    uint64_t before = resident_bytes();
+    for (const auto& fs : sync_tebako_memfs_table::get_tebako_memfs_table().get_all()) {
+      reclaimed += fs->expire_chunk_cache();
+    }
+#if defined(__GLIBC__)
+    ::malloc_trim(0);
+#endif
+    uint64_t after = resident_bytes();
+    rss = before > after ? before - after : 0;
+  }
+
+  std::lock_guard<std::mutex> lock(mtx);
+  ++checks;
+  if (idle) {
+    ++trims;
+    bytes_reclaimed += reclaimed;
+    rss_reclaimed += rss;
+  }
+  return reclaimed;
+}
+
+tebako_idle_trimmer::stats tebako_idle_trimmer::get_stats(void)
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  stats st;
+  st.max_age = get_max_age();
+  st.enabled = st.max_age.count() > 0;
+  st.checks = checks;
+  st.trims = trims;
+  st.bytes_reclaimed = bytes_reclaimed;
+  st.rss_reclaimed = rss_reclaimed;
+  return st;
+}
+
+}  // namespace tebako
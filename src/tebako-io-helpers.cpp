@@ -30,6 +30,7 @@
 #include <tebako-pch.h>
 #include <tebako-pch-pp.h>
 #include <tebako-common.h>
+#include <tebako-mount-latch.h>
 
 char* tebako_path_assign(tebako_path_t out, const std::string& in)
 {
@@ -152,6 +153,7 @@ void tebako_drop_cwd(void)
 //	Gets current working directory
 const char* tebako_get_cwd(tebako_path_t cwd, bool win_separator)
 {
+  tebako::wait_for_mount();
   auto locked = tebako_cwd.rlock();
   return (*locked) ? (*locked)->get_cwd(cwd, win_separator) : "";
 }
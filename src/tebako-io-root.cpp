@@ -36,8 +36,15 @@
 #include <tebako-io-inner.h>
 #include <tebako-io-root.h>
 #include <tebako-fd.h>
+#include <tebako-cache-budget.h>
+#include <tebako-cache-sizer.h>
+#include <tebako-idle-trimmer.h>
+#include <tebako-memory-monitor.h>
+#include <tebako-thread-pool.h>
+#include <tebako-prefetch.h>
 #include <tebako-mfs.h>
 #include <tebako-memfs-table.h>
+#include <tebako-mount-latch.h>
 #include <tebako-mount-table.h>
 
 using namespace dwarfs;
@@ -46,6 +53,7 @@ namespace tebako {
 
 static void release_memfs_resources(void)
 {
+  sync_tebako_prefetch_table::get_tebako_prefetch_table().cancel_all();
 #if defined(TEBAKO_HAS_OPENDIR) || defined(RB_W32)
   sync_tebako_dstable::get_tebako_dstable().close_all();
 #endif
@@ -54,12 +62,12 @@ static void release_memfs_resources(void)
   tebako_drop_cwd();
 }
 
-static int load_memfs(const void* data, const unsigned int size, const char* image_offset)
+static int load_memfs(const void* data, const unsigned int size, const char* image_offset, const memfs_options& opts)
 {
   LOG_PROXY(debug_logger_policy, memfs::logger());
   LOG_INFO << PRJ_NAME << " mount memfs ";
 
-  int index = sync_tebako_memfs_table::get_tebako_memfs_table().insert_auto(std::make_shared<memfs>(data, size));
+  int index = sync_tebako_memfs_table::get_tebako_memfs_table().insert_auto(std::make_shared<memfs>(data, size, opts));
   auto fs = sync_tebako_memfs_table::get_tebako_memfs_table().get(index);
   if (fs != nullptr && fs->load(image_offset) != 0) {
     TEBAKO_SET_LAST_ERROR(ENOMEM);
@@ -80,9 +88,19 @@ int mount_memfs(const void* data,
                 const char* image_offset,
                 uint32_t parent_inode,
                 const char* folder)
+{
+  return mount_memfs(data, size, image_offset, parent_inode, folder, memfs::options());
+}
+
+int mount_memfs(const void* data,
+                const unsigned int size,
+                const char* image_offset,
+                uint32_t parent_inode,
+                const char* folder,
+                const memfs_options& opts)
 {
   bool res = false;
-  int index = load_memfs(data, size, image_offset);
+  int index = load_memfs(data, size, image_offset, opts);
   if (index != -1) {
     res = sync_tebako_mount_table::get_tebako_mount_table().insert(parent_inode, folder, index);
   }
@@ -99,6 +117,7 @@ int mount_root_memfs(const void* data,
                      const char* image_offset)
 {
   int ret = -1;
+  wait_for_mount();
   std::set_terminate([]() {
     std::cerr << "Unhandled exception" << std::endl;
     std::abort();
@@ -145,12 +164,74 @@ int mount_root_memfs(const void* data,
   return ret;
 }
 
+// mount_root_memfs_async
+//  Starts mount_root_memfs on a background thread and returns, so that loading
+//  the filesystem overlaps with the application startup (see tebako_mount_latch)
+// returns
+//  0 if the mount has been started, -1 otherwise [errno is set]
+//  The result of the mount is returned by mount_root_memfs_wait
+int mount_root_memfs_async(const void* data,
+                           const unsigned int size,
+                           const char* debuglevel,
+                           const char* cachesize,
+                           const char* workers,
+                           const char* mlock,
+                           const char* decompress_ratio,
+                           const char* image_offset)
+{
+  int ret = -1;
+  // The parameters may not outlive the call
+  auto arg = [](const char* s) { return s != nullptr ? std::optional<std::string>(s) : std::nullopt; };
+  auto c_str = [](const std::optional<std::string>& s) { return s ? s->c_str() : nullptr; };
+  try {
+    tebako_mount_latch::get_tebako_mount_latch().start(
+        [=, dl = arg(debuglevel), cs = arg(cachesize), wk = arg(workers), ml = arg(mlock), dr = arg(decompress_ratio),
+         io = arg(image_offset)]() {
+          return mount_root_memfs(data, size, c_str(dl), c_str(cs), c_str(wk), c_str(ml), c_str(dr), c_str(io));
+        });
+    ret = 0;
+  }
+  catch (...) {
+    TEBAKO_SET_LAST_ERROR(ENOMEM);
+  }
+  return ret;
+}
+
 void unmount_root_memfs(void)
 {
+  wait_for_mount();
   release_memfs_resources();
   sync_tebako_memfs_table::get_tebako_memfs_table().clear();
 }
 
+// prefetch_memfs
+//  Starts background prefetch of the manifest ranges of memfs #index
+// returns
+//  prefetch job (that can be waited for or cancelled) or nullptr [errno is set]
+std::shared_ptr<prefetch_job> prefetch_memfs(uint32_t index, const prefetch_manifest& manifest)
+{
+  std::shared_ptr<prefetch_job> job;
+  auto fs = sync_tebako_memfs_table::get_tebako_memfs_table().get(index);
+  if (fs == nullptr) {
+    TEBAKO_SET_LAST_ERROR(ENOENT);
+  }
+  else {
+    try {
+      // Manifest inodes are relative to the memfs root
+      prefetch_manifest ranges;
+      ranges.reserve(manifest.size());
+      for (const auto& r : manifest) {
+        ranges.push_back({r.inode + fs->get_root_inode(), r.offset, r.length});
+      }
+      job = prefetch_job::start(std::move(ranges));
+    }
+    catch (...) {
+      TEBAKO_SET_LAST_ERROR(ENOMEM);
+    }
+  }
+  return job;
+}
+
 int dwarfs_access(const std::string& path, int amode, uid_t uid, gid_t gid, std::string& lnk) noexcept
 {
   return root_memfs_call(&tebako::memfs::access, path, amode, uid, gid, lnk);
@@ -188,20 +269,51 @@ int dwarfs_inode_relative_stat(uint32_t inode,
 {
   return inode_memfs_call(&tebako::memfs::inode_relative_stat, inode, path, buf, lnk, follow);
 }
-ssize_t dwarfs_inode_read(uint32_t inode, void* buf, size_t size, off_t offset) noexcept
+ssize_t dwarfs_inode_read(uint32_t inode, void* buf, size_t size, off_t offset, bool stream) noexcept
 {
-  return inode_memfs_call(&tebako::memfs::inode_read, inode, buf, size, offset);
+  return inode_memfs_call(&tebako::memfs::inode_read, inode, buf, size, offset, stream);
+}
+bool dwarfs_inode_streamed(const struct stat* st) noexcept
+{
+  return inode_memfs_call(&tebako::memfs::inode_streamed, static_cast<uint32_t>(st->st_ino), st) == 1;
+}
+
+int dwarfs_inode_prefetch(uint32_t inode, uint64_t offset, uint64_t length, std::vector<char>& scratch) noexcept
+{
+  return inode_memfs_call(&tebako::memfs::inode_prefetch, inode, offset, length, scratch);
+}
+int dwarfs_inode_pin(uint32_t inode, bool pin) noexcept
+{
+  return pin ? inode_memfs_call(&tebako::memfs::inode_pin, inode)
+             : inode_memfs_call(&tebako::memfs::inode_unpin, inode);
 }
 int dwarfs_inode_readdir(uint32_t inode,
                          tebako::tebako_dirent* cache,
                          off_t cache_start,
                          size_t buffer_size,
                          size_t& cache_size,
-                         size_t& dir_size) noexcept
+                         size_t& dir_size,
+                         struct stat* stats) noexcept
 {
-  return inode_memfs_call(&tebako::memfs::inode_readdir, inode, cache, cache_start, buffer_size, cache_size, dir_size);
+  return inode_memfs_call(&tebako::memfs::inode_readdir, inode, cache, cache_start, buffer_size, cache_size, dir_size,
+                          stats);
+}
+int dwarfs_inode_walk(uint32_t inode, const walk_callback& fn, bool parallel) noexcept
+{
+  return inode_memfs_call(&tebako::memfs::inode_walk, inode, fn, parallel);
 }
 
+int dwarfs_inode_glob(uint32_t inode, const glob_pattern& pattern, std::string& path, const glob_callback& fn) noexcept
+{
+  return inode_memfs_call(&tebako::memfs::inode_glob, inode, pattern, path, fn);
+}
+#ifndef RB_W32
+int dwarfs_inode_getdents(uint32_t inode, void* buf, size_t size, uint64_t& pos) noexcept
+{
+  return inode_memfs_call(&tebako::memfs::inode_getdents, inode, buf, size, pos);
+}
+#endif
+
 }  // namespace tebako
 
 #ifdef __cplusplus
@@ -219,6 +331,24 @@ int mount_root_memfs(const void* data,
   return tebako::mount_root_memfs(data, size, debuglevel, cachesize, workers, mlock, decompress_ratio, image_offset);
 }
 
+int mount_root_memfs_async(const void* data,
+                           const unsigned int size,
+                           const char* debuglevel,
+                           const char* cachesize,
+                           const char* workers,
+                           const char* mlock,
+                           const char* decompress_ratio,
+                           const char* image_offset)
+{
+  return tebako::mount_root_memfs_async(data, size, debuglevel, cachesize, workers, mlock, decompress_ratio,
+                                        image_offset);
+}
+
+int mount_root_memfs_wait(void)
+{
+  return tebako::tebako_mount_latch::get_tebako_mount_latch().wait();
+}
+
 int mount_memfs_at_root(const void* data, const unsigned int size, const char* image_offset, const char* folder)
 {
   return tebako::mount_memfs(data, size, image_offset, folder);
@@ -233,10 +363,375 @@ int mount_memfs(const void* data,
   return tebako::mount_memfs(data, size, image_offset, parent_inode, folder);
 }
 
+int mount_memfs_with_options(const void* data,
+                             const unsigned int size,
+                             const char* image_offset,
+                             unsigned int parent_inode,
+                             const char* folder,
+                             const char* options)
+{
+  int ret = -1;
+  try {
+    ret = tebako::mount_memfs(data, size, image_offset, parent_inode, folder, tebako::memfs::parse_options(options));
+  }
+  catch (std::exception& e) {
+    LOG_PROXY(debug_logger_policy, tebako::memfs::logger());
+    LOG_ERROR << "Error: " << e.what();
+    TEBAKO_SET_LAST_ERROR(EINVAL);
+  }
+  return ret;
+}
+
 void unmount_root_memfs(void)
 {
   tebako::unmount_root_memfs();
 }
+
+int tebako_set_cache_budget(const char* budget)
+{
+  int ret = -1;
+  try {
+    tebako::sync_tebako_cache_budget::get_tebako_cache_budget().set_total(
+        budget != nullptr ? parse_size_with_unit(budget) : 0);
+    ret = 0;
+  }
+  catch (std::exception& e) {
+    LOG_PROXY(debug_logger_policy, tebako::memfs::logger());
+    LOG_ERROR << "Error: " << e.what();
+    TEBAKO_SET_LAST_ERROR(EINVAL);
+  }
+  return ret;
+}
+
+int tebako_prefetch_record(unsigned int seconds)
+{
+  auto fs = tebako::sync_tebako_memfs_table::get_tebako_memfs_table().get(0);
+  if (fs == nullptr) {
+    TEBAKO_SET_LAST_ERROR(ENOENT);
+    return -1;
+  }
+  fs->start_training(seconds);
+  return 0;
+}
+
+int tebako_prefetch_record_save(const char* path)
+{
+  int ret = -1;
+  auto fs = tebako::sync_tebako_memfs_table::get_tebako_memfs_table().get(0);
+  if (path == nullptr || fs == nullptr) {
+    TEBAKO_SET_LAST_ERROR(ENOENT);
+    return ret;
+  }
+  try {
+    auto buffer = tebako::package_descriptor::serialize_manifest(fs->get_training());
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (file && file.write(buffer.data(), buffer.size())) {
+      ret = 0;
+    }
+    else {
+      TEBAKO_SET_LAST_ERROR(EIO);
+    }
+  }
+  catch (...) {
+    TEBAKO_SET_LAST_ERROR(ENOMEM);
+  }
+  return ret;
+}
+
+int tebako_prefetch_manifest(const void* manifest, size_t size)
+{
+  int ret = -1;
+  if (manifest == nullptr) {
+    TEBAKO_SET_LAST_ERROR(EFAULT);
+    return ret;
+  }
+  try {
+    const char* p = static_cast<const char*>(manifest);
+    auto m = tebako::package_descriptor::deserialize_manifest(std::vector<char>(p, p + size));
+    auto job = tebako::prefetch_memfs(0, m);
+    if (job != nullptr) {
+      ret = tebako::sync_tebako_prefetch_table::get_tebako_prefetch_table().insert(job);
+    }
+  }
+  catch (std::exception& e) {
+    LOG_PROXY(debug_logger_policy, tebako::memfs::logger());
+    LOG_ERROR << "Error: " << e.what();
+    TEBAKO_SET_LAST_ERROR(EINVAL);
+  }
+  return ret;
+}
+
+// Sets the options of memfs mounted after the call (see memfs::set_option for the keys);
+// NULL arguments of tebako_set_* calls are passed as the defaults of memfs_options
+static int set_memfs_options(std::initializer_list<std::pair<const char*, const char*>> values)
+{
+  int ret = -1;
+  try {
+    tebako::memfs::set_options(values);
+    ret = 0;
+  }
+  catch (std::exception& e) {
+    LOG_PROXY(debug_logger_policy, tebako::memfs::logger());
+    LOG_ERROR << "Error: " << e.what();
+    TEBAKO_SET_LAST_ERROR(EINVAL);
+  }
+  return ret;
+}
+
+int tebako_set_disk_cache(const char* dir, const char* max_size)
+{
+  return set_memfs_options(
+      {{"disk_cache", dir != nullptr ? dir : ""}, {"disk_cache_size", max_size != nullptr ? max_size : "1G"}});
+}
+
+int tebako_set_shm_cache(const char* max_size)
+{
+  return set_memfs_options({{"shm_cache_size", max_size != nullptr ? max_size : "0"}});
+}
+
+int tebako_unlink_shm_cache(int index)
+{
+  int ret = -1;
+  if (index < 0) {
+    TEBAKO_SET_LAST_ERROR(ENOENT);
+  }
+  else {
+    ret = tebako::memfs_call(&tebako::memfs::unlink_shm_cache, index);
+  }
+  return ret;
+}
+
+void tebako_set_perfmon(int enable)
+{
+  tebako::memfs::set_perfmon(enable != 0);
+}
+
+int tebako_set_lazy_workers(int enable, const char* threshold)
+{
+  return set_memfs_options(
+      {{"lazy_workers", enable != 0 ? "1" : "0"}, {"lazy_threshold", threshold != nullptr ? threshold : "1M"}});
+}
+
+int tebako_set_eager(const char* mode)
+{
+  return set_memfs_options({{"eager", mode != nullptr ? mode : "0"}});
+}
+
+int tebako_set_stream(const char* threshold, const char* buffers)
+{
+  return set_memfs_options({{"stream_threshold", threshold != nullptr ? threshold : "0"},
+                            {"stream_buffers", buffers != nullptr ? buffers : "16M"}});
+}
+
+int tebako_set_cache_policy(const char* policy)
+{
+  return set_memfs_options({{"cache_policy", policy != nullptr ? policy : "dwarfs"}});
+}
+
+int tebako_perfmon_summary(int index, char* buf, size_t size)
+{
+  int ret = -1;
+  if (index < 0) {
+    TEBAKO_SET_LAST_ERROR(ENOENT);
+    return ret;
+  }
+  try {
+    std::ostringstream os;
+    if (tebako::memfs_call(&tebako::memfs::perfmon_summary, index, os) == DWARFS_IO_CONTINUE) {
+      std::string summary = os.str();
+      if (buf != nullptr && size > 0) {
+        size_t len = std::min(summary.size(), size - 1);
+        memcpy(buf, summary.data(), len);
+        buf[len] = '\0';
+      }
+      ret = static_cast<int>(summary.size());
+    }
+  }
+  catch (...) {
+    TEBAKO_SET_LAST_ERROR(ENOMEM);
+  }
+  return ret;
+}
+
+int tebako_get_cache_stats(int index, struct tebako_cache_stats* st)
+{
+  if (st == nullptr) {
+    TEBAKO_SET_LAST_ERROR(EFAULT);
+    return -1;
+  }
+  std::vector<std::shared_ptr<tebako::memfs>> all;
+  try {
+    if (index == -1) {
+      all = tebako::sync_tebako_memfs_table::get_tebako_memfs_table().get_all();
+    }
+    else if (index >= 0) {
+      auto fs = tebako::sync_tebako_memfs_table::get_tebako_memfs_table().get(index);
+      if (fs != nullptr) {
+        all.push_back(fs);
+      }
+    }
+  }
+  catch (...) {
+    TEBAKO_SET_LAST_ERROR(ENOMEM);
+    return -1;
+  }
+  if (all.empty() && index != -1) {
+    TEBAKO_SET_LAST_ERROR(ENOENT);
+    return -1;
+  }
+
+  using tebako::tebako_cache_counters;
+  memset(st, 0, sizeof(*st));
+  for (const auto& fs : all) {
+    const auto& counters = fs->get_counters();
+    st->reads += counters.get(tebako_cache_counters::reads);
+    st->bytes_read += counters.get(tebako_cache_counters::bytes_read);
+    st->read_time_ns += counters.get(tebako_cache_counters::read_time_ns);
+    st->blocks_released += counters.get(tebako_cache_counters::blocks_released);
+    st->released_bytes += counters.get(tebako_cache_counters::released_bytes);
+    st->disk_cache_hits += counters.get(tebako_cache_counters::disk_cache_hits);
+    st->disk_cache_misses += counters.get(tebako_cache_counters::disk_cache_misses);
+    st->shm_cache_hits += counters.get(tebako_cache_counters::shm_cache_hits);
+    st->shm_cache_misses += counters.get(tebako_cache_counters::shm_cache_misses);
+    st->pinned_hits += counters.get(tebako_cache_counters::pinned_hits);
+    st->pinned_bytes += fs->get_pinned_bytes();
+    st->pressure_shrinks += counters.get(tebako_cache_counters::pressure_shrinks);
+    st->huge_page_bytes += counters.get(tebako_cache_counters::huge_page_bytes);
+    st->eager_hits += counters.get(tebako_cache_counters::eager_hits);
+    st->eager_bytes += counters.get(tebako_cache_counters::eager_bytes);
+    st->eager_time_ns += counters.get(tebako_cache_counters::eager_time_ns);
+    st->stream_reads += counters.get(tebako_cache_counters::stream_reads);
+    st->stream_bytes += counters.get(tebako_cache_counters::stream_bytes);
+    st->chunk_cache_hits += counters.get(tebako_cache_counters::chunk_cache_hits);
+    st->chunk_cache_misses += counters.get(tebako_cache_counters::chunk_cache_misses);
+    st->chunk_cache_bytes += fs->get_chunk_cache_bytes();
+    st->chunk_cache_evictions += fs->get_chunk_cache_evictions();
+    st->cache_size += fs->get_cache_size();
+    st->workers += fs->get_workers();
+    st->workers_started += fs->get_workers_started();
+    st->memfs_count++;
+  }
+  return 0;
+}
+
+int tebako_get_cache_sizing(int index, struct tebako_cache_sizing* st)
+{
+  if (st == nullptr) {
+    TEBAKO_SET_LAST_ERROR(EFAULT);
+    return -1;
+  }
+  auto fs = index >= 0 ? tebako::sync_tebako_memfs_table::get_tebako_memfs_table().get(index) : nullptr;
+  if (fs == nullptr) {
+    TEBAKO_SET_LAST_ERROR(ENOENT);
+    return -1;
+  }
+  memset(st, 0, sizeof(*st));
+  st->cache_size = fs->get_cache_size();
+  auto sizer = fs->get_cache_sizer();
+  if (sizer != nullptr) {
+    auto sizing = fs->get_cache_sizing();
+    st->auto_mode = 1;
+    st->recommended = sizing.recommended > 0 ? sizing.recommended : st->cache_size;
+    st->min_size = sizer->get_min();
+    st->max_size = sizer->get_max();
+    st->target_hit_rate = sizer->get_target();
+    st->estimated_hit_rate = sizing.hit_rate;
+    st->sampled = sizer->get_sampled();
+    st->decisions = sizing.decisions;
+  }
+  return 0;
+}
+
+int tebako_set_memory_monitor(const char* cgroup_dir, unsigned int interval_ms)
+{
+  int ret = -1;
+  auto& monitor = tebako::tebako_memory_monitor::get_tebako_memory_monitor();
+  try {
+    if (cgroup_dir == nullptr) {
+      monitor.stop();
+    }
+    else {
+      std::string dir =
+          strcmp(cgroup_dir, "auto") == 0 ? tebako::tebako_memory_monitor::detect_cgroup_dir() : cgroup_dir;
+      monitor.start(dir, std::chrono::milliseconds(interval_ms > 0 ? interval_ms : 1000));
+    }
+    ret = 0;
+  }
+  catch (...) {
+    TEBAKO_SET_LAST_ERROR(ENOMEM);
+  }
+  return ret;
+}
+
+int tebako_get_memory_pressure(struct tebako_memory_pressure* st)
+{
+  if (st == nullptr) {
+    TEBAKO_SET_LAST_ERROR(EFAULT);
+    return -1;
+  }
+  auto stats = tebako::tebako_memory_monitor::get_tebako_memory_monitor().get_stats();
+  st->enabled = stats.enabled ? 1 : 0;
+  st->under_pressure = stats.under_pressure ? 1 : 0;
+  st->checks = stats.checks;
+  st->shrink_events = stats.shrink_events;
+  st->memory_current = stats.last.current;
+  st->memory_limit = stats.last.limit;
+  st->psi_some_avg10 = stats.last.psi_some_avg10;
+  return 0;
+}
+
+int tebako_set_idle_trim(unsigned int max_age_ms)
+{
+  int ret = -1;
+  auto& trimmer = tebako::tebako_idle_trimmer::get_tebako_idle_trimmer();
+  try {
+    if (max_age_ms == 0) {
+      trimmer.stop();
+    }
+    else {
+      trimmer.start(std::chrono::milliseconds(max_age_ms));
+    }
+    ret = 0;
+  }
+  catch (...) {
+    TEBAKO_SET_LAST_ERROR(ENOMEM);
+  }
+  return ret;
+}
+
+int tebako_get_idle_trim(struct tebako_idle_trim* st)
+{
+  if (st == nullptr) {
+    TEBAKO_SET_LAST_ERROR(EFAULT);
+    return -1;
+  }
+  auto stats = tebako::tebako_idle_trimmer::get_tebako_idle_trimmer().get_stats();
+  st->enabled = stats.enabled ? 1 : 0;
+  st->max_age_ms = static_cast<unsigned int>(stats.max_age.count());
+  st->checks = stats.checks;
+  st->trims = stats.trims;
+  st->bytes_reclaimed = stats.bytes_reclaimed;
+  st->rss_reclaimed = stats.rss_reclaimed;
+  return 0;
+}
+
+int tebako_get_pool_stats(struct tebako_pool_stats* st)
+{
+  if (st == nullptr) {
+    TEBAKO_SET_LAST_ERROR(EFAULT);
+    return -1;
+  }
+  auto stats = tebako::tebako_thread_pool::get_tebako_thread_pool().get_stats();
+  st->threads = stats.threads;
+  st->busy = stats.busy;
+  st->queue_depth = stats.queue_depth;
+  st->background_depth = stats.background_depth;
+  st->tasks_completed = stats.tasks_completed;
+  st->busy_time_ns = stats.busy_time_ns;
+  st->decompression_workers = stats.decompression_workers;
+  st->cpu_quota = stats.cpu_quota;
+  return 0;
+}
 #ifdef __cplusplus
 }
 #endif  // !__cplusplus
@@ -32,16 +32,27 @@
 #include <tebako-common.h>
 #include <tebako-dirent.h>
 #include <tebako-memfs.h>
+#include <tebako-cache-budget.h>
 #include <tebako-io.h>
 #include <tebako-io-inner.h>
 #include <tebako-mfs.h>
 #include <tebako-memfs-table.h>
+#include <tebako-mount-latch.h>
 #include <tebako-mount-table.h>
+#include <tebako-thread-pool.h>
 
 using namespace dwarfs;
 
 namespace tebako {
 
+// The singletons that memfs destructors use are constructed before the table, so
+// at exit they are destroyed after it, together with the memfs still mounted
+sync_tebako_memfs_table::sync_tebako_memfs_table()
+{
+  sync_tebako_cache_budget::get_tebako_cache_budget();
+  tebako_thread_pool::get_tebako_thread_pool();
+}
+
 sync_tebako_memfs_table& sync_tebako_memfs_table::get_tebako_memfs_table(void)
 {
   static sync_tebako_memfs_table memfs_table{};
@@ -50,6 +61,7 @@ sync_tebako_memfs_table& sync_tebako_memfs_table::get_tebako_memfs_table(void)
 
 bool sync_tebako_memfs_table::check(uint32_t index)
 {
+  wait_for_mount();
   auto p_memfs_table = s_tebako_memfs_table.rlock();
   auto p_memfs = p_memfs_table->find(index);
   return (p_memfs != p_memfs_table->end());
@@ -69,6 +81,7 @@ void sync_tebako_memfs_table::erase(uint32_t index)
 
 std::shared_ptr<memfs> sync_tebako_memfs_table::get(uint32_t index)
 {
+  wait_for_mount();
   auto p_memfs_table = s_tebako_memfs_table.rlock();
   auto p_memfs = p_memfs_table->find(index);
   if (p_memfs != p_memfs_table->end()) {
@@ -77,6 +90,17 @@ std::shared_ptr<memfs> sync_tebako_memfs_table::get(uint32_t index)
   return nullptr;
 }
 
+std::vector<std::shared_ptr<memfs>> sync_tebako_memfs_table::get_all(void)
+{
+  std::vector<std::shared_ptr<memfs>> all;
+  wait_for_mount();
+  auto p_memfs_table = s_tebako_memfs_table.rlock();
+  for (const auto& pair : *p_memfs_table) {
+    all.push_back(pair.second);
+  }
+  return all;
+}
+
 bool sync_tebako_memfs_table::insert(uint32_t index, std::shared_ptr<memfs> fs)
 {
   auto p_memfs_table = s_tebako_memfs_table.wlock();
@@ -34,6 +34,16 @@
 #include <tebako-memfs.h>
 #include <tebako-io.h>
 #include <tebako-io-inner.h>
+#include <tebako-glob.h>
+#include <tebako-cache-budget.h>
+#include <tebako-cache-sizer.h>
+#include <tebako-idle-trimmer.h>
+#include <tebako-memory-monitor.h>
+#include <tebako-thread-pool.h>
+#include <tebako-disk-cache.h>
+#include <tebako-shm-cache.h>
+#include <tebako-cache-policy.h>
+#include <tebako-chunk-cache.h>
 #include <tebako-mfs.h>
 #include <tebako-memfs-table.h>
 #include <tebako-mount-table.h>
@@ -42,14 +52,14 @@ using namespace dwarfs;
 
 namespace tebako {
 
-filesystem_options& operator<<(filesystem_options& fsopts, tebako::memfs_options& opts)
+filesystem_options& operator<<(filesystem_options& fsopts, const tebako::memfs_options& opts)
 {
   fsopts.lock_mode = opts.lock_mode;
   fsopts.block_cache.max_bytes = opts.cachesize;
   fsopts.block_cache.num_workers = opts.workers;
   fsopts.block_cache.decompress_ratio = opts.decompress_ratio;
   fsopts.block_cache.mm_release = !opts.cache_image;
-  fsopts.block_cache.init_workers = true;
+  fsopts.block_cache.init_workers = !opts.lazy_workers;
   fsopts.metadata.enable_nlink = bool(opts.enable_nlink);
   fsopts.metadata.readonly = bool(opts.readonly);
   return fsopts;
@@ -67,10 +77,83 @@ memfs_options& memfs::options()
   return opts;
 }
 
+// dwarfs performance monitor namespaces enabled by the perfmon option:
+// find, getattr, readdir, readlink and read timers of filesystem_v2 and the
+// inode reader below it
+static const std::unordered_set<std::string>& perfmon_namespaces(void)
+{
+  static const std::unordered_set<std::string> namespaces{"filesystem_v2", "inode_reader_v2"};
+  return namespaces;
+}
+
+// cachesize=auto decisions by image, applied when the image is mounted again
+// (dwarfs block cache size is fixed when filesystem_v2 is created)
+static folly::Synchronized<std::map<std::pair<const void*, unsigned int>, size_t>>& cache_size_hints(void)
+{
+  static folly::Synchronized<std::map<std::pair<const void*, unsigned int>, size_t>> hints;
+  return hints;
+}
+
 memfs::memfs(const void* dt, const unsigned int sz, uint32_t df_root_inode)
-    : data{dt}, size{sz}, dwarfs_root_inode(df_root_inode)
+    : memfs(dt, sz, options(), df_root_inode)
+{
+}
+
+memfs::memfs(const void* dt, const unsigned int sz, const memfs_options& opts, uint32_t df_root_inode)
+    : data{dt}, size{sz}, dwarfs_root_inode(df_root_inode), mopts(opts)
+{
+  fsopts << mopts;
+}
+
+memfs::~memfs()
+{
+  stop_eager();
+  release_budget();
+}
+
+// memfs::apply_budget_share
+//  Sizes the chunk cache to the share of the cache budget less the caches that
+//  cannot shrink on demand: dwarfs block cache (sized from the initial share when
+//  filesystem_v2 is created, a fixed part of the share), pinned files, streaming
+//  buffers and eager decompression
+//  Under memory pressure the chunk cache is shrunk to half of that
+//  Without a chunk cache (cache_policy=dwarfs and no budget) the share is cachesize
+//  and the block cache is all of it
+void memfs::apply_budget_share(void) noexcept
 {
-  fsopts << options();
+  if (chunk_cache) {
+    size_t fixed = block_cache_bytes.load() + pinned_bytes.load() + eager_bytes.load() +
+                   (p_stream.load() != nullptr ? mopts.stream_buffers : 0);
+    size_t share = budget_share.load();
+    size_t capacity = share > fixed ? share - fixed : 0;
+    chunk_cache->set_capacity(memory_pressure.load() ? capacity / 2 : capacity);
+  }
+}
+
+size_t memfs::get_chunk_cache_bytes(void) const
+{
+  return chunk_cache ? chunk_cache->get_bytes() : 0;
+}
+
+uint64_t memfs::get_chunk_cache_evictions(void) const
+{
+  return chunk_cache ? chunk_cache->get_evictions() : 0;
+}
+
+void memfs::release_budget(void)
+{
+  if (budget_id > 0) {
+    sync_tebako_cache_budget::get_tebako_cache_budget().release(budget_id);
+    budget_id = 0;
+  }
+  if (reserved_workers > 0) {
+    tebako_thread_pool::get_tebako_thread_pool().release_workers(reserved_workers);
+    reserved_workers = 0;
+  }
+  if (reserved_stream_workers > 0) {
+    tebako_thread_pool::get_tebako_thread_pool().release_workers(reserved_stream_workers);
+    reserved_stream_workers = 0;
+  }
 }
 
 int memfs::load(const char* image_offset)
@@ -79,20 +162,129 @@ int memfs::load(const char* image_offset)
 
   try {
     set_image_offset_str(image_offset);
-    fs = filesystem_v2(logger(), std::make_shared<tebako::mfs>(data, size), fsopts, dwarfs_root_inode, nullptr);
+    stop_eager();
+    p_flat = nullptr;
+    flat.reset();
+    p_stream = nullptr;
+    stream_fs.reset();
+    release_budget();
+    counters.reset();
+    s_pinned.wlock()->clear();
+    has_pins = false;
+    pinned_bytes = 0;
+    size_t cachesize = mopts.cachesize;
+    if (mopts.cachesize_auto) {
+      auto p_hints = cache_size_hints().rlock();
+      auto hint = p_hints->find(std::make_pair(data, size));
+      cachesize = hint != p_hints->end() ? hint->second : cachesize;
+      cachesize = std::max(std::min(cachesize, mopts.cachesize_max), mopts.cachesize_min);
+      if (!sizer) {
+        sizer = std::make_unique<tebako_cache_sizer>(mopts.cachesize_min, mopts.cachesize_max, mopts.target_hit_rate);
+      }
+    }
+    auto& cache_budget = sync_tebako_cache_budget::get_tebako_cache_budget();
+    std::string policy = mopts.cache_policy;
+    if (policy == "dwarfs" && (cache_budget.get().total > 0 || mopts.cachesize_auto)) {
+      // dwarfs block cache cannot follow the budget share or cachesize=auto decisions
+      policy = "lru";
+    }
+    chunk_cache.reset();
+    eager_bytes = 0;
+    block_cache_bytes = 0;
+    if (policy != "dwarfs") {
+      chunk_cache = std::make_unique<tebako_chunk_cache>(policy, cachesize);
+    }
+    size_t share;
+    budget_id = cache_budget.reserve(
+        cachesize,
+        [this](size_t s) {
+          budget_share = s;
+          apply_budget_share();
+        },
+        share);
+    fsopts.block_cache.max_bytes = share;
+    if (chunk_cache) {
+      // The chunk cache takes the share, dwarfs block cache keeps a small part of
+      // the initial one for the blocks being decompressed and read; it cannot be
+      // resized, so it is a fixed part of the share
+      static const size_t max_staging = static_cast<size_t>(16) << 20;
+      fsopts.block_cache.max_bytes = std::min(share / 4, max_staging);
+      block_cache_bytes = fsopts.block_cache.max_bytes;
+      cache_budget.set_fixed(budget_id, fsopts.block_cache.max_bytes);
+      share = cache_budget.get_share(budget_id);
+    }
+    budget_share = share;
+    apply_budget_share();
+    if (share < cachesize) {
+      LOG_INFO << "Cache is limited to " << share << " bytes by the global cache budget";
+    }
+    if (chunk_cache) {
+      LOG_INFO << "Chunk cache of " << chunk_cache->get_capacity() * tebako_chunk_cache::chunk_size << " bytes uses "
+               << policy << " replacement policy";
+    }
+    reserved_workers = tebako_thread_pool::get_tebako_thread_pool().reserve_workers(mopts.workers);
+    // A memfs granted no workers runs one that reads in the shared slot (see fs_read)
+    fsopts.block_cache.num_workers = std::max(reserved_workers, static_cast<size_t>(1));
+    if (reserved_workers < mopts.workers) {
+      LOG_INFO << "Decompression workers are limited to " << reserved_workers << " by the CPU quota";
+    }
+    perfmon = mopts.perfmon ? performance_monitor::create(perfmon_namespaces()) : nullptr;
+    workers_started = mopts.lazy_workers ? 0 : fsopts.block_cache.num_workers;
+    auto mm = std::make_shared<tebako::mfs>(data, size, &counters, mopts.madvise != 0);
+    image_mm = mm;
+    if (mopts.hugepages) {
+      size_t remapped = mm->use_huge_pages();
+      LOG_INFO << "Remapped " << remapped << " bytes of the image metadata onto huge pages";
+    }
+    fs = filesystem_v2(logger(), mm, fsopts, dwarfs_root_inode, perfmon);
     LOG_TIMED_INFO << "Filesystem initialized";
+    loaded = true;
+    memory_pressure = tebako_memory_monitor::get_tebako_memory_monitor().is_under_pressure();
+    apply_cache_tidy();
+
+    disk_cache.reset();
+    if (!mopts.disk_cache.empty()) {
+      try {
+        disk_cache = std::make_unique<tebako_disk_cache>(mopts.disk_cache, mopts.disk_cache_size, data, size);
+      }
+      catch (std::exception const& e) {
+        LOG_ERROR << "Disk cache at " << mopts.disk_cache << " is not used: " << e.what();
+      }
+    }
+
+    shm_cache.reset();
+    if (mopts.shm_cache_size > 0) {
+      try {
+        shm_cache =
+            std::make_unique<tebako_shm_cache>(mopts.shm_cache_size, tebako_disk_cache::image_identity(data, size));
+      }
+      catch (std::exception const& e) {
+        LOG_ERROR << "Shared memory cache is not used: " << e.what();
+      }
+    }
+
+    if (mopts.eager == 1) {
+      decompress_all();
+    }
+    else if (mopts.eager == 2) {
+      eager_stopping = false;
+      eager_thread = std::thread([this]() { decompress_all(); });
+    }
   }
 
   catch (stdfs::filesystem_error const& e) {
     LOG_ERROR << "Filesystem error: " << e.what();
+    release_budget();
     return -1;
   }
   catch (std::exception const& e) {
     LOG_ERROR << "Error: " << e.what();
+    release_budget();
     return -1;
   }
   catch (...) {
     LOG_ERROR << "Unexpected error";
+    release_budget();
     return -1;
   }
 
@@ -101,7 +293,7 @@ int memfs::load(const char* image_offset)
 
 void memfs::set_cachesize(const char* cachesize)
 {
-  options().cachesize = (cachesize != nullptr) ? parse_size_with_unit(cachesize) : (static_cast<size_t>(512) << 20);
+  set_option(options(), "cachesize", (cachesize != nullptr) ? cachesize : "512M");
 }
 
 void memfs::set_debuglevel(const char* debuglevel)
@@ -138,11 +330,210 @@ void memfs::set_lock_mode(const char* mlock)
   options().lock_mode = (mlock != nullptr) ? parse_mlock_mode(mlock) : mlock_mode::NONE;
 }
 
+void memfs::set_perfmon(bool enable)
+{
+  options().perfmon = enable ? 1 : 0;
+}
+
+// memfs::perfmon_summary
+//  Writes dwarfs performance monitor summary (samples, overall time and
+//  latency percentiles per operation)
+// returns
+//  DWARFS_IO_CONTINUE - success
+//  DWARFS_IO_ERROR - perfmon is not enabled for this memfs [errno is set]
+int memfs::perfmon_summary(std::ostream& os) const noexcept
+{
+  int ret = DWARFS_IO_ERROR;
+  if (!perfmon) {
+    TEBAKO_SET_LAST_ERROR(ENOTSUP);
+  }
+  else {
+    try {
+      perfmon->summarize(os);
+      ret = DWARFS_IO_CONTINUE;
+    }
+    catch (...) {
+      TEBAKO_SET_LAST_ERROR(ENOMEM);
+    }
+  }
+  return ret;
+}
+
+// memfs::unlink_shm_cache
+//  Removes the name of the shared memory segment used by this memfs, so that
+//  the processes started later create a new one
+// returns
+//  DWARFS_IO_CONTINUE - success
+//  DWARFS_IO_ERROR - the shared memory cache is not used or shm_unlink failed [errno is set]
+int memfs::unlink_shm_cache(void) noexcept
+{
+  int ret = DWARFS_IO_ERROR;
+  if (!shm_cache) {
+    TEBAKO_SET_LAST_ERROR(ENOENT);
+  }
+  else {
+    ret = tebako_shm_cache::unlink(shm_cache->get_identity());
+  }
+  return ret;
+}
+
 void memfs::set_workers(const char* workers)
 {
   options().workers = (workers != nullptr) ? folly::to<size_t>(workers) : 2;
 }
 
+// memfs::set_option
+//  Sets a single per-memfs option
+//  The keys of mount_root_memfs parameters and of tebako_set_* calls:
+//    cachesize             size, or "auto" (see memfs::evaluate_cache_size)
+//    cachesize_min         lower bound of cachesize=auto
+//    cachesize_max         upper bound of cachesize=auto
+//    target_hit_rate       hit rate cachesize=auto aims at (0.0 - 1.0]
+//    pressure_max_age      age (ms) of the blocks kept under memory pressure
+//    workers               number of dwarfs decompression workers
+//    lazy_workers          0/1, the workers are started on demand
+//    lazy_threshold        reads of this size or larger start all lazy workers
+//    mlock                 none, try or must
+//    decompress_ratio      dwarfs block cache decompress ratio [0.0 - 1.0]
+//    perfmon               0/1, dwarfs performance monitor
+//    madvise               0/1, page management hints over the image (see tebako::mfs)
+//    hugepages             0/1, image metadata on transparent huge pages
+//    eager                 0, 1 or mount, 2 or background (see memfs::decompress_all)
+//    stream_threshold      files of this size or larger bypass the block cache (0 - none)
+//    stream_buffers        block cache size of the reads that bypass it (see memfs::stream_read)
+//    cache_policy          dwarfs, lru, 2q or s3fifo (see tebako_chunk_cache)
+//    disk_cache            directory of the persistent disk cache ("" - none)
+//    disk_cache_size       size limit of the persistent disk cache
+//    shm_cache_size        size of the cross-process shared memory cache (0 - none)
+void memfs::set_option(memfs_options& opts, const std::string& key, const std::string& value)
+{
+  if (key == "cachesize") {
+    opts.cachesize_auto = value == "auto" ? 1 : 0;
+    if (!opts.cachesize_auto) {
+      opts.cachesize = parse_size_with_unit(value);
+    }
+  }
+  else if (key == "pressure_max_age") {
+    opts.pressure_max_age = std::chrono::milliseconds(folly::to<int64_t>(value));
+  }
+  else if (key == "cachesize_min") {
+    opts.cachesize_min = parse_size_with_unit(value);
+  }
+  else if (key == "cachesize_max") {
+    opts.cachesize_max = parse_size_with_unit(value);
+  }
+  else if (key == "target_hit_rate") {
+    double rate = folly::to<double>(value);
+    if (rate <= 0.0 || rate > 1.0) {
+      DWARFS_THROW(runtime_error, std::string("target_hit_rate must be between 0.0 and 1.0; got ") + value);
+    }
+    opts.target_hit_rate = rate;
+  }
+  else if (key == "workers") {
+    opts.workers = folly::to<size_t>(value);
+  }
+  else if (key == "lazy_workers") {
+    opts.lazy_workers = folly::to<bool>(value) ? 1 : 0;
+  }
+  else if (key == "lazy_threshold") {
+    opts.lazy_threshold = parse_size_with_unit(value);
+  }
+  else if (key == "mlock") {
+    opts.lock_mode = parse_mlock_mode(value);
+  }
+  else if (key == "decompress_ratio") {
+    double ratio = folly::to<double>(value);
+    if (ratio < 0.0 || ratio > 1.0) {
+      DWARFS_THROW(runtime_error, std::string("decratio must be between 0.0 and 1.0; got ") + value);
+    }
+    opts.decompress_ratio = ratio;
+  }
+  else if (key == "perfmon") {
+    opts.perfmon = folly::to<bool>(value) ? 1 : 0;
+  }
+  else if (key == "madvise") {
+    opts.madvise = folly::to<bool>(value) ? 1 : 0;
+  }
+  else if (key == "hugepages") {
+    opts.hugepages = folly::to<bool>(value) ? 1 : 0;
+  }
+  else if (key == "eager") {
+    if (value == "mount") {
+      opts.eager = 1;
+    }
+    else if (value == "background") {
+      opts.eager = 2;
+    }
+    else {
+      int eager = folly::to<int>(value);
+      if (eager < 0 || eager > 2) {
+        DWARFS_THROW(runtime_error, std::string("eager must be 0, 1 (mount) or 2 (background); got ") + value);
+      }
+      opts.eager = eager;
+    }
+  }
+  else if (key == "cache_policy") {
+    if (value != "dwarfs" && !tebako_cache_policy::is_valid_name(value)) {
+      DWARFS_THROW(runtime_error, "cache_policy must be dwarfs, lru, 2q or s3fifo; got " + value);
+    }
+    opts.cache_policy = value;
+  }
+  else if (key == "stream_threshold") {
+    opts.stream_threshold = parse_size_with_unit(value);
+  }
+  else if (key == "stream_buffers") {
+    opts.stream_buffers = parse_size_with_unit(value);
+  }
+  else if (key == "disk_cache") {
+    opts.disk_cache = value;
+  }
+  else if (key == "disk_cache_size") {
+    opts.disk_cache_size = parse_size_with_unit(value);
+  }
+  else if (key == "shm_cache_size") {
+    opts.shm_cache_size = parse_size_with_unit(value);
+  }
+  else {
+    DWARFS_THROW(runtime_error, std::string("unknown memfs option '") + key + "'");
+  }
+}
+
+// memfs::parse_options
+//  Parses per-memfs options like "cachesize=16M,workers=1"
+//  The options that are not specified are inherited from the global ones
+//  (set by mount_root_memfs)
+memfs_options memfs::parse_options(const char* spec)
+{
+  memfs_options opts = options();
+  if (spec != nullptr) {
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+      if (item.empty()) {
+        continue;
+      }
+      size_t eq = item.find('=');
+      if (eq == std::string::npos) {
+        DWARFS_THROW(runtime_error, std::string("memfs option '") + item + "' has no value");
+      }
+      set_option(opts, item.substr(0, eq), item.substr(eq + 1));
+    }
+  }
+  return opts;
+}
+
+// memfs::set_options
+//  Sets the global options (the ones of memfs mounted later) from key=value pairs
+//  (see memfs::set_option); the options are left unchanged if any value is invalid
+void memfs::set_options(std::initializer_list<std::pair<const char*, const char*>> values)
+{
+  memfs_options opts = options();
+  for (const auto& [key, value] : values) {
+    set_option(opts, key, value);
+  }
+  options() = std::move(opts);
+}
+
 // *** Now this is the core function ***
 //
 // memfs::find_inode
@@ -487,25 +878,672 @@ int memfs::inode_access(uint32_t inode, int amode, uid_t uid, gid_t gid) noexcep
   return ret;
 }
 
-ssize_t memfs::inode_read(uint32_t inode, void* buf, size_t size, off_t offset) noexcept
+ssize_t memfs::inode_read(uint32_t inode, void* buf, size_t size, off_t offset, bool stream) noexcept
 {
   int ret = DWARFS_IO_ERROR;
-  int err = fs.read(inode, static_cast<char*>(buf), size, offset);
+  auto started = std::chrono::steady_clock::now();
+  int err;
+  try {
+    size_t length;
+    const char* content = flat_content(inode, length);
+    auto pinned = (content == nullptr && has_pins.load(std::memory_order_relaxed)) ? get_pinned(inode) : nullptr;
+    if (content != nullptr) {
+      size_t n = static_cast<size_t>(offset) < length ? std::min(size, length - offset) : 0;
+      std::memcpy(buf, content + (n > 0 ? offset : 0), n);
+      counters.add(tebako_cache_counters::eager_hits, 1);
+      err = static_cast<int>(n);
+    }
+    else if (pinned) {
+      size_t n = static_cast<size_t>(offset) < pinned->size() ? std::min(size, pinned->size() - offset) : 0;
+      std::memcpy(buf, pinned->data() + (n > 0 ? offset : 0), n);
+      counters.add(tebako_cache_counters::pinned_hits, 1);
+      err = static_cast<int>(n);
+    }
+    else if (stream) {
+      err = stream_read(inode, static_cast<char*>(buf), size, offset);
+    }
+    else {
+      err = (disk_cache || shm_cache || chunk_cache) ? chunk_cache_read(inode, static_cast<char*>(buf), size, offset)
+                                                     : fs_read(inode, static_cast<char*>(buf), size, offset);
+    }
+  }
+  catch (...) {
+    err = -ENOMEM;
+  }
+  auto elapsed = std::chrono::steady_clock::now() - started;
+  counters.add(tebako_cache_counters::read_time_ns,
+               std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+  counters.add(tebako_cache_counters::reads, 1);
   if (err < 0) {
     TEBAKO_SET_LAST_ERROR(-err);
   }
   else {
+    counters.add(tebako_cache_counters::bytes_read, err);
+    if (training.load(std::memory_order_relaxed)) {
+      record_read(inode, offset, err);
+    }
+    if (sizer && sizer->record(inode, offset, err)) {
+      evaluate_cache_size();
+    }
     ret = err;
   }
   return ret;
 }
 
+// memfs::flat_content
+//  Content of a regular file in the eager arena
+// returns
+//  pointer to the content [length is set] or nullptr if the arena is not ready
+//  or the inode is not there
+const char* memfs::flat_content(uint32_t inode, size_t& length) const noexcept
+{
+  const flat_image* p = p_flat.load(std::memory_order_acquire);
+  if (p != nullptr) {
+    auto it = p->files.find(inode);
+    if (it != p->files.end()) {
+      length = it->second.second;
+      return p->data.get() + it->second.first;
+    }
+  }
+  return nullptr;
+}
+
+// memfs::decompress_all
+//  eager option: decompresses the content of all regular files into one flat
+//  read-only arena, so that reads are served by memcpy and never reach the block
+//  cache. This trades mount time (or a background burst) and the unpacked size of
+//  the image in memory for the lowest and most predictable read latency
+//  Files are read once in image data order by a temporary filesystem_v2 with a
+//  small block cache of its own (stream_buffers) and up to "workers" decompression
+//  workers (the part of the CPU quota that is not reserved), and by the same number
+//  of readers; the block cache of this memfs is not touched
+//  On failure the arena is dropped and reads go through the block cache as usual
+void memfs::decompress_all(void)
+{
+  static const size_t max_chunk = static_cast<size_t>(1) << 30;
+  LOG_PROXY(debug_logger_policy, logger());
+  auto started = std::chrono::steady_clock::now();
+  auto& pool = tebako_thread_pool::get_tebako_thread_pool();
+  size_t workers = 0;
+
+  try {
+    auto image = std::make_unique<flat_image>();
+    std::vector<std::pair<uint32_t, std::pair<size_t, size_t>>> files;
+    size_t total = 0;
+    fs.walk_data_order([&](dir_entry_view entry) {
+      auto iv = entry.inode();
+      if (S_ISREG(iv.mode())) {
+        uint32_t inode = iv.inode_num() + dwarfs_root_inode;
+        if (image->files.count(inode) == 0) {
+          struct stat st;
+          if (dwarfs_file_stat(iv, &st) != DWARFS_IO_CONTINUE) {
+            DWARFS_THROW(runtime_error, "getattr failed for inode " + std::to_string(inode));
+          }
+          image->files.emplace(inode, std::make_pair(total, static_cast<size_t>(st.st_size)));
+          files.emplace_back(inode, std::make_pair(total, static_cast<size_t>(st.st_size)));
+          total += static_cast<size_t>(st.st_size);
+        }
+      }
+    });
+    image->data = std::make_unique<char[]>(std::max(total, static_cast<size_t>(1)));
+
+    workers = pool.reserve_workers(mopts.workers);
+    filesystem_options eager_opts = fsopts;
+    eager_opts.block_cache.max_bytes = mopts.stream_buffers;
+    eager_opts.block_cache.num_workers = std::max(workers, static_cast<size_t>(1));
+    eager_opts.block_cache.init_workers = true;
+    eager_opts.block_cache.mm_release = true;
+    eager_bytes = total + eager_opts.block_cache.max_bytes;
+    apply_budget_share();
+    auto mm = std::make_shared<tebako::mfs>(*image_mm, nullptr, false);
+    filesystem_v2 eager_fs(logger(), mm, eager_opts, dwarfs_root_inode);
+
+    std::atomic<size_t> next{0};
+    std::atomic<int> err{0};
+    auto worker = [&]() {
+      size_t i;
+      while (err.load() == 0 && !eager_stopping.load() && (i = next++) < files.size()) {
+        auto& [inode, range] = files[i];
+        size_t done = 0;
+        while (done < range.second) {
+          auto slot = pool.share_worker(workers);
+          int r = eager_fs.read(inode, image->data.get() + range.first + done,
+                                std::min(range.second - done, max_chunk), done);
+          slot = {};
+          if (r <= 0) {
+            int expected = 0;
+            err.compare_exchange_strong(expected, r < 0 ? -r : EIO);
+            break;
+          }
+          done += r;
+        }
+      }
+    };
+    pool.parallel_run(std::min(workers, std::max(files.size(), static_cast<size_t>(1))) - 1, worker);
+    pool.release_workers(workers);
+    workers = 0;
+
+    if (eager_stopping.load()) {
+      eager_bytes = 0;
+      apply_budget_share();
+      return;
+    }
+    if (err.load() != 0) {
+      DWARFS_THROW(runtime_error, std::string("read failed: ") + std::strerror(err.load()));
+    }
+
+    auto elapsed = std::chrono::steady_clock::now() - started;
+    counters.add(tebako_cache_counters::eager_bytes, total);
+    counters.add(tebako_cache_counters::eager_time_ns,
+                 std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    flat = std::move(image);
+    p_flat.store(flat.get(), std::memory_order_release);
+    eager_bytes = total;
+    apply_budget_share();
+    LOG_INFO << "Decompressed " << files.size() << " files (" << total << " bytes) into the eager arena in "
+             << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() << " ms";
+  }
+  catch (std::exception const& e) {
+    LOG_ERROR << "Eager decompression is not used: " << e.what();
+  }
+  catch (...) {
+    LOG_ERROR << "Eager decompression is not used: unexpected error";
+  }
+  if (workers > 0) {
+    pool.release_workers(workers);
+  }
+  if (p_flat.load() == nullptr) {
+    eager_bytes = 0;
+    apply_budget_share();
+  }
+}
+
+void memfs::stop_eager(void)
+{
+  if (eager_thread.joinable()) {
+    eager_stopping = true;
+    eager_thread.join();
+  }
+  eager_stopping = false;
+}
+
+// memfs::inode_streamed
+//  Checks by its size (stat of the file being opened) if the reads of the file
+//  shall bypass the block cache; it is decided once on open, so that the reads
+//  do not look the inode up again
+// returns
+//  1 if the file is streamed, 0 otherwise
+int memfs::inode_streamed(uint32_t inode, const struct stat* st) const noexcept
+{
+  bool streamed = mopts.stream_threshold > 0 && S_ISREG(st->st_mode) &&
+                  static_cast<size_t>(st->st_size) >= mopts.stream_threshold;
+  return streamed ? 1 : 0;
+}
+
+// memfs::stream_read
+//  Reads large one-shot files (stream_threshold) and the files opened with O_DIRECT
+//  without admitting their blocks to the block cache, so that a single scan does not
+//  evict the hot blocks of the other files
+//  dwarfs block cache has no bypass, so these reads go through another filesystem_v2
+//  over the same image with a small block cache of its own (stream_buffers) that
+//  serves as a ring of decompressed blocks for sequential reads
+// returns
+//  number of bytes read or -errno like filesystem_v2::read
+int memfs::stream_read(uint32_t inode, char* buf, size_t size, off_t offset)
+{
+  LOG_PROXY(debug_logger_policy, logger());
+  filesystem_v2* sfs = p_stream.load(std::memory_order_acquire);
+  if (sfs == nullptr) {
+    std::lock_guard<std::mutex> lock(stream_mtx);
+    sfs = p_stream.load(std::memory_order_relaxed);
+    if (sfs == nullptr) {
+      auto& pool = tebako_thread_pool::get_tebako_thread_pool();
+      filesystem_options stream_opts = fsopts;
+      size_t workers = pool.reserve_workers(mopts.workers);
+      stream_opts.block_cache.max_bytes = mopts.stream_buffers;
+      stream_opts.block_cache.num_workers = std::max(workers, static_cast<size_t>(1));
+      stream_opts.block_cache.init_workers = true;
+      stream_opts.block_cache.mm_release = true;
+      try {
+        auto mm = std::make_shared<tebako::mfs>(*image_mm, nullptr, mopts.madvise != 0);
+        stream_fs = std::make_unique<filesystem_v2>(logger(), mm, stream_opts, dwarfs_root_inode);
+      }
+      catch (...) {
+        pool.release_workers(workers);
+        throw;
+      }
+      // Owned by this memfs only once stream_fs is built
+      reserved_stream_workers = workers;
+      sfs = stream_fs.get();
+      p_stream.store(sfs, std::memory_order_release);
+      apply_budget_share();
+      LOG_DEBUG << "Streaming reads use " << mopts.stream_buffers << " bytes of block cache and " << workers
+                << " worker(s)";
+    }
+  }
+  auto slot = tebako_thread_pool::get_tebako_thread_pool().share_worker(reserved_stream_workers);
+  int ret = sfs->read(inode, buf, size, offset);
+  slot = {};
+  if (ret >= 0) {
+    counters.add(tebako_cache_counters::stream_reads, 1);
+    counters.add(tebako_cache_counters::stream_bytes, ret);
+  }
+  return ret;
+}
+
+// memfs::fs_read
+//  filesystem_v2::read that starts the decompression workers on demand if
+//  lazy_workers is set: a short-lived process that reads a few small files does
+//  not pay for the whole worker group at mount
+//  dwarfs block cache has no inline decompression, so the reads below
+//  lazy_threshold are served by a single worker; the first larger read, or a read
+//  made while another one is in flight, starts all of them
+int memfs::fs_read(uint32_t inode, char* buf, size_t size, off_t offset)
+{
+  auto slot = tebako_thread_pool::get_tebako_thread_pool().share_worker(reserved_workers);
+  size_t all = fsopts.block_cache.num_workers;
+  if (workers_started.load(std::memory_order_acquire) < all) {
+    bool parallel = size >= mopts.lazy_threshold || lazy_reads.load(std::memory_order_relaxed) > 0;
+    start_workers(parallel ? all : 1);
+    std::shared_lock<std::shared_mutex> lock(workers_mtx);
+    if (workers_started.load(std::memory_order_relaxed) < all) {
+      ++lazy_reads;
+      int ret = fs.read(inode, buf, size, offset);
+      --lazy_reads;
+      return ret;
+    }
+  }
+  return fs.read(inode, buf, size, offset);
+}
+
+void memfs::start_workers(size_t count)
+{
+  LOG_PROXY(debug_logger_policy, logger());
+  if (workers_started.load(std::memory_order_acquire) >= count) {
+    return;
+  }
+  std::unique_lock<std::shared_mutex> lock(workers_mtx);
+  if (workers_started.load(std::memory_order_relaxed) < count) {
+    fs.set_num_workers(count);
+    workers_started.store(count, std::memory_order_release);
+    LOG_DEBUG << "Started " << count << " decompression worker(s) on demand";
+  }
+}
+
+// memfs::chunk_cache_read
+//  Reads file data through the shared memory and the persistent disk caches:
+//  the chunks found in shared memory are copied from the segment, the chunks
+//  found on disk are copied from their mappings (and shared), the others are read
+//  from dwarfs and stored in both
+// returns
+//  number of bytes read or -errno like filesystem_v2::read
+int memfs::chunk_cache_read(uint32_t inode, char* buf, size_t size, off_t offset, bool prefetch)
+{
+  static_assert(tebako_shm_cache::chunk_size == tebako_disk_cache::chunk_size, "cache chunk sizes shall match");
+  static_assert(tebako_chunk_cache::chunk_size == tebako_disk_cache::chunk_size, "cache chunk sizes shall match");
+  const size_t chunk_size = tebako_disk_cache::chunk_size;
+  uint32_t rel_inode = inode - dwarfs_root_inode;
+  size_t done = 0;
+  std::vector<char> scratch;
+  // Prefetch fills the caches without counting hits and misses
+  auto count = [&](tebako_cache_counters::counter c) {
+    if (!prefetch) {
+      counters.add(c, 1);
+    }
+  };
+
+  while (done < size) {
+    uint64_t pos = offset + done;
+    uint64_t chunk = pos / chunk_size;
+    size_t in_chunk = pos % chunk_size;
+    const char* data = nullptr;
+    size_t length;
+    size_t n;
+
+    bool hit = chunk_cache && chunk_cache->get(rel_inode, chunk, in_chunk, buf + done, size - done, length);
+    if (chunk_cache) {
+      count(hit ? tebako_cache_counters::chunk_cache_hits : tebako_cache_counters::chunk_cache_misses);
+    }
+    if (hit) {
+      // copied from the chunk cache
+    }
+    else if (shm_cache && shm_cache->get(rel_inode, chunk, in_chunk, buf + done, size - done, length)) {
+      count(tebako_cache_counters::shm_cache_hits);
+    }
+    else {
+      if (shm_cache) {
+        count(tebako_cache_counters::shm_cache_misses);
+      }
+      if (disk_cache && disk_cache->get(rel_inode, chunk, scratch, length)) {
+        count(tebako_cache_counters::disk_cache_hits);
+        data = scratch.data();
+      }
+      else {
+        if (disk_cache) {
+          count(tebako_cache_counters::disk_cache_misses);
+        }
+        scratch.resize(chunk_size);
+        int err = fs_read(inode, scratch.data(), chunk_size, chunk * chunk_size);
+        if (err < 0) {
+          return done > 0 ? static_cast<int>(done) : err;
+        }
+        length = err;
+        data = scratch.data();
+        if (disk_cache) {
+          disk_cache->put(rel_inode, chunk, data, length);
+        }
+      }
+      if (shm_cache) {
+        shm_cache->put(rel_inode, chunk, data, length);
+      }
+      if (chunk_cache) {
+        chunk_cache->put(rel_inode, chunk, data, length);
+      }
+    }
+
+    if (in_chunk >= length) {
+      break;  // end of file
+    }
+    n = std::min(length - in_chunk, size - done);
+    if (data != nullptr) {
+      std::memcpy(buf + done, data + in_chunk, n);
+    }
+    done += n;
+    if (length < chunk_size) {
+      break;  // the last chunk
+    }
+  }
+  return static_cast<int>(done);
+}
+
+// memfs::inode_prefetch
+//  Reads a range of file data into the scratch buffer, so that the blocks it
+//  covers are decompressed into the block cache ahead of demand (and stored in
+//  the chunk, shared memory and disk caches if they are used)
+//  Prefetch reads are not counted and not recorded by training
+int memfs::inode_prefetch(uint32_t inode, uint64_t offset, uint64_t length, std::vector<char>& scratch) noexcept
+{
+  static const size_t max_chunk = static_cast<size_t>(1) << 20;
+  int ret = DWARFS_IO_CONTINUE;
+  try {
+    uint64_t end = offset + length;
+    scratch.resize(static_cast<size_t>(std::min(length, static_cast<uint64_t>(max_chunk))));
+    while (offset < end) {
+      size_t chunk = std::min(static_cast<size_t>(end - offset), scratch.size());
+      int err = (disk_cache || shm_cache || chunk_cache) ? chunk_cache_read(inode, scratch.data(), chunk, offset, true)
+                                                         : fs_read(inode, scratch.data(), chunk, offset);
+      if (err <= 0) {
+        if (err < 0) {
+          TEBAKO_SET_LAST_ERROR(-err);
+          ret = DWARFS_IO_ERROR;
+        }
+        break;
+      }
+      offset += err;
+    }
+  }
+  catch (...) {
+    TEBAKO_SET_LAST_ERROR(ENOMEM);
+    ret = DWARFS_IO_ERROR;
+  }
+  return ret;
+}
+
+// memfs::inode_pin
+//  Decompresses a regular file completely and keeps its content in the pinned
+//  pool: reads of the file are served from it and do not touch the block cache,
+//  so bulk reads of other files cannot evict it
+//  Pinning a pinned file refreshes its content
+// returns
+//  DWARFS_IO_CONTINUE - success
+//  DWARFS_IO_ERROR - no such inode, not a regular file, read error [errno is set]
+int memfs::inode_pin(uint32_t inode) noexcept
+{
+  static const size_t max_chunk = static_cast<size_t>(1) << 30;
+  int ret = DWARFS_IO_ERROR;
+  try {
+    auto pi = fs.find(inode);
+    struct stat st;
+    if (!pi) {
+      TEBAKO_SET_LAST_ERROR(ENOENT);
+    }
+    else if (dwarfs_file_stat(*pi, &st) == DWARFS_IO_CONTINUE) {
+      if (!S_ISREG(st.st_mode)) {
+        TEBAKO_SET_LAST_ERROR(EINVAL);
+      }
+      else {
+        auto content = std::make_shared<std::vector<char>>(st.st_size);
+        size_t done = 0;
+        int err = 0;
+        while (done < content->size()) {
+          err = fs_read(inode, content->data() + done, std::min(content->size() - done, max_chunk), done);
+          if (err <= 0) {
+            break;
+          }
+          done += err;
+        }
+        if (err < 0) {
+          TEBAKO_SET_LAST_ERROR(-err);
+        }
+        else {
+          content->resize(done);
+          auto p_pinned = s_pinned.wlock();
+          auto& pinned = (*p_pinned)[inode];
+          if (pinned) {
+            pinned_bytes -= pinned->size();
+          }
+          pinned = std::move(content);
+          pinned_bytes += done;
+          has_pins = true;
+          ret = DWARFS_IO_CONTINUE;
+          apply_budget_share();
+        }
+      }
+    }
+  }
+  catch (...) {
+    TEBAKO_SET_LAST_ERROR(ENOMEM);
+  }
+  return ret;
+}
+
+// memfs::inode_unpin
+//  Drops the file from the pinned pool; readers that have started keep their copy
+// returns
+//  DWARFS_IO_CONTINUE - success
+//  DWARFS_IO_ERROR - the file is not pinned [errno is set]
+int memfs::inode_unpin(uint32_t inode) noexcept
+{
+  int ret = DWARFS_IO_ERROR;
+  auto p_pinned = s_pinned.wlock();
+  auto it = p_pinned->find(inode);
+  if (it == p_pinned->end()) {
+    TEBAKO_SET_LAST_ERROR(ENOENT);
+  }
+  else {
+    pinned_bytes -= it->second->size();
+    p_pinned->erase(it);
+    has_pins = !p_pinned->empty();
+    ret = DWARFS_IO_CONTINUE;
+    apply_budget_share();
+  }
+  return ret;
+}
+
+// memfs::set_memory_pressure
+//  Called by tebako_memory_monitor: under pressure the block cache sheds the
+//  blocks that have not been used for pressure_max_age (the recently used ones
+//  are the floor it shrinks to); when pressure clears, the cache regrows on demand
+//  up to its size
+void memfs::set_memory_pressure(bool pressure) noexcept
+{
+  if (memory_pressure.exchange(pressure) != pressure) {
+    if (pressure) {
+      counters.add(tebako_cache_counters::pressure_shrinks, 1);
+    }
+    apply_budget_share();
+    apply_cache_tidy();
+  }
+}
+
+// memfs::cache_max_age
+//  Age of the cached data to evict: the idle trim age (see tebako_idle_trimmer)
+//  and, under memory pressure, pressure_max_age if that is shorter; 0 - none
+std::chrono::milliseconds memfs::cache_max_age(void) const
+{
+  std::chrono::milliseconds max_age = tebako_idle_trimmer::get_tebako_idle_trimmer().get_max_age();
+  if (memory_pressure.load() && (max_age.count() == 0 || mopts.pressure_max_age < max_age)) {
+    max_age = mopts.pressure_max_age;
+  }
+  return max_age;
+}
+
+// memfs::expire_chunk_cache
+//  The chunk cache sweeps old data as new chunks are stored; an idle memfs
+//  stores none, so the idle trimmer drops it on its ticks
+// returns
+//  the number of bytes dropped
+size_t memfs::expire_chunk_cache(void) noexcept
+{
+  size_t dropped = 0;
+  if (loaded.load() && chunk_cache) {
+    std::chrono::milliseconds max_age = cache_max_age();
+    if (max_age.count() > 0) {
+      dropped = chunk_cache->expire(max_age);
+    }
+  }
+  return dropped;
+}
+
+// memfs::apply_cache_tidy
+//  dwarfs block cache cannot be shrunk to a size, its tidy thread evicting
+//  the blocks by age is used instead: the blocks not used for cache_max_age
+//  The chunk cache drops its data by the same age
+void memfs::apply_cache_tidy(void) noexcept
+{
+  LOG_PROXY(debug_logger_policy, logger());
+  if (!loaded.load()) {
+    return;
+  }
+  try {
+    std::chrono::milliseconds max_age = cache_max_age();
+    if (chunk_cache) {
+      chunk_cache->set_max_age(max_age);
+      expire_chunk_cache();
+    }
+    cache_tidy_config tidy;
+    if (max_age.count() > 0) {
+      tidy.strategy = cache_tidy_strategy::EXPIRY_TIME;
+      tidy.expiry_time = max_age;
+      tidy.interval = std::max(max_age / 4, std::chrono::milliseconds(100));
+    }
+    else {
+      tidy.strategy = cache_tidy_strategy::NONE;
+    }
+    fs.set_cache_tidy_config(tidy);
+  }
+  catch (std::exception const& e) {
+    LOG_ERROR << "Failed to set block cache tidy config: " << e.what();
+  }
+}
+
+// memfs::evaluate_cache_size
+//  Takes cachesize=auto decision: the cache size is changed if the estimate
+//  differs from the size in use by more than 1/8
+//  The decision is the new request of this memfs to the cache budget, so the
+//  chunk cache is resized at once (within the budget share); it is also the
+//  initial size when the image is mounted next time
+void memfs::evaluate_cache_size(void)
+{
+  LOG_PROXY(debug_logger_policy, logger());
+  try {
+    auto d = sizer->evaluate();
+    bool decided = false;
+    {
+      auto p_sizing = s_sizing.wlock();
+      size_t current = p_sizing->recommended > 0 ? p_sizing->recommended : get_cache_size();
+      p_sizing->hit_rate = d.hit_rate;
+      if (d.size > current + current / 8 || d.size + current / 8 < current) {
+        LOG_INFO << "Cache " << (d.size > current ? "grows" : "shrinks") << " from " << current << " to " << d.size
+                 << " bytes: estimated hit rate " << d.hit_rate << ", target " << sizer->get_target();
+        p_sizing->recommended = d.size;
+        p_sizing->decisions++;
+        (*cache_size_hints().wlock())[std::make_pair(data, size)] = d.size;
+        decided = true;
+      }
+    }
+    if (decided) {
+      sync_tebako_cache_budget::get_tebako_cache_budget().request(budget_id, d.size);
+    }
+  }
+  catch (...) {
+    // The decision is taken next time
+  }
+}
+
+std::shared_ptr<const std::vector<char>> memfs::get_pinned(uint32_t inode)
+{
+  auto p_pinned = s_pinned.rlock();
+  auto it = p_pinned->find(inode);
+  return it != p_pinned->end() ? it->second : nullptr;
+}
+
+// memfs::start_training
+//  Starts recording the ranges read during the next 'seconds' seconds
+//  (startup prefetch manifest); 0 stops recording
+void memfs::start_training(unsigned int seconds)
+{
+  auto p_training = s_training.wlock();
+  p_training->until = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+  p_training->ranges.clear();
+  p_training->last.clear();
+  training = seconds > 0;
+}
+
+prefetch_manifest memfs::get_training(void)
+{
+  return s_training.rlock()->ranges;
+}
+
+// memfs::record_read
+//  Records a range read during training in the order of the first touch
+//  Sequential reads of the same file are coalesced into one range
+void memfs::record_read(uint32_t inode, uint64_t offset, size_t length) noexcept
+{
+  try {
+    auto p_training = s_training.wlock();
+    if (std::chrono::steady_clock::now() > p_training->until) {
+      training = false;
+      return;
+    }
+    uint32_t rel_inode = inode - dwarfs_root_inode;
+    auto it = p_training->last.find(rel_inode);
+    if (it != p_training->last.end()) {
+      auto& r = p_training->ranges[it->second];
+      uint64_t r_end = r.offset + r.length;
+      if (offset >= r.offset && offset <= r_end) {
+        uint64_t end = std::max(r_end, offset + length);
+        if (end - r.offset <= UINT32_MAX) {
+          r.length = static_cast<uint32_t>(end - r.offset);
+          return;
+        }
+      }
+    }
+    p_training->ranges.push_back({rel_inode, offset, static_cast<uint32_t>(std::min(length, size_t(UINT32_MAX)))});
+    p_training->last[rel_inode] = p_training->ranges.size() - 1;
+  }
+  catch (...) {
+    // Training is best effort
+  }
+}
+
 int memfs::inode_readdir(uint32_t inode,
                          tebako_dirent* cache,
                          off_t cache_start,
                          size_t buffer_size,
                          size_t& cache_size,
-                         size_t& dir_size) noexcept
+                         size_t& dir_size,
+                         struct stat* stats) noexcept
 {
   int ret = -1;
   auto pi = fs.find(inode);
@@ -526,6 +1564,9 @@ int memfs::inode_readdir(uint32_t inode,
           std::string name(std::move(name_view));
           struct stat st;
           ret = dwarfs_file_stat(entry, &st);
+          if (stats) {
+            stats[cache_size] = st;
+          }
 
 #ifndef RB_W32
           cache[cache_size].e.d_ino = st.st_ino;
@@ -577,6 +1618,81 @@ int memfs::inode_readdir(uint32_t inode,
   return ret;
 }
 
+#ifndef RB_W32
+// memfs::inode_getdents
+//  Fills a buffer with getdents64-compatible records (struct tebako_dirent64)
+//  taken straight from directory metadata
+//  Unlike inode_readdir it does not call getattr for the entries
+//
+// params
+//  inode - directory inode
+//  buf - buffer to fill
+//  size - buffer size
+//  pos - in/out parameter, index of the first entry to read
+//
+// returns
+//  number of bytes written to the buffer, 0 at the end of directory
+//  DWARFS_IO_ERROR - error [errno is set]
+
+int memfs::inode_getdents(uint32_t inode, void* buf, size_t size, uint64_t& pos) noexcept
+{
+  int ret = DWARFS_IO_ERROR;
+  try {
+    auto pi = fs.find(inode);
+    if (!pi) {
+      TEBAKO_SET_LAST_ERROR(ENOENT);
+    }
+    else {
+      auto dir = fs.opendir(*pi);
+      if (!dir) {
+        TEBAKO_SET_LAST_ERROR(ENOTDIR);
+      }
+      else {
+        const size_t name_offset = offsetof(struct tebako_dirent64, d_name);
+        const size_t align = alignof(struct tebako_dirent64);
+        size_t dir_size = fs.dirsize(*dir);
+        size_t filled = 0;
+        while (pos < dir_size) {
+          auto res = fs.readdir(*dir, pos);
+          if (!res) {
+            break;
+          }
+          auto& [entry, name] = *res;
+          size_t reclen = (name_offset + name.length() + 1 + align - 1) & ~(align - 1);
+          if (filled + reclen > size) {
+            break;
+          }
+          auto rec = reinterpret_cast<struct tebako_dirent64*>(static_cast<char*>(buf) + filled);
+          rec->d_ino = entry.inode_num() + get_root_inode();
+          rec->d_off = ++pos;
+          rec->d_reclen = static_cast<unsigned short>(reclen);
+          rec->d_type = IFTODT(entry.mode());
+          memcpy(rec->d_name, name.data(), name.length());
+          rec->d_name[name.length()] = '\0';
+          filled += reclen;
+        }
+        if (filled == 0 && pos < dir_size) {
+          // [EINVAL] Result buffer is too small
+          TEBAKO_SET_LAST_ERROR(EINVAL);
+        }
+        else {
+          ret = static_cast<int>(filled);
+        }
+      }
+    }
+  }
+  catch (dwarfs::system_error const& e) {
+    TEBAKO_SET_LAST_ERROR(e.get_errno());
+    ret = DWARFS_IO_ERROR;
+  }
+  catch (...) {
+    TEBAKO_SET_LAST_ERROR(ENOMEM);
+    ret = DWARFS_IO_ERROR;
+  }
+  return ret;
+}
+#endif
+
 int memfs::inode_readlink(uint32_t inode, std::string& lnk) noexcept
 {
   int ret = DWARFS_IO_ERROR;
@@ -596,6 +1712,288 @@ int memfs::inode_readlink(uint32_t inode, std::string& lnk) noexcept
   return ret;
 }
 
+// memfs::inode_walk
+//  Walks the directory tree starting from inode (pre-order)
+//  Directory inodes are iterated directly, so there is no path resolution
+//  The walk does not follow symlinks and does not cross mount points
+//
+// params
+//  inode - directory inode to start from
+//  fn - callback, called for each entry with the path relative to the start
+//       directory. TEBAKO_WALK_PRUNE skips the subtree, any other non-zero
+//       value stops the walk
+//  parallel - walk the subtrees of the start directory on separate threads
+//             (fn shall be thread-safe then)
+//
+// returns
+//  0 - success
+//  DWARFS_IO_ERROR - error [errno is set]
+//  any other value - value returned by the callback that stopped the walk
+
+int memfs::inode_walk(uint32_t inode, const walk_callback& fn, bool parallel) noexcept
+{
+  int ret = DWARFS_IO_ERROR;
+  try {
+    auto pi = fs.find(inode);
+    if (!pi) {
+      TEBAKO_SET_LAST_ERROR(ENOENT);
+    }
+    else if (!S_ISDIR(pi->mode())) {
+      TEBAKO_SET_LAST_ERROR(ENOTDIR);
+    }
+    else {
+      std::string path;
+      path.reserve(TEBAKO_PATH_LENGTH);
+      if (!parallel) {
+        ret = walk_dir(*pi, path, 1, fn, nullptr, nullptr);
+      }
+      else {
+        walk_subtrees subtrees;
+        ret = walk_dir(*pi, path, 1, fn, nullptr, &subtrees);
+        if (ret == 0 && !subtrees.empty()) {
+          std::atomic<size_t> next{0};
+          std::atomic<int> result{0};
+          std::atomic<int> err{0};
+          auto& pool = tebako_thread_pool::get_tebako_thread_pool();
+          size_t n_threads = std::min(subtrees.size(), pool.get_size());
+
+          auto worker = [&]() {
+            std::string t_path;
+            t_path.reserve(TEBAKO_PATH_LENGTH);
+            size_t i;
+            while (result.load() == 0 && (i = next++) < subtrees.size()) {
+              int r = DWARFS_IO_ERROR;
+              try {
+                t_path = subtrees[i].second;
+                r = walk_dir(subtrees[i].first, t_path, 2, fn, &result, nullptr);
+                if (r == DWARFS_IO_ERROR) {
+                  err = errno;
+                }
+              }
+              catch (...) {
+                err = ENOMEM;
+              }
+              if (r != 0) {
+                int expected = 0;
+                result.compare_exchange_strong(expected, r);
+              }
+            }
+          };
+
+          pool.parallel_run(n_threads - 1, worker);
+          ret = result.load();
+          if (ret == DWARFS_IO_ERROR) {
+            TEBAKO_SET_LAST_ERROR(err.load());
+          }
+        }
+      }
+    }
+  }
+  catch (dwarfs::system_error const& e) {
+    TEBAKO_SET_LAST_ERROR(e.get_errno());
+    ret = DWARFS_IO_ERROR;
+  }
+  catch (...) {
+    TEBAKO_SET_LAST_ERROR(ENOMEM);
+    ret = DWARFS_IO_ERROR;
+  }
+  return ret;
+}
+
+// memfs::walk_dir
+//  Walks a single directory and (recursively) its subdirectories
+//  path is a reusable buffer; entry names are appended and removed in place
+//  If deferred is not null subdirectories are collected there instead of
+//  recursion
+int memfs::walk_dir(inode_view& dir_inode,
+                    std::string& path,
+                    int level,
+                    const walk_callback& fn,
+                    const std::atomic<int>* stop,
+                    walk_subtrees* deferred)
+{
+  int ret = 0;
+  auto dir = fs.opendir(dir_inode);
+  if (dir) {
+    size_t dir_size = fs.dirsize(*dir);
+    size_t path_length = path.length();
+    // Offsets 0 and 1 are '.' and '..'
+    for (size_t i = 2; i < dir_size && ret == 0 && !(stop && stop->load()); ++i) {
+      auto res = fs.readdir(*dir, i);
+      if (!res) {
+        break;
+      }
+      auto& [entry, name] = *res;
+      if (path_length > 0) {
+        path.push_back('/');
+      }
+      path.append(name.data(), name.length());
+
+      struct stat st;
+      if (dwarfs_file_stat(entry, &st) != 0) {
+        ret = DWARFS_IO_ERROR;
+      }
+      else {
+        ret = fn(path, &st, level);
+        if (ret == TEBAKO_WALK_PRUNE) {
+          ret = 0;
+        }
+        else if (ret == 0 && S_ISDIR(st.st_mode)) {
+          if (deferred) {
+            deferred->emplace_back(entry, path);
+          }
+          else {
+            ret = walk_dir(entry, path, level + 1, fn, stop, nullptr);
+          }
+        }
+      }
+      path.resize(path_length);
+    }
+  }
+  return ret;
+}
+
+// memfs::inode_glob
+//  Matches glob pattern segments against the directory tree starting from inode
+//  Literal segments are looked up by name, wildcard segments are matched against
+//  directory entries, '**' descends into subdirectories
+//  The glob does not follow symlinks and does not cross mount points
+//
+// params
+//  inode - directory inode that corresponds to the pattern prefix
+//  pattern - compiled pattern
+//  path - pattern prefix; matched names are appended to it
+//  fn - callback, called for each match; non-zero value stops the glob
+//
+// returns
+//  0 - success
+//  DWARFS_IO_ERROR - error [errno is set]
+//  any other value - value returned by the callback that stopped the glob
+
+int memfs::inode_glob(uint32_t inode, const glob_pattern& pattern, std::string& path, const glob_callback& fn) noexcept
+{
+  int ret = DWARFS_IO_ERROR;
+  try {
+    auto pi = fs.find(inode);
+    if (!pi) {
+      TEBAKO_SET_LAST_ERROR(ENOENT);
+    }
+    else if (!S_ISDIR(pi->mode())) {
+      TEBAKO_SET_LAST_ERROR(ENOTDIR);
+    }
+    else if (pattern.get_segments().empty()) {
+      ret = 0;
+    }
+    else {
+      ret = glob_dir(*pi, pattern, 0, path, fn);
+    }
+  }
+  catch (dwarfs::system_error const& e) {
+    TEBAKO_SET_LAST_ERROR(e.get_errno());
+    ret = DWARFS_IO_ERROR;
+  }
+  catch (...) {
+    TEBAKO_SET_LAST_ERROR(ENOMEM);
+    ret = DWARFS_IO_ERROR;
+  }
+  return ret;
+}
+
+// memfs::glob_dir
+//  Matches pattern segment [index] against the entries of a directory
+int memfs::glob_dir(inode_view& dir_inode,
+                    const glob_pattern& pattern,
+                    size_t index,
+                    std::string& path,
+                    const glob_callback& fn)
+{
+  int ret = 0;
+  const glob_segment& segment = pattern.get_segments()[index];
+  size_t path_length = path.length();
+  bool separator = path_length > 0 && path.back() != '/';
+
+  if (segment.get_kind() == glob_segment::LITERAL) {
+    auto pi = fs.find(dir_inode.inode_num() + get_root_inode(), segment.get_literal().c_str());
+    if (pi) {
+      if (separator) {
+        path.push_back('/');
+      }
+      path += segment.get_literal();
+      ret = glob_entry(*pi, pattern, index, path, fn);
+      path.resize(path_length);
+    }
+    return ret;
+  }
+
+  bool recursive = segment.get_kind() == glob_segment::RECURSIVE;
+  if (recursive) {
+    // '**' matches zero directories
+    ret = glob_dir(dir_inode, pattern, index + 1, path, fn);
+  }
+
+  auto dir = fs.opendir(dir_inode);
+  if (dir) {
+    size_t dir_size = fs.dirsize(*dir);
+    // Offsets 0 and 1 are '.' and '..'
+    for (size_t i = 2; i < dir_size && ret == 0; ++i) {
+      auto res = fs.readdir(*dir, i);
+      if (!res) {
+        break;
+      }
+      auto& [entry, name] = *res;
+      std::string_view entry_name(name.data(), name.length());
+      if (recursive) {
+        if (!S_ISDIR(entry.mode()) || (entry_name[0] == '.' && !pattern.dotmatch())) {
+          continue;
+        }
+      }
+      else if (!segment.match(entry_name)) {
+        continue;
+      }
+
+      if (separator) {
+        path.push_back('/');
+      }
+      path.append(entry_name.data(), entry_name.length());
+      ret = recursive ? glob_dir(entry, pattern, index, path, fn) : glob_entry(entry, pattern, index, path, fn);
+      path.resize(path_length);
+    }
+  }
+  return ret;
+}
+
+// memfs::glob_entry
+//  Processes directory entry that matched pattern segment [index]
+//  Reports it if this is the last segment, otherwise descends into it
+int memfs::glob_entry(inode_view& entry,
+                      const glob_pattern& pattern,
+                      size_t index,
+                      std::string& path,
+                      const glob_callback& fn)
+{
+  int ret = 0;
+  if (index + 1 < pattern.get_segments().size()) {
+    if (S_ISDIR(entry.mode())) {
+      ret = glob_dir(entry, pattern, index + 1, path, fn);
+    }
+  }
+  else if (!pattern.dirs_only() || S_ISDIR(entry.mode())) {
+    struct stat st;
+    if (dwarfs_file_stat(entry, &st) != 0) {
+      ret = DWARFS_IO_ERROR;
+    }
+    else if (pattern.dirs_only()) {
+      path.push_back('/');
+      ret = fn(path, &st);
+      path.pop_back();
+    }
+    else {
+      ret = fn(path, &st);
+    }
+  }
+  return ret;
+}
+
 // We are testing against owner permissions
 int memfs::i_access(int amode, struct stat* st)
 {
@@ -0,0 +1,217 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <tebako-pch.h>
+#include <tebako-pch-pp.h>
+#include <tebako-common.h>
+#include <tebako-memory-monitor.h>
+#include <tebako-memfs.h>
+#include <tebako-memfs-table.h>
+
+namespace tebako {
+
+tebako_memory_monitor& tebako_memory_monitor::get_tebako_memory_monitor(void)
+{
+  static tebako_memory_monitor monitor{};
+  return monitor;
+}
+
+tebako_memory_monitor::~tebako_memory_monitor()
+{
+  stop();
+}
+
+std::string tebako_memory_monitor::detect_cgroup_dir(void)
+{
+  std::string dir = "/sys/fs/cgroup";
+  std::ifstream cgroup("/proc/self/cgroup");
+  std::string line;
+  while (std::getline(cgroup, line)) {
+    // cgroup v2 entry is "0::<path>"
+    if (line.compare(0, 3, "0::") == 0) {
+      std::error_code ec;
+      stdfs::path p = stdfs::path(dir) / line.substr(4);
+      if (line.size() > 4 && stdfs::exists(p / "memory.current", ec)) {
+        dir = p.string();
+      }
+      break;
+    }
+  }
+  return dir;
+}
+
+// Reads a cgroup file holding a number or "max"; returns 0 for "max" or if it cannot be read
+static uint64_t read_limit(const stdfs::path& path, bool& ok)
+{
+  std::ifstream file(path);
+  std::string value;
+  ok = static_cast<bool>(file >> value);
+  if (ok && value != "max") {
+    try {
+      return std::stoull(value);
+    }
+    catch (...) {
+      ok = false;
+    }
+  }
+  return 0;
+}
+
+tebako_memory_monitor::sample tebako_memory_monitor::read_sample(const std::string& dir)
+{
+  sample s;
+  stdfs::path root(dir);
+  bool ok;
+  s.current = read_limit(root / "memory.current", ok);
+  s.valid = ok;
+  s.limit = read_limit(root / "memory.high", ok);
+  if (s.limit == 0) {
+    s.limit = read_limit(root / "memory.max", ok);
+  }
+
+  // some avg10=1.23 avg60=0.50 avg300=0.10 total=12345
+  std::ifstream pressure(root / "memory.pressure");
+  std::string kind, avg10;
+  if (pressure >> kind >> avg10 && kind == "some" && avg10.compare(0, 6, "avg10=") == 0) {
+    try {
+      s.psi_some_avg10 = std::stod(avg10.substr(6));
+    }
+    catch (...) {
+      // Malformed memory.pressure, PSI is not used
+    }
+  }
+  return s;
+}
+
+void tebako_memory_monitor::start(const std::string& d, std::chrono::milliseconds i)
+{
+  stop();
+  std::lock_guard<std::mutex> lock(mtx);
+  dir = d;
+  interval = i;
+  stopping = false;
+  thread = std::thread(&tebako_memory_monitor::run, this);
+}
+
+// tebako_memory_monitor::stop
+//  Stops watching; the caches that were shrunk are allowed to regrow
+void tebako_memory_monitor::stop(void)
+{
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stopping = true;
+  }
+  cv.notify_all();
+  if (thread.joinable()) {
+    thread.join();
+  }
+  std::lock_guard<std::mutex> lock(check_mtx);
+  if (under_pressure.exchange(false)) {
+    for (const auto& fs : sync_tebako_memfs_table::get_tebako_memfs_table().get_all()) {
+      fs->set_memory_pressure(false);
+    }
+  }
+  std::lock_guard<std::mutex> lock_dir(mtx);
+  dir.clear();
+}
+
+void tebako_memory_monitor::run(void)
+{
+  std::unique_lock<std::mutex> lock(mtx);
+  while (!stopping) {
+    lock.unlock();
+    check();
+    lock.lock();
+    cv.wait_for(lock, interval, [this] { return stopping; });
+  }
+}
+
+bool tebako_memory_monitor::check(void)
+{
+  LOG_PROXY(dwarfs::debug_logger_policy, memfs::logger());
+  std::lock_guard<std::mutex> check_lock(check_mtx);
+  std::string d;
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    d = dir;
+  }
+  if (d.empty()) {
+    return false;
+  }
+
+  sample s = read_sample(d);
+  bool pressure = under_pressure.load(std::memory_order_relaxed);
+  bool changed = false;
+  if (s.valid) {
+    if (!pressure) {
+      changed = (s.limit > 0 && s.current >= high_watermark * s.limit) || s.psi_some_avg10 >= psi_threshold;
+    }
+    else {
+      changed = (s.limit == 0 || s.current < low_watermark * s.limit) && s.psi_some_avg10 < psi_threshold / 2;
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    ++checks;
+    last = s;
+    if (changed && !pressure) {
+      ++shrink_events;
+    }
+  }
+
+  if (changed) {
+    pressure = !pressure;
+    under_pressure = pressure;
+    if (pressure) {
+      LOG_INFO << "Memory pressure: " << s.current << " of " << s.limit << " bytes, PSI some avg10 "
+               << s.psi_some_avg10 << "; shrinking block caches";
+    }
+    else {
+      LOG_INFO << "Memory pressure cleared: " << s.current << " of " << s.limit << " bytes";
+    }
+    for (const auto& fs : sync_tebako_memfs_table::get_tebako_memfs_table().get_all()) {
+      fs->set_memory_pressure(pressure);
+    }
+  }
+  return changed;
+}
+
+tebako_memory_monitor::stats tebako_memory_monitor::get_stats(void)
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  stats st;
+  st.enabled = !dir.empty();
+  st.under_pressure = under_pressure.load(std::memory_order_relaxed);
+  st.checks = checks;
+  st.shrink_events = shrink_events;
+  st.last = last;
+  return st;
+}
+
+}  // namespace tebako
@@ -29,7 +29,10 @@
 
 #include <tebako-pch.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cerrno>
+#include <fstream>
 
 #include <folly/portability/SysMman.h>
 #include <folly/portability/Unistd.h>
@@ -39,6 +42,230 @@
 
 namespace tebako {
 
+namespace {
+
+// dwarfs image format: section_header_v2 and the section index entries
+// ((section type << 48) | section offset in the image) that end the image
+const char section_magic[] = "DWARFS";
+const size_t section_header_size = mfs::section_header_size;
+const size_t section_type_offset = 52;
+const size_t section_length_offset = 56;
+const uint16_t section_block = 0;
+const uint16_t section_metadata_schema = 7;
+const uint16_t section_metadata = 8;
+const uint16_t section_index = 9;
+const uint64_t index_offset_mask = (static_cast<uint64_t>(1) << 48) - 1;
+const size_t max_index_entries = static_cast<size_t>(1) << 24;
+
+template <typename T>
+T load(const uint8_t* p)
+{
+  T v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+#if defined(MADV_COLD)
+std::atomic<bool> cold_supported{true};
+#endif
+
+// Checks if the address is in a mapping of a file
+bool is_file_mapping(uintptr_t a)
+{
+  bool ret = false;
+#ifdef __linux__
+  std::ifstream maps("/proc/self/maps");
+  std::string line;
+  while (std::getline(maps, line)) {
+    unsigned long start, end, inode;
+    char perms[8], dev[16];
+    unsigned long long off;
+    if (sscanf(line.c_str(), "%lx-%lx %7s %llx %15s %lu", &start, &end, perms, &off, dev, &inode) == 6 && a >= start &&
+        a < end) {
+      ret = inode != 0;
+      break;
+    }
+  }
+#endif
+  return ret;
+}
+
+}  // namespace
+
+mfs::mfs(const void* addr, size_t size, tebako_cache_counters* counters, bool advise)
+    : size_(size), addr_(addr), page_size_(sysconf(_SC_PAGESIZE)), counters_(counters), advise_(advise)
+{
+  find_sections();
+#ifndef _WIN32
+  if (advise_ && metadata_.second > 0) {
+    advise_range(metadata_.first, metadata_.second, MADV_WILLNEED);
+  }
+#endif
+  // Needed by advise_released only
+  if (advise_) {
+    file_backed_ = is_file_mapping(reinterpret_cast<uintptr_t>(addr_));
+  }
+}
+
+mfs::mfs(const mfs& mm, tebako_cache_counters* counters, bool advise)
+    : size_(mm.size_),
+      addr_(mm.addr_),
+      page_size_(mm.page_size_),
+      counters_(counters),
+      advise_(advise),
+      file_backed_(mm.file_backed_),
+      metadata_(mm.metadata_),
+      blocks_(mm.blocks_)
+{
+  if (advise_ && !mm.advise_) {
+    file_backed_ = is_file_mapping(reinterpret_cast<uintptr_t>(addr_));
+  }
+}
+
+// mfs::find_sections
+//  The last index entry points to the index section itself, the header of that
+//  section gives the offset of the image in the data (it is not known to mfs if
+//  image_offset is "auto"); the index is not required, without it there are no hints
+void mfs::find_sections(void)
+{
+  auto base = reinterpret_cast<const uint8_t*>(addr_);
+  if (size_ < section_header_size + sizeof(uint64_t)) {
+    return;
+  }
+  uint64_t last = load<uint64_t>(base + size_ - sizeof(uint64_t));
+  if ((last >> 48) != section_index) {
+    return;
+  }
+  size_t index_pos = 0;
+  size_t n_entries = 0;
+  for (size_t n = 1; n <= max_index_entries && n * sizeof(uint64_t) + section_header_size <= size_; ++n) {
+    size_t pos = size_ - n * sizeof(uint64_t) - section_header_size;
+    if (memcmp(base + pos, section_magic, sizeof(section_magic) - 1) == 0 &&
+        load<uint16_t>(base + pos + section_type_offset) == section_index &&
+        load<uint64_t>(base + pos + section_length_offset) == n * sizeof(uint64_t)) {
+      index_pos = pos;
+      n_entries = n;
+      break;
+    }
+  }
+  if (n_entries == 0 || index_pos < (last & index_offset_mask)) {
+    return;
+  }
+
+  size_t image_offset = index_pos - (last & index_offset_mask);
+  auto entries = base + index_pos + section_header_size;
+  for (size_t i = 0; i + 1 < n_entries; ++i) {
+    uint64_t e = load<uint64_t>(entries + i * sizeof(uint64_t));
+    size_t begin = image_offset + (e & index_offset_mask);
+    size_t end = image_offset + (load<uint64_t>(entries + (i + 1) * sizeof(uint64_t)) & index_offset_mask);
+    if (end <= begin || end > index_pos) {
+      blocks_.clear();
+      metadata_ = range{0, 0};
+      return;
+    }
+    switch (e >> 48) {
+      case section_block:
+        blocks_.emplace_back(begin, end - begin);
+        break;
+      case section_metadata_schema:
+      case section_metadata:
+        if (metadata_.second == 0) {
+          metadata_ = range{begin, end - begin};
+        }
+        else {
+          metadata_.second = end - metadata_.first;
+        }
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+// mfs::use_huge_pages
+//  The copy is made in a separate mapping and moved over the image by mremap, so
+//  the metadata is readable all the time (another memfs may use the same image)
+size_t mfs::use_huge_pages(void)
+{
+  size_t remapped = 0;
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  auto start = reinterpret_cast<uintptr_t>(addr_) + metadata_.first;
+  auto begin = (start + huge_page_size - 1) / huge_page_size * huge_page_size;
+  auto end = (start + metadata_.second) / huge_page_size * huge_page_size;
+  // An anonymous image may be a heap buffer, it is not remapped (neither is the one remapped already)
+  if (end <= begin || !is_file_mapping(begin)) {
+    return 0;
+  }
+  size_t len = end - begin;
+  void* p = ::mmap(nullptr, len + huge_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) {
+    return 0;
+  }
+  auto raw = reinterpret_cast<uintptr_t>(p);
+  auto aligned = (raw + huge_page_size - 1) / huge_page_size * huge_page_size;
+  if (aligned > raw) {
+    ::munmap(p, aligned - raw);
+  }
+  if (raw + huge_page_size > aligned) {
+    ::munmap(reinterpret_cast<void*>(aligned + len), raw + huge_page_size - aligned);
+  }
+  auto copy = reinterpret_cast<void*>(aligned);
+  // THP may be disabled, then the copy is backed by small pages and it is still correct
+  ::madvise(copy, len, MADV_HUGEPAGE);
+  memcpy(copy, reinterpret_cast<const void*>(begin), len);
+  if (::mprotect(copy, len, PROT_READ) != 0 ||
+      ::mremap(copy, len, len, MREMAP_MAYMOVE | MREMAP_FIXED, reinterpret_cast<void*>(begin)) == MAP_FAILED) {
+    ::munmap(copy, len);
+    return 0;
+  }
+  remapped = len;
+  if (counters_ != nullptr) {
+    counters_->add(tebako_cache_counters::huge_page_bytes, remapped);
+  }
+#endif
+  return remapped;
+}
+
+// mfs::advise_range
+//  madvise needs a page aligned address, the range is extended to the pages it touches
+void mfs::advise_range(size_t offset, size_t size, int advice) const
+{
+#ifndef _WIN32
+  auto addr = reinterpret_cast<uintptr_t>(addr_) + offset;
+  auto misalign = addr % page_size_;
+  ::madvise(reinterpret_cast<void*>(addr - misalign), size + misalign, advice);
+#endif
+}
+
+// mfs::advise_released
+//  Compressed data of a decompressed block is not needed any more, so its pages
+//  should not compete with the application heap for RSS; only the pages that are
+//  entirely within the block are released, the neighbour blocks share the others
+void mfs::advise_released(size_t offset, size_t size) const
+{
+#ifndef _WIN32
+  auto addr = reinterpret_cast<uintptr_t>(addr_) + offset;
+  auto begin = (addr + page_size_ - 1) / page_size_ * page_size_;
+  auto end = (addr + size) / page_size_ * page_size_;
+  if (end <= begin) {
+    return;
+  }
+  auto p = reinterpret_cast<void*>(begin);
+#if defined(MADV_COLD)
+  if (cold_supported.load(std::memory_order_relaxed)) {
+    if (::madvise(p, end - begin, MADV_COLD) == 0 || errno != EINVAL) {
+      return;
+    }
+    // Linux before 5.4
+    cold_supported = false;
+  }
+#endif
+  if (file_backed_) {
+    ::madvise(p, end - begin, MADV_DONTNEED);
+  }
+#endif
+}
+
 std::error_code mfs::lock(dwarfs::file_off_t offset, size_t size)
 {
   std::error_code ec;
@@ -49,9 +276,26 @@ std::error_code mfs::lock(dwarfs::file_off_t offset, size_t size)
   return ec;
 }
 
+// mfs::release
+//  Block cache releases the compressed data of a block when it has been
+//  decompressed completely, so this is where released blocks are counted
 std::error_code mfs::release(dwarfs::file_off_t offset, size_t size)
 {
   std::error_code ec;
+  if (counters_ != nullptr) {
+    counters_->add(tebako_cache_counters::blocks_released, 1);
+    counters_->add(tebako_cache_counters::released_bytes, size);
+  }
+#ifndef _WIN32
+  if (advise_) {
+    advise_released(offset, size);
+    // Blocks are mostly read in the image order, the next one is prefetched
+    auto next = std::upper_bound(blocks_.begin(), blocks_.end(), range{offset, SIZE_MAX});
+    if (next != blocks_.end()) {
+      advise_range(next->first, next->second, MADV_WILLNEED);
+    }
+  }
+#endif
   auto misalign = offset % page_size_;
 
   offset -= misalign;
@@ -87,8 +331,6 @@ size_t mfs::size() const
   return size_;
 }
 
-mfs::mfs(const void* addr, size_t size) : size_(size), addr_(addr), page_size_(sysconf(_SC_PAGESIZE)) {}
-
 std::filesystem::path const& mfs::path() const
 {
   static std::filesystem::path p("/__tebako_memfs__");
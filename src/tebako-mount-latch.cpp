@@ -0,0 +1,112 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <tebako-pch.h>
+#include <tebako-pch-pp.h>
+#include <tebako-common.h>
+#include <tebako-mount-latch.h>
+
+namespace tebako {
+
+// Set on the mounting thread, that must not wait for itself
+static thread_local bool mounting = false;
+
+tebako_mount_latch& tebako_mount_latch::get_tebako_mount_latch(void)
+{
+  static tebako_mount_latch latch{};
+  return latch;
+}
+
+tebako_mount_latch::~tebako_mount_latch()
+{
+  std::lock_guard<std::mutex> start_lock(start_mtx);
+  join();
+}
+
+void tebako_mount_latch::join(void)
+{
+  if (thread.joinable() && thread.get_id() != std::this_thread::get_id()) {
+    thread.join();
+  }
+}
+
+void tebako_mount_latch::start(std::function<int(void)> mount)
+{
+  std::lock_guard<std::mutex> start_lock(start_mtx);
+  wait();
+  join();
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    result = 0;
+    error = 0;
+    pending = true;
+  }
+  try {
+    thread = std::thread([this, mount]() {
+      mounting = true;
+      int ret = -1;
+      errno = 0;
+      try {
+        ret = mount();
+      }
+      catch (...) {
+        TEBAKO_SET_LAST_ERROR(ENOMEM);
+      }
+      int err = ret == 0 ? 0 : (errno != 0 ? errno : EINVAL);
+      mounting = false;
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        result = ret;
+        error = err;
+        pending = false;
+      }
+      cv.notify_all();
+    });
+  }
+  catch (...) {
+    std::lock_guard<std::mutex> lock(mtx);
+    pending = false;
+    throw;
+  }
+}
+
+int tebako_mount_latch::wait(void)
+{
+  if (mounting) {
+    return 0;
+  }
+  std::unique_lock<std::mutex> lock(mtx);
+  cv.wait(lock, [this] { return !pending.load(std::memory_order_relaxed); });
+  if (result != 0) {
+    TEBAKO_SET_LAST_ERROR(error);
+  }
+  return result;
+}
+
+}  // namespace tebako
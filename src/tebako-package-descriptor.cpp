@@ -33,6 +33,115 @@
 namespace tebako {
 
 const char* package_descriptor::signature = "TAMATEBAKO";
+const char* package_descriptor::manifest_signature = "TBKPREFETCH";
+const char* package_descriptor::pin_list_signature = "TBKPINLIST";
+
+// Reads the manifest that starts at offset; returns false if there is no
+// manifest signature there (old descriptors are followed by the image right away)
+static bool read_manifest(const std::vector<char>& buffer, size_t& offset, prefetch_manifest& m)
+{
+  size_t signature_length = std::strlen(package_descriptor::manifest_signature);
+  if (offset + signature_length > buffer.size() ||
+      std::memcmp(buffer.data() + offset, package_descriptor::manifest_signature, signature_length) != 0) {
+    return false;
+  }
+  offset += signature_length;
+
+  auto read_from_buffer = [&buffer, &offset](void* data, size_t size) {
+    if (offset + size > buffer.size()) {
+      throw std::out_of_range("Buffer too short for prefetch manifest");
+    }
+    std::memcpy(data, buffer.data() + offset, size);
+    offset += size;
+  };
+
+  uint32_t count;
+  read_from_buffer(&count, sizeof(count));
+  if (static_cast<uint64_t>(count) * (sizeof(uint32_t) + sizeof(uint64_t) + sizeof(uint32_t)) >
+      buffer.size() - offset) {
+    throw std::out_of_range("Buffer too short for prefetch manifest");
+  }
+  m.clear();
+  m.reserve(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    prefetch_range r;
+    read_from_buffer(&r.inode, sizeof(r.inode));
+    read_from_buffer(&r.offset, sizeof(r.offset));
+    read_from_buffer(&r.length, sizeof(r.length));
+    m.push_back(r);
+  }
+  return true;
+}
+
+static void write_manifest(std::vector<char>& buffer, const prefetch_manifest& m)
+{
+  auto append_to_buffer = [&buffer](const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    buffer.insert(buffer.end(), bytes, bytes + size);
+  };
+
+  append_to_buffer(package_descriptor::manifest_signature, std::strlen(package_descriptor::manifest_signature));
+  uint32_t count = static_cast<uint32_t>(m.size());
+  append_to_buffer(&count, sizeof(count));
+  for (const auto& r : m) {
+    append_to_buffer(&r.inode, sizeof(r.inode));
+    append_to_buffer(&r.offset, sizeof(r.offset));
+    append_to_buffer(&r.length, sizeof(r.length));
+  }
+}
+
+// Reads the pin list that starts at offset; returns false if there is no
+// pin list signature there
+static bool read_pin_list(const std::vector<char>& buffer, size_t& offset, std::vector<std::string>& p)
+{
+  size_t signature_length = std::strlen(package_descriptor::pin_list_signature);
+  if (offset + signature_length > buffer.size() ||
+      std::memcmp(buffer.data() + offset, package_descriptor::pin_list_signature, signature_length) != 0) {
+    return false;
+  }
+  offset += signature_length;
+
+  auto read_from_buffer = [&buffer, &offset](void* data, size_t size) {
+    if (offset + size > buffer.size()) {
+      throw std::out_of_range("Buffer too short for pin list");
+    }
+    std::memcpy(data, buffer.data() + offset, size);
+    offset += size;
+  };
+
+  uint32_t count;
+  read_from_buffer(&count, sizeof(count));
+  if (static_cast<uint64_t>(count) * sizeof(uint16_t) > buffer.size() - offset) {
+    throw std::out_of_range("Buffer too short for pin list");
+  }
+  p.clear();
+  p.reserve(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    uint16_t path_size;
+    read_from_buffer(&path_size, sizeof(path_size));
+    std::string path(path_size, '\0');
+    read_from_buffer(path.data(), path_size);
+    p.push_back(std::move(path));
+  }
+  return true;
+}
+
+static void write_pin_list(std::vector<char>& buffer, const std::vector<std::string>& p)
+{
+  auto append_to_buffer = [&buffer](const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    buffer.insert(buffer.end(), bytes, bytes + size);
+  };
+
+  append_to_buffer(package_descriptor::pin_list_signature, std::strlen(package_descriptor::pin_list_signature));
+  uint32_t count = static_cast<uint32_t>(p.size());
+  append_to_buffer(&count, sizeof(count));
+  for (const auto& path : p) {
+    uint16_t path_size = static_cast<uint16_t>(path.size());
+    append_to_buffer(&path_size, sizeof(path_size));
+    append_to_buffer(path.data(), path_size);
+  }
+}
 
 // Constructor for deserialization
 package_descriptor::package_descriptor(const std::vector<char>& buffer)
@@ -96,6 +205,18 @@ package_descriptor::package_descriptor(const std::vector<char>& buffer)
   else {
     cwd.reset();
   }
+
+  // Optional startup prefetch manifest
+  prefetch_manifest m;
+  if (read_manifest(buffer, offset, m)) {
+    manifest = std::move(m);
+  }
+
+  // Optional pin list
+  std::vector<std::string> p;
+  if (read_pin_list(buffer, offset, p)) {
+    pin_list = std::move(p);
+  }
 }
 
 // Constructor from version strings and other parameters
@@ -103,8 +224,9 @@ package_descriptor::package_descriptor(const std::string& ruby_version,
                                        const std::string& tebako_version,
                                        const std::string& mount_point,
                                        const std::string& entry_point,
-                                       const std::optional<std::string>& cwd)
-    : mount_point(mount_point), entry_point(entry_point), cwd(cwd)
+                                       const std::optional<std::string>& cwd,
+                                       const std::optional<prefetch_manifest>& manifest)
+    : mount_point(mount_point), entry_point(entry_point), cwd(cwd), manifest(manifest)
 {
   auto parse_version = [](const std::string& version, uint16_t& major, uint16_t& minor, uint16_t& patch) {
     std::stringstream ss(version);
@@ -156,7 +278,34 @@ std::vector<char> package_descriptor::serialize() const
     append_to_buffer(cwd->data(), cwd_size);
   }
 
+  // Append startup prefetch manifest if present
+  if (manifest) {
+    write_manifest(buffer, *manifest);
+  }
+
+  // Append pin list if present
+  if (pin_list) {
+    write_pin_list(buffer, *pin_list);
+  }
+
   return buffer;
 }
 
+std::vector<char> package_descriptor::serialize_manifest(const prefetch_manifest& m)
+{
+  std::vector<char> buffer;
+  write_manifest(buffer, m);
+  return buffer;
+}
+
+prefetch_manifest package_descriptor::deserialize_manifest(const std::vector<char>& buffer)
+{
+  size_t offset = 0;
+  prefetch_manifest m;
+  if (!read_manifest(buffer, offset, m)) {
+    throw std::invalid_argument("Invalid or missing prefetch manifest signature");
+  }
+  return m;
+}
+
 }  // namespace tebako
@@ -0,0 +1,188 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <tebako-pch.h>
+#include <tebako-pch-pp.h>
+#include <tebako-common.h>
+#include <tebako-dirent.h>
+#include <tebako-io-inner.h>
+#include <tebako-io-root.h>
+#include <tebako-prefetch.h>
+#include <tebako-thread-pool.h>
+
+namespace tebako {
+
+std::shared_ptr<prefetch_job> prefetch_job::start(prefetch_manifest ranges, size_t n_tasks)
+{
+  auto job = std::make_shared<prefetch_job>();
+  job->ranges = std::move(ranges);
+  job->total = job->ranges.size();
+  job->fan_out(job, n_tasks == 0 ? tebako_thread_pool::get_tebako_thread_pool().get_size() : n_tasks);
+  return job;
+}
+
+std::shared_ptr<prefetch_job> prefetch_job::start(collector collect, size_t n_tasks)
+{
+  auto job = std::make_shared<prefetch_job>();
+  {
+    std::lock_guard<std::mutex> lock(job->mtx);
+    ++job->running;
+  }
+  try {
+    tebako_thread_pool::get_tebako_thread_pool().submit_background([job, collect, n_tasks]() {
+      try {
+        collect(*job);
+      }
+      catch (...) {
+        // Prefetch whatever has been collected
+      }
+      // The collector task is one of the readers
+      job->total = job->ranges.size();
+      job->fan_out(job, (n_tasks == 0 ? tebako_thread_pool::get_tebako_thread_pool().get_size() : n_tasks) - 1);
+      job->run();
+      job->task_done();
+    });
+  }
+  catch (...) {
+    job->task_done();
+    throw;
+  }
+  return job;
+}
+
+void prefetch_job::add(uint32_t inode, uint64_t offset, uint64_t length)
+{
+  while (length > 0) {
+    uint32_t chunk = static_cast<uint32_t>(std::min(length, static_cast<uint64_t>(UINT32_MAX)));
+    ranges.push_back({inode, offset, chunk});
+    offset += chunk;
+    length -= chunk;
+  }
+}
+
+void prefetch_job::fan_out(const std::shared_ptr<prefetch_job>& self, size_t n_tasks)
+{
+  auto& pool = tebako_thread_pool::get_tebako_thread_pool();
+  n_tasks = std::min(n_tasks, ranges.size());
+
+  for (size_t i = 0; i < n_tasks; ++i) {
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      ++running;
+    }
+    try {
+      pool.submit_background([self]() {
+        self->run();
+        self->task_done();
+      });
+    }
+    catch (...) {
+      task_done();
+      break;
+    }
+  }
+}
+
+void prefetch_job::run(void)
+{
+  auto& pool = tebako_thread_pool::get_tebako_thread_pool();
+  std::vector<char> scratch;
+  size_t i;
+  while (!cancelled.load() && !pool.is_stopping() && (i = next++) < ranges.size()) {
+    const auto& r = ranges[i];
+    dwarfs_inode_prefetch(r.inode, r.offset, r.length, scratch);
+    ++completed;
+  }
+}
+
+void prefetch_job::task_done(void)
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  if (--running == 0) {
+    cv.notify_all();
+  }
+}
+
+bool prefetch_job::is_done(void)
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  return running == 0;
+}
+
+void prefetch_job::wait(void)
+{
+  std::unique_lock<std::mutex> lock(mtx);
+  cv.wait(lock, [this] { return running == 0; });
+}
+
+sync_tebako_prefetch_table& sync_tebako_prefetch_table::get_tebako_prefetch_table(void)
+{
+  static sync_tebako_prefetch_table prefetch_table{};
+  return prefetch_table;
+}
+
+int sync_tebako_prefetch_table::insert(std::shared_ptr<prefetch_job> job)
+{
+  auto p_table = s_table.wlock();
+  for (auto it = p_table->jobs.begin(); it != p_table->jobs.end();) {
+    if (it->second->is_done()) {
+      it = p_table->jobs.erase(it);
+    }
+    else {
+      ++it;
+    }
+  }
+  int handle = p_table->next_handle++;
+  p_table->jobs.emplace(handle, job);
+  return handle;
+}
+
+std::shared_ptr<prefetch_job> sync_tebako_prefetch_table::get(int handle, bool& found)
+{
+  auto p_table = s_table.rlock();
+  found = handle > 0 && handle < p_table->next_handle;
+  auto p_job = p_table->jobs.find(handle);
+  return p_job != p_table->jobs.end() ? p_job->second : nullptr;
+}
+
+void sync_tebako_prefetch_table::erase(int handle)
+{
+  s_table.wlock()->jobs.erase(handle);
+}
+
+void sync_tebako_prefetch_table::cancel_all(void)
+{
+  auto p_table = s_table.wlock();
+  for (auto& job : p_table->jobs) {
+    job.second->cancel();
+  }
+  p_table->jobs.clear();
+}
+
+}  // namespace tebako
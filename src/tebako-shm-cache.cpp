@@ -0,0 +1,383 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <tebako-pch.h>
+#include <tebako-pch-pp.h>
+#include <tebako-common.h>
+#include <tebako-shm-cache.h>
+
+#include <iomanip>
+
+#include <folly/hash/Hash.h>
+#include <folly/portability/Fcntl.h>
+#include <folly/portability/SysMman.h>
+#include <folly/portability/SysStat.h>
+#include <folly/portability/Unistd.h>
+
+#include <signal.h>
+
+namespace tebako {
+
+// The segment is used through the atomics by several processes
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared memory cache requires lock-free 64-bit atomics");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared memory cache requires lock-free 32-bit atomics");
+
+const char tebako_shm_cache::magic[8] = {'T', 'B', 'K', 'S', 'C', 'A', 'C', 'H'};
+
+std::string tebako_shm_cache::segment_name(uint64_t identity)
+{
+  // Short enough for Darwin (PSHMNAMLEN is 31)
+  std::stringstream name;
+  name << "/tbk-v" << format_version << "-" << std::hex << std::setw(16) << std::setfill('0') << identity;
+  return name.str();
+}
+
+size_t tebako_shm_cache::data_offset(size_t slot_count)
+{
+  static const size_t page = 4096;
+  size_t index_end = sizeof(segment_header) + slot_count * sizeof(slot);
+  return (index_end + page - 1) / page * page;
+}
+
+// Chunk numbers are limited to 32 bits (1 PiB files), key 0 marks an empty slot
+uint64_t tebako_shm_cache::make_key(uint32_t inode, uint64_t chunk)
+{
+  return chunk < 0xffffffff ? ((static_cast<uint64_t>(inode) << 32) | chunk) + 1 : 0;
+}
+
+bool tebako_shm_cache::is_alive(int32_t pid)
+{
+#ifdef _WIN32
+  return true;
+#else
+  return pid > 0 && (::kill(pid, 0) == 0 || errno == EPERM);
+#endif
+}
+
+#ifdef _WIN32
+tebako_shm_cache::tebako_shm_cache(uint64_t, uint64_t identity) : identity(identity)
+{
+  throw std::runtime_error("shared memory cache is not supported on Windows");
+}
+
+tebako_shm_cache::~tebako_shm_cache() {}
+
+int tebako_shm_cache::unlink(uint64_t) noexcept
+{
+  TEBAKO_SET_LAST_ERROR(ENOTSUP);
+  return DWARFS_IO_ERROR;
+}
+
+bool tebako_shm_cache::create(size_t)
+{
+  return false;
+}
+
+bool tebako_shm_cache::attach(void)
+{
+  return false;
+}
+
+void tebako_shm_cache::map(int, size_t) {}
+#else
+tebako_shm_cache::tebako_shm_cache(uint64_t max_bytes, uint64_t identity)
+    : identity(identity), name(segment_name(identity))
+{
+  size_t count = static_cast<size_t>(std::max<uint64_t>(max_bytes / chunk_size, max_probe));
+  count = std::min<size_t>(count, std::numeric_limits<uint32_t>::max());
+  // A segment abandoned by a crashed creator is removed and created again
+  for (int attempt = 0; attempt < 3 && addr == nullptr; ++attempt) {
+    if (!create(count)) {
+      attach();
+    }
+  }
+  if (addr == nullptr) {
+    throw std::runtime_error("failed to attach to shared memory segment " + name);
+  }
+}
+
+tebako_shm_cache::~tebako_shm_cache()
+{
+  if (addr != nullptr) {
+    if (header->attached.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      // The last process detaches; the name is removed unless it was unlinked
+      // and now refers to a segment created again by another process
+      int fd = ::shm_open(name.c_str(), O_RDONLY, 0600);
+      if (fd >= 0) {
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_ino == segment_ino) {
+          ::shm_unlink(name.c_str());
+        }
+        ::close(fd);
+      }
+    }
+    ::munmap(addr, mapped);
+  }
+}
+
+void tebako_shm_cache::map(int fd, size_t size)
+{
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    throw std::system_error(errno, std::generic_category(), "fstat " + name);
+  }
+  void* a = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (a == MAP_FAILED) {
+    throw std::system_error(errno, std::generic_category(), "mmap " + name);
+  }
+  segment_ino = st.st_ino;
+  addr = a;
+  mapped = size;
+  header = static_cast<segment_header*>(addr);
+  slots = reinterpret_cast<slot*>(static_cast<char*>(addr) + sizeof(segment_header));
+}
+
+// tebako_shm_cache::create
+//  Creates and initializes the segment unless it exists
+//  The memory of a new segment is zero-filled, so the slots start empty
+bool tebako_shm_cache::create(size_t count)
+{
+  int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0) {
+    if (errno == EEXIST) {
+      return false;
+    }
+    throw std::system_error(errno, std::generic_category(), "shm_open " + name);
+  }
+  size_t size = data_offset(count) + count * chunk_size;
+  try {
+    if (::ftruncate(fd, size) != 0) {
+      throw std::system_error(errno, std::generic_category(), "ftruncate " + name);
+    }
+    map(fd, size);
+  }
+  catch (...) {
+    ::close(fd);
+    ::shm_unlink(name.c_str());
+    throw;
+  }
+  ::close(fd);
+
+  header->creator_pid.store(::getpid(), std::memory_order_relaxed);
+  std::memcpy(header->magic, magic, sizeof(magic));
+  header->version = format_version;
+  header->slot_count = static_cast<uint32_t>(count);
+  header->identity = identity;
+  header->chunk_size = chunk_size;
+  header->attached.store(1, std::memory_order_relaxed);
+  header->ready.store(1, std::memory_order_release);
+  slot_count = count;
+  creator = true;
+  return true;
+}
+
+// tebako_shm_cache::attach
+//  Attaches to the segment created by another process; waits until the creator
+//  has initialized it
+//  A segment that another user could have created or written to is rejected
+// returns
+//  false if the segment has disappeared, was abandoned by its creator (it is unlinked then)
+//  or is being detached by the last process
+bool tebako_shm_cache::attach(void)
+{
+  int fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+  if (fd < 0) {
+    if (errno == ENOENT) {
+      return false;
+    }
+    throw std::system_error(errno, std::generic_category(), "shm_open " + name);
+  }
+
+  bool ok = false;
+  bool abandoned = false;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+  try {
+    struct stat owner;
+    if (::fstat(fd, &owner) != 0) {
+      throw std::system_error(errno, std::generic_category(), "fstat " + name);
+    }
+    if (owner.st_uid != ::geteuid() || (owner.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+      throw std::runtime_error("shared memory segment " + name +
+                               " is not owned by the current user or is writable by others");
+    }
+    while (!ok && !abandoned) {
+      struct stat st;
+      if (::fstat(fd, &st) != 0) {
+        throw std::system_error(errno, std::generic_category(), "fstat " + name);
+      }
+      if (addr == nullptr && static_cast<size_t>(st.st_size) >= data_offset(0)) {
+        map(fd, st.st_size);
+      }
+      if (addr != nullptr && header->ready.load(std::memory_order_acquire) != 0) {
+        ok = true;
+      }
+      else if (std::chrono::steady_clock::now() > deadline) {
+        int32_t pid = addr != nullptr ? header->creator_pid.load(std::memory_order_relaxed) : 0;
+        if (is_alive(pid)) {
+          throw std::runtime_error("shared memory segment " + name + " is not initialized by its creator");
+        }
+        abandoned = true;
+      }
+      else {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+  }
+  catch (...) {
+    ::close(fd);
+    throw;
+  }
+  ::close(fd);
+
+  if (ok) {
+    ok = std::memcmp(header->magic, magic, sizeof(magic)) == 0 && header->version == format_version &&
+         header->identity == identity && header->chunk_size == chunk_size &&
+         data_offset(header->slot_count) + header->slot_count * chunk_size <= mapped;
+    if (!ok) {
+      throw std::runtime_error("shared memory segment " + name + " has unexpected format");
+    }
+    slot_count = header->slot_count;
+    // The count is not raised from 0: the last process is detaching and unlinks the name
+    uint32_t n = header->attached.load(std::memory_order_relaxed);
+    while (n != 0 && !header->attached.compare_exchange_weak(n, n + 1, std::memory_order_acq_rel)) {
+    }
+    if (n == 0) {
+      ::munmap(addr, mapped);
+      addr = nullptr;
+      ok = false;
+      std::this_thread::yield();
+    }
+  }
+  else {
+    if (addr != nullptr) {
+      ::munmap(addr, mapped);
+      addr = nullptr;
+    }
+    ::shm_unlink(name.c_str());
+  }
+  return ok;
+}
+
+int tebako_shm_cache::unlink(uint64_t identity) noexcept
+{
+  int ret = DWARFS_IO_CONTINUE;
+  if (::shm_unlink(segment_name(identity).c_str()) != 0) {
+    ret = DWARFS_IO_ERROR;
+    TEBAKO_SET_LAST_ERROR(errno);
+  }
+  return ret;
+}
+#endif
+
+bool tebako_shm_cache::get(uint32_t inode,
+                           uint64_t chunk,
+                           size_t in_chunk,
+                           char* buf,
+                           size_t size,
+                           size_t& length) noexcept
+{
+  uint64_t key = make_key(inode, chunk);
+  if (key == 0) {
+    return false;
+  }
+  size_t base = folly::hash::twang_mix64(key) % slot_count;
+  for (size_t i = 0; i < std::min(max_probe, slot_count); ++i) {
+    size_t index = (base + i) % slot_count;
+    slot& s = slots[index];
+    uint64_t seq = s.seq.load(std::memory_order_acquire);
+    if ((seq & 1) != 0 || s.key.load(std::memory_order_relaxed) != key) {
+      continue;
+    }
+    size_t len = s.length.load(std::memory_order_relaxed);
+    if (len > chunk_size) {
+      continue;
+    }
+    size_t n = in_chunk < len ? std::min(size, len - in_chunk) : 0;
+    std::memcpy(buf, chunk_data(index) + in_chunk, n);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (s.seq.load(std::memory_order_relaxed) != seq) {
+      return false;  // evicted while copied
+    }
+    s.tick.store(header->clock.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    length = len;
+    return true;
+  }
+  return false;
+}
+
+void tebako_shm_cache::put(uint32_t inode, uint64_t chunk, const char* data, size_t length) noexcept
+{
+  uint64_t key = make_key(inode, chunk);
+  if (key == 0 || length > chunk_size) {
+    return;
+  }
+  size_t base = folly::hash::twang_mix64(key) % slot_count;
+  slot* victim = nullptr;
+  uint64_t victim_seq = 0;
+  uint64_t oldest = std::numeric_limits<uint64_t>::max();
+
+  for (size_t i = 0; i < std::min(max_probe, slot_count); ++i) {
+    slot& s = slots[(base + i) % slot_count];
+    uint64_t seq = s.seq.load(std::memory_order_acquire);
+    uint64_t tick;
+    if ((seq & 1) != 0) {
+      if (is_alive(s.writer.load(std::memory_order_relaxed))) {
+        continue;  // being written
+      }
+      tick = 0;  // the writer has crashed
+    }
+    else {
+      uint64_t k = s.key.load(std::memory_order_relaxed);
+      if (k == key) {
+        return;  // cached by another process meanwhile
+      }
+      tick = k == 0 ? 0 : s.tick.load(std::memory_order_relaxed);
+    }
+    if (tick < oldest) {
+      oldest = tick;
+      victim = &s;
+      victim_seq = seq;
+    }
+  }
+
+  if (victim != nullptr) {
+    uint64_t claimed = victim_seq + ((victim_seq & 1) != 0 ? 2 : 1);
+    if (victim->seq.compare_exchange_strong(victim_seq, claimed, std::memory_order_acq_rel)) {
+      victim->writer.store(::getpid(), std::memory_order_relaxed);
+      victim->key.store(key, std::memory_order_relaxed);
+      std::memcpy(chunk_data(victim - slots), data, length);
+      victim->length.store(static_cast<uint32_t>(length), std::memory_order_relaxed);
+      victim->tick.store(header->clock.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      victim->seq.store(claimed + 1, std::memory_order_release);
+    }
+    // else: claimed by another process, the chunk is not cached this time
+  }
+}
+
+}  // namespace tebako
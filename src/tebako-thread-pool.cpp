@@ -0,0 +1,244 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <tebako-pch.h>
+#include <tebako-pch-pp.h>
+#include <tebako-common.h>
+#include <tebako-thread-pool.h>
+
+#include <chrono>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace tebako {
+
+// Set on pool threads, so that nested parallel_run does not wait for helpers
+// queued behind its own task
+static thread_local bool tebako_pool_thread = false;
+
+tebako_thread_pool& tebako_thread_pool::get_tebako_thread_pool(void)
+{
+  static tebako_thread_pool pool{};
+  return pool;
+}
+
+// tebako_thread_pool::detect_cpu_quota
+//  Number of CPUs the process may actually use
+//  Linux: affinity mask limited by cgroup v2 cpu.max (containers)
+size_t tebako_thread_pool::detect_cpu_quota(void)
+{
+  size_t quota = std::thread::hardware_concurrency();
+#ifdef __linux__
+  cpu_set_t set;
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    quota = CPU_COUNT(&set);
+  }
+  std::ifstream cpu_max("/sys/fs/cgroup/cpu.max");
+  std::string max;
+  uint64_t period = 0;
+  if (cpu_max >> max >> period && max != "max" && period > 0) {
+    try {
+      uint64_t limit = std::stoull(max);
+      quota = std::min(quota, static_cast<size_t>((limit + period - 1) / period));
+    }
+    catch (...) {
+      // Malformed cpu.max, keep the affinity
+    }
+  }
+#endif
+  return std::max(quota, size_t(1));
+}
+
+tebako_thread_pool::tebako_thread_pool() : size(detect_cpu_quota()) {}
+
+tebako_thread_pool::~tebako_thread_pool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stopping = true;
+    background.clear();
+  }
+  cv.notify_all();
+  for (auto& t : threads) {
+    if (t.joinable()) {
+      t.join();
+    }
+  }
+}
+
+// Called under the lock
+void tebako_thread_pool::start(void)
+{
+  while (threads.size() < size) {
+    threads.emplace_back(&tebako_thread_pool::run, this);
+  }
+}
+
+void tebako_thread_pool::run(void)
+{
+  tebako_pool_thread = true;
+  std::unique_lock<std::mutex> lock(mtx);
+  while (true) {
+    cv.wait(lock, [this] { return stopping || !queue.empty() || !background.empty(); });
+    std::function<void()> task;
+    if (!queue.empty()) {
+      task = std::move(queue.front());
+      queue.pop_front();
+    }
+    else if (!stopping) {
+      task = std::move(background.front());
+      background.pop_front();
+    }
+    else {
+      return;
+    }
+    ++busy;
+    lock.unlock();
+
+    auto started = std::chrono::steady_clock::now();
+    try {
+      task();
+    }
+    catch (...) {
+      // Tasks report their errors themselves
+    }
+    auto elapsed = std::chrono::steady_clock::now() - started;
+
+    lock.lock();
+    --busy;
+    ++tasks_completed;
+    busy_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+  }
+}
+
+void tebako_thread_pool::submit(std::function<void()> task)
+{
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    start();
+    queue.push_back(std::move(task));
+  }
+  cv.notify_one();
+}
+
+void tebako_thread_pool::submit_background(std::function<void()> task)
+{
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    start();
+    background.push_back(std::move(task));
+  }
+  cv.notify_one();
+}
+
+void tebako_thread_pool::parallel_run(size_t n_helpers, const std::function<void()>& worker)
+{
+  n_helpers = tebako_pool_thread ? 0 : std::min(n_helpers, size);
+  std::mutex done_mtx;
+  std::condition_variable done_cv;
+  size_t pending = 0;
+
+  for (size_t i = 0; i < n_helpers; ++i) {
+    try {
+      {
+        std::lock_guard<std::mutex> lock(done_mtx);
+        ++pending;
+      }
+      submit([&]() {
+        try {
+          worker();
+        }
+        catch (...) {
+          // worker reports its errors itself
+        }
+        std::lock_guard<std::mutex> lock(done_mtx);
+        if (--pending == 0) {
+          done_cv.notify_all();
+        }
+      });
+    }
+    catch (...) {
+      std::lock_guard<std::mutex> lock(done_mtx);
+      --pending;
+      break;
+    }
+  }
+
+  worker();
+
+  std::unique_lock<std::mutex> lock(done_mtx);
+  done_cv.wait(lock, [&] { return pending == 0; });
+}
+
+// tebako_thread_pool::reserve_workers
+//  Reserves dwarfs decompression workers for a memfs that is being loaded
+// returns
+//  number of workers granted: requested number limited by the part of the CPU
+//  quota that is not reserved yet; the last slot of the quota is never granted,
+//  so 0 means that the memfs shall run one worker and read in the shared slot
+//  (see share_worker)
+size_t tebako_thread_pool::reserve_workers(size_t requested)
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  size_t own = size > 1 ? size - 1 : 0;
+  size_t available = own > workers_reserved ? own - workers_reserved : 0;
+  size_t granted = std::min(requested, available);
+  workers_reserved += granted;
+  return granted;
+}
+
+void tebako_thread_pool::release_workers(size_t reserved)
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  workers_reserved -= std::min(reserved, workers_reserved);
+}
+
+std::unique_lock<std::mutex> tebako_thread_pool::share_worker(size_t reserved)
+{
+  return reserved > 0 ? std::unique_lock<std::mutex>() : std::unique_lock<std::mutex>(shared_worker_mtx);
+}
+
+tebako_thread_pool::stats tebako_thread_pool::get_stats(void)
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  stats st;
+  st.threads = threads.size();
+  st.busy = busy;
+  st.queue_depth = queue.size();
+  st.background_depth = background.size();
+  st.tasks_completed = tasks_completed;
+  st.busy_time_ns = busy_time_ns;
+  st.decompression_workers = workers_reserved;
+  st.cpu_quota = size;
+  return st;
+}
+
+}  // namespace tebako
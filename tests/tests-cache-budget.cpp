@@ -0,0 +1,211 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+
+#include <tebako-io-inner.h>
+#include <tebako-io-root.h>
+#include <tebako-memfs.h>
+#include <tebako-memfs-table.h>
+#include <tebako-cache-budget.h>
+#include <tebako-chunk-cache.h>
+
+namespace tebako {
+
+class CacheBudgetTests : public ::testing::Test {
+ protected:
+  sync_tebako_cache_budget& cache_budget = sync_tebako_cache_budget::get_tebako_cache_budget();
+
+  void TearDown() override
+  {
+    unmount_root_memfs();
+    tebako_set_cache_budget(nullptr);
+  }
+};
+
+TEST_F(CacheBudgetTests, unlimited)
+{
+  cache_budget.set_total(0);
+  size_t share;
+  uint64_t id = cache_budget.reserve(static_cast<size_t>(512) << 20, nullptr, share);
+  EXPECT_EQ(static_cast<size_t>(512) << 20, share);
+  cache_budget.release(id);
+  EXPECT_EQ(0, cache_budget.get().reserved);
+}
+
+TEST_F(CacheBudgetTests, limited)
+{
+  const size_t mb = static_cast<size_t>(1) << 20;
+  cache_budget.set_total(100 * mb);
+  std::vector<size_t> resized;
+  size_t first, second, third;
+  uint64_t id1 = cache_budget.reserve(64 * mb, [&](size_t s) { resized.push_back(s); }, first);
+  uint64_t id2 = cache_budget.reserve(64 * mb, nullptr, second);
+  uint64_t id3 = cache_budget.reserve(64 * mb, nullptr, third);
+  EXPECT_EQ(64 * mb, first);
+  EXPECT_EQ(50 * mb, second);
+  EXPECT_EQ(cache_budget.get_share(id2), cache_budget.get_share(id3));
+  EXPECT_GE(100 * mb, cache_budget.get().reserved);
+  EXPECT_LT(99 * mb, cache_budget.get().reserved);
+  EXPECT_EQ(3, cache_budget.get().instances);
+
+  // The first member is told its share when the others are mounted and unmounted
+  cache_budget.release(id3);
+  EXPECT_EQ(0, cache_budget.get_share(id3));
+  cache_budget.release(id2);
+  ASSERT_EQ(4, resized.size());
+  EXPECT_EQ(50 * mb, resized[0]);
+  EXPECT_GT(50 * mb, resized[1]);
+  EXPECT_EQ(50 * mb, resized[2]);
+  EXPECT_EQ(64 * mb, resized[3]);
+
+  cache_budget.release(id1);
+  EXPECT_EQ(0, cache_budget.get().reserved);
+  EXPECT_EQ(0, cache_budget.get().instances);
+}
+
+TEST_F(CacheBudgetTests, proportional)
+{
+  const size_t mb = static_cast<size_t>(1) << 20;
+  cache_budget.set_total(100 * mb);
+  size_t large, small;
+  uint64_t id1 = cache_budget.reserve(150 * mb, nullptr, large);
+  uint64_t id2 = cache_budget.reserve(50 * mb, nullptr, small);
+  EXPECT_EQ(100 * mb, large);
+  EXPECT_EQ(mb + 98 * mb * 3 / 4, cache_budget.get_share(id1));
+  EXPECT_EQ(mb + 98 * mb / 4, small);
+
+  // The budget is shared again when it changes
+  cache_budget.set_total(400 * mb);
+  EXPECT_EQ(150 * mb, cache_budget.get_share(id1));
+  EXPECT_EQ(50 * mb, cache_budget.get_share(id2));
+
+  cache_budget.release(id1);
+  cache_budget.release(id2);
+}
+
+TEST_F(CacheBudgetTests, request)
+{
+  // cachesize=auto decisions change the request of a mounted memfs
+  const size_t mb = static_cast<size_t>(1) << 20;
+  cache_budget.set_total(100 * mb);
+  std::vector<size_t> resized;
+  size_t first, second;
+  uint64_t id1 = cache_budget.reserve(40 * mb, [&](size_t s) { resized.push_back(s); }, first);
+  uint64_t id2 = cache_budget.reserve(40 * mb, nullptr, second);
+  EXPECT_EQ(40 * mb, first);
+  EXPECT_TRUE(resized.empty());
+
+  cache_budget.request(id1, 80 * mb);
+  ASSERT_EQ(1, resized.size());
+  EXPECT_LT(40 * mb, resized[0]);
+  EXPECT_GT(40 * mb, cache_budget.get_share(id2));
+  EXPECT_GE(100 * mb, cache_budget.get().reserved);
+
+  cache_budget.request(id1, 20 * mb);
+  ASSERT_EQ(2, resized.size());
+  EXPECT_EQ(20 * mb, resized[1]);
+  EXPECT_EQ(40 * mb, cache_budget.get_share(id2));
+
+  cache_budget.release(id1);
+  cache_budget.release(id2);
+}
+
+TEST_F(CacheBudgetTests, exhausted)
+{
+  // The budget cannot hold min_cache_size per member: it is split evenly
+  cache_budget.set_total(sync_tebako_cache_budget::min_cache_size);
+  std::vector<uint64_t> ids;
+  for (int i = 0; i < 4; ++i) {
+    size_t share;
+    ids.push_back(cache_budget.reserve(static_cast<size_t>(64) << 20, nullptr, share));
+  }
+  EXPECT_EQ(sync_tebako_cache_budget::min_cache_size / 4, cache_budget.get_share(ids.front()));
+  EXPECT_GE(sync_tebako_cache_budget::min_cache_size, cache_budget.get().reserved);
+  for (auto id : ids) {
+    cache_budget.release(id);
+  }
+}
+
+TEST_F(CacheBudgetTests, fixed)
+{
+  // dwarfs block caches sized from the initial shares are kept within the budget
+  const size_t mb = static_cast<size_t>(1) << 20;
+  cache_budget.set_total(64 * mb);
+  std::vector<uint64_t> ids;
+  std::vector<size_t> fixed;
+  for (int i = 0; i < 8; ++i) {
+    size_t share;
+    ids.push_back(cache_budget.reserve(512 * mb, nullptr, share));
+    fixed.push_back(std::min(share / 4, 16 * mb));
+    cache_budget.set_fixed(ids.back(), fixed.back());
+  }
+  EXPECT_EQ(16 * mb, fixed.front());
+  EXPECT_GE(64 * mb, cache_budget.get().reserved);
+  for (size_t i = 0; i < ids.size(); ++i) {
+    EXPECT_LT(fixed[i], cache_budget.get_share(ids[i]));
+  }
+  for (auto id : ids) {
+    cache_budget.release(id);
+  }
+}
+
+TEST_F(CacheBudgetTests, root_memfs_within_budget)
+{
+  EXPECT_EQ(0, tebako_set_cache_budget("100M"));
+  EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), "512M", nullptr, nullptr, nullptr, nullptr));
+
+  auto fs = sync_tebako_memfs_table::get_tebako_memfs_table().get(0);
+  ASSERT_TRUE(fs != nullptr);
+  EXPECT_EQ(static_cast<size_t>(100) << 20, fs->get_cache_size());
+  EXPECT_EQ(static_cast<size_t>(100) << 20, cache_budget.get().reserved);
+  // The share is resizable: it goes to the chunk cache
+  ASSERT_TRUE(fs->get_chunk_cache() != nullptr);
+  EXPECT_GE(static_cast<size_t>(100) << 20,
+            fs->get_chunk_cache()->get_capacity() * tebako_chunk_cache::chunk_size);
+
+  cache_budget.set_total(static_cast<size_t>(40) << 20);
+  EXPECT_EQ(static_cast<size_t>(40) << 20, fs->get_cache_size());
+  EXPECT_GE(static_cast<size_t>(40) << 20, fs->get_chunk_cache()->get_capacity() * tebako_chunk_cache::chunk_size);
+
+  struct STAT_TYPE buf;
+  EXPECT_EQ(0, tebako_stat(TEBAKIZE_PATH("file.txt"), &buf));
+
+  unmount_root_memfs();
+  EXPECT_EQ(0, cache_budget.get().reserved);
+}
+
+TEST_F(CacheBudgetTests, invalid_budget)
+{
+  errno = 0;
+  EXPECT_EQ(-1, tebako_set_cache_budget("lots"));
+  EXPECT_EQ(EINVAL, errno);
+}
+
+}  // namespace tebako
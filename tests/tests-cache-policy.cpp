@@ -0,0 +1,248 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+
+#include <tebako-package-descriptor.h>
+#include <tebako-cache-policy.h>
+#include <tebako-chunk-cache.h>
+
+/*
+ *  Unit tests for cache replacement policies ('tebako_set_cache_policy',
+ *  tebako_cache_policy, tebako_chunk_cache)
+ */
+namespace {
+
+using tebako::tebako_cache_policy;
+
+class CachePolicyTests : public ::testing::Test {
+ protected:
+  void TearDown() override
+  {
+    tebako_set_cache_policy(NULL);
+    unmount_root_memfs();
+  }
+
+  static std::string read_file(const char* path)
+  {
+    std::string content;
+    char buf[64];
+    ssize_t n;
+    int fh = tebako_open(2, path, O_RDONLY);
+    EXPECT_LT(0, fh);
+    while ((n = tebako_read(fh, buf, sizeof(buf))) > 0) {
+      content.append(buf, n);
+    }
+    EXPECT_EQ(0, tebako_close(fh));
+    return content;
+  }
+
+  // A hot set read again and again, interleaved with one-shot scans
+  static std::vector<uint64_t> hot_and_scans(uint64_t hot, uint64_t scan, int rounds)
+  {
+    std::vector<uint64_t> trace;
+    uint64_t next = 1000000;
+    for (int r = 0; r < rounds; ++r) {
+      for (int i = 0; i < 4; ++i) {
+        for (uint64_t k = 0; k < hot; ++k) {
+          trace.push_back(k);
+        }
+      }
+      for (uint64_t k = 0; k < scan; ++k) {
+        trace.push_back(next++);
+      }
+    }
+    return trace;
+  }
+};
+
+TEST_F(CachePolicyTests, lru)
+{
+  auto p = tebako_cache_policy::create("lru", 3);
+  std::vector<uint64_t> evicted;
+  EXPECT_FALSE(p->access(1, evicted));
+  EXPECT_FALSE(p->access(2, evicted));
+  EXPECT_FALSE(p->access(3, evicted));
+  EXPECT_TRUE(p->access(1, evicted));
+  EXPECT_FALSE(p->access(4, evicted));
+  EXPECT_EQ(std::vector<uint64_t>{2}, evicted);
+  EXPECT_TRUE(p->contains(1));
+  EXPECT_FALSE(p->contains(2));
+  EXPECT_EQ(3, p->size());
+}
+
+TEST_F(CachePolicyTests, capacity)
+{
+  for (auto name : {"lru", "2q", "s3fifo"}) {
+    auto p = tebako_cache_policy::create(name, 20);
+    std::vector<uint64_t> evicted;
+    for (uint64_t k = 0; k < 1000; ++k) {
+      p->access(k % 37, evicted);
+      p->access(k, evicted);
+      EXPECT_GE(20, p->size()) << name;
+    }
+    EXPECT_EQ(20, p->size()) << name;
+  }
+}
+
+TEST_F(CachePolicyTests, scan_resistance)
+{
+  // The hot set fits, the scans are longer than the cache
+  auto trace = hot_and_scans(40, 300, 20);
+  double lru = tebako_cache_policy::hit_rate("lru", 100, trace);
+  double s3fifo = tebako_cache_policy::hit_rate("s3fifo", 100, trace);
+  EXPECT_LT(lru + 0.05, s3fifo);
+  // Without scans all policies keep the hot set
+  auto loop = hot_and_scans(40, 0, 20);
+  for (auto name : {"lru", "2q", "s3fifo"}) {
+    EXPECT_LT(0.95, tebako_cache_policy::hit_rate(name, 100, loop)) << name;
+  }
+}
+
+TEST_F(CachePolicyTests, trace_from_manifest)
+{
+  tebako::prefetch_manifest ranges{{1, 0, 10}, {1, 100, 1000}, {2, 1000, 2000}};
+  std::vector<uint64_t> expected{tebako_cache_policy::key(1, 0), tebako_cache_policy::key(1, 0),
+                                 tebako_cache_policy::key(1, 1), tebako_cache_policy::key(2, 1),
+                                 tebako_cache_policy::key(2, 2)};
+  EXPECT_EQ(expected, tebako_cache_policy::trace(ranges, 1000));
+}
+
+TEST_F(CachePolicyTests, chunk_cache)
+{
+  const size_t chunk_size = tebako::tebako_chunk_cache::chunk_size;
+  tebako::tebako_chunk_cache cache("s3fifo", 8 * chunk_size);
+  char buf[4];
+  size_t length = 0;
+  EXPECT_FALSE(cache.get(1, 0, 0, buf, sizeof(buf), length));
+  cache.put(1, 0, "abcdef", 6);
+  EXPECT_TRUE(cache.get(1, 0, 2, buf, sizeof(buf), length));
+  EXPECT_EQ(6, length);
+  EXPECT_EQ(0, memcmp(buf, "cdef", 4));
+  EXPECT_EQ(6, cache.get_bytes());
+  EXPECT_EQ(0, cache.get_evictions());
+  EXPECT_EQ(8, cache.get_capacity());
+  EXPECT_EQ("s3fifo", cache.get_policy());
+}
+
+TEST_F(CachePolicyTests, chunk_cache_resize)
+{
+  const size_t chunk_size = tebako::tebako_chunk_cache::chunk_size;
+  for (auto name : {"lru", "2q", "s3fifo"}) {
+    tebako::tebako_chunk_cache cache(name, 16 * chunk_size);
+    char buf[4];
+    size_t length = 0;
+    for (uint64_t chunk = 0; chunk < 16; ++chunk) {
+      EXPECT_FALSE(cache.get(1, chunk, 0, buf, sizeof(buf), length));
+      cache.put(1, chunk, "abcd", 4);
+    }
+    EXPECT_EQ(64, cache.get_bytes()) << name;
+
+    cache.set_capacity(4 * chunk_size);
+    EXPECT_EQ(4, cache.get_capacity()) << name;
+    EXPECT_GE(16, cache.get_bytes()) << name;
+    EXPECT_LT(0, cache.get_bytes()) << name;
+    EXPECT_LE(12, cache.get_evictions()) << name;
+  }
+}
+
+TEST_F(CachePolicyTests, chunk_cache_expire)
+{
+  const size_t chunk_size = tebako::tebako_chunk_cache::chunk_size;
+  tebako::tebako_chunk_cache cache("lru", 8 * chunk_size);
+  char buf[4];
+  size_t length = 0;
+  for (uint64_t chunk = 0; chunk < 2; ++chunk) {
+    EXPECT_FALSE(cache.get(1, chunk, 0, buf, sizeof(buf), length));
+    cache.put(1, chunk, "abcd", 4);
+  }
+  EXPECT_EQ(0, cache.expire(std::chrono::hours(1)));
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  EXPECT_EQ(8, cache.expire(std::chrono::milliseconds(1)));
+  EXPECT_EQ(0, cache.get_bytes());
+
+  // The key stays with the policy: the data is stored again on the next miss
+  EXPECT_FALSE(cache.get(1, 0, 0, buf, sizeof(buf), length));
+  cache.put(1, 0, "abcd", 4);
+  EXPECT_TRUE(cache.get(1, 0, 0, buf, sizeof(buf), length));
+}
+
+TEST_F(CachePolicyTests, mount)
+{
+  EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL, NULL, NULL, NULL, "auto"));
+  std::string expected = read_file(TEBAKIZE_PATH("file.txt"));
+  unmount_root_memfs();
+
+  for (auto name : {"lru", "2q", "s3fifo"}) {
+    EXPECT_EQ(0, tebako_set_cache_policy(name));
+    EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL, NULL, NULL, NULL, "auto"));
+    EXPECT_EQ(expected, read_file(TEBAKIZE_PATH("file.txt")));
+    EXPECT_EQ(expected, read_file(TEBAKIZE_PATH("file.txt")));
+    struct tebako_cache_stats st;
+    EXPECT_EQ(0, tebako_get_cache_stats(0, &st));
+    EXPECT_LT(0, st.chunk_cache_hits) << name;
+    EXPECT_LT(0, st.chunk_cache_misses) << name;
+    EXPECT_LT(0, st.chunk_cache_bytes) << name;
+    unmount_root_memfs();
+  }
+}
+
+TEST_F(CachePolicyTests, prefetch_fills_chunk_cache)
+{
+  EXPECT_EQ(0, tebako_set_cache_policy("s3fifo"));
+  EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL, NULL, NULL, NULL, "auto"));
+  int handle = tebako_prefetch(TEBAKIZE_PATH("file.txt"), 0);
+  ASSERT_LT(0, handle);
+  EXPECT_EQ(0, tebako_prefetch_wait(handle));
+  struct tebako_cache_stats st;
+  EXPECT_EQ(0, tebako_get_cache_stats(0, &st));
+  EXPECT_LT(0, st.chunk_cache_bytes);
+  EXPECT_EQ(0, st.chunk_cache_misses);
+
+  read_file(TEBAKIZE_PATH("file.txt"));
+  EXPECT_EQ(0, tebako_get_cache_stats(0, &st));
+  EXPECT_LT(0, st.chunk_cache_hits);
+  EXPECT_EQ(0, st.chunk_cache_misses);
+}
+
+TEST_F(CachePolicyTests, options)
+{
+  EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL, NULL, NULL, NULL, "auto"));
+  int ret = mount_memfs_with_options(&gfsData[0], gfsSize, "auto", 0, "dummy", "cache_policy=2q");
+  EXPECT_LE(1, ret);
+
+  errno = 0;
+  EXPECT_EQ(-1, mount_memfs_with_options(&gfsData[0], gfsSize, "auto", 0, "dummy", "cache_policy=mru"));
+  EXPECT_EQ(EINVAL, errno);
+  errno = 0;
+  EXPECT_EQ(-1, tebako_set_cache_policy("arc"));
+  EXPECT_EQ(EINVAL, errno);
+}
+
+}  // namespace
@@ -0,0 +1,115 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+
+#include <tebako-cache-sizer.h>
+
+/*
+ *  Unit tests for cachesize=auto ('tebako_get_cache_sizing', tebako_cache_sizer)
+ */
+namespace {
+
+class CacheSizerTests : public ::testing::Test {
+ protected:
+  void TearDown() override { unmount_root_memfs(); }
+};
+
+TEST_F(CacheSizerTests, working_set)
+{
+  const size_t granule = tebako::tebako_cache_sizer::granule;
+  tebako::tebako_cache_sizer sizer(4 * granule, 1024 * granule, 0.9, 1);
+  // A working set of 200 granules read in a loop
+  for (int loop = 0; loop < 20; ++loop) {
+    for (uint32_t inode = 0; inode < 200; ++inode) {
+      sizer.record(inode, 0, 100);
+    }
+  }
+  EXPECT_EQ(4000, sizer.get_sampled());
+  EXPECT_GT(0.1, sizer.hit_rate(100 * granule));
+  EXPECT_LT(0.9, sizer.hit_rate(250 * granule));
+
+  auto d = sizer.evaluate();
+  EXPECT_EQ(200 * granule, d.size);
+  EXPECT_LE(0.9, d.hit_rate);
+}
+
+TEST_F(CacheSizerTests, bounds)
+{
+  const size_t granule = tebako::tebako_cache_sizer::granule;
+  tebako::tebako_cache_sizer sizer(16 * granule, 64 * granule, 0.9, 1);
+  // Nothing is small enough: the min bound
+  for (int loop = 0; loop < 10; ++loop) {
+    sizer.record(1, 0, 100);
+  }
+  EXPECT_EQ(16 * granule, sizer.evaluate().size);
+
+  // A loop larger than the cache: the max bound
+  for (int loop = 0; loop < 10; ++loop) {
+    for (uint32_t inode = 0; inode < 500; ++inode) {
+      sizer.record(inode, 0, 100);
+    }
+  }
+  EXPECT_EQ(64 * granule, sizer.evaluate().size);
+}
+
+TEST_F(CacheSizerTests, auto_mode)
+{
+  EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), "auto", NULL, NULL, NULL, "auto"));
+  char buf[64];
+  int fh = tebako_open(2, TEBAKIZE_PATH("file.txt"), O_RDONLY);
+  EXPECT_LT(0, fh);
+  EXPECT_LT(0, tebako_read(fh, buf, sizeof(buf)));
+  EXPECT_EQ(0, tebako_close(fh));
+
+  struct tebako_cache_sizing st;
+  EXPECT_EQ(0, tebako_get_cache_sizing(0, &st));
+  EXPECT_EQ(1, st.auto_mode);
+  EXPECT_LE(st.min_size, st.cache_size);
+  EXPECT_GE(st.max_size, st.cache_size);
+  EXPECT_DOUBLE_EQ(0.9, st.target_hit_rate);
+}
+
+TEST_F(CacheSizerTests, fixed_size)
+{
+  EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), "16M", NULL, NULL, NULL, "auto"));
+  struct tebako_cache_sizing st;
+  EXPECT_EQ(0, tebako_get_cache_sizing(0, &st));
+  EXPECT_EQ(0, st.auto_mode);
+  EXPECT_EQ(16 << 20, st.cache_size);
+
+  errno = 0;
+  EXPECT_EQ(-1, tebako_get_cache_sizing(5, &st));
+  EXPECT_EQ(ENOENT, errno);
+  errno = 0;
+  EXPECT_EQ(-1, tebako_get_cache_sizing(0, NULL));
+  EXPECT_EQ(EFAULT, errno);
+}
+
+}  // namespace
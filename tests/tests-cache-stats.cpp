@@ -0,0 +1,123 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+
+#include <tebako-cache-stats.h>
+
+/*
+ *  Unit tests for 'tebako_get_cache_stats' and tebako_cache_counters
+ */
+namespace {
+
+class CacheStatsTests : public ::testing::Test {
+ protected:
+  void SetUp() override
+  {
+    EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL, NULL, NULL, NULL, "auto"));
+  }
+
+  void TearDown() override { unmount_root_memfs(); }
+
+  static ssize_t read_file(const char* path)
+  {
+    char buf[1024];
+    ssize_t total = 0, n;
+    int fh = tebako_open(2, path, O_RDONLY);
+    EXPECT_LT(0, fh);
+    while ((n = tebako_read(fh, buf, sizeof(buf))) > 0) {
+      total += n;
+    }
+    EXPECT_EQ(0, tebako_close(fh));
+    return total;
+  }
+};
+
+TEST_F(CacheStatsTests, counters)
+{
+  tebako::tebako_cache_counters counters;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&counters]() {
+      for (int k = 0; k < 1000; ++k) {
+        counters.add(tebako::tebako_cache_counters::reads, 1);
+        counters.add(tebako::tebako_cache_counters::bytes_read, 10);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(4000, counters.get(tebako::tebako_cache_counters::reads));
+  EXPECT_EQ(40000, counters.get(tebako::tebako_cache_counters::bytes_read));
+  counters.reset();
+  EXPECT_EQ(0, counters.get(tebako::tebako_cache_counters::reads));
+}
+
+TEST_F(CacheStatsTests, root_memfs)
+{
+  struct tebako_cache_stats before, after;
+  EXPECT_EQ(0, tebako_get_cache_stats(0, &before));
+  EXPECT_EQ(1, before.memfs_count);
+  EXPECT_LT(0, before.cache_size);
+  EXPECT_LE(1, before.workers);
+
+  ssize_t bytes = read_file(TEBAKIZE_PATH("file.txt"));
+  EXPECT_LT(0, bytes);
+
+  EXPECT_EQ(0, tebako_get_cache_stats(0, &after));
+  EXPECT_LT(before.reads, after.reads);
+  EXPECT_EQ(before.bytes_read + bytes, after.bytes_read);
+  EXPECT_LE(before.blocks_released, after.blocks_released);
+}
+
+TEST_F(CacheStatsTests, total)
+{
+  read_file(TEBAKIZE_PATH("file.txt"));
+
+  struct tebako_cache_stats root, total;
+  EXPECT_EQ(0, tebako_get_cache_stats(0, &root));
+  EXPECT_EQ(0, tebako_get_cache_stats(-1, &total));
+  EXPECT_EQ(root.memfs_count, total.memfs_count);
+  EXPECT_EQ(root.bytes_read, total.bytes_read);
+  EXPECT_EQ(root.cache_size, total.cache_size);
+}
+
+TEST_F(CacheStatsTests, errors)
+{
+  struct tebako_cache_stats st;
+  errno = 0;
+  EXPECT_EQ(-1, tebako_get_cache_stats(5, &st));
+  EXPECT_EQ(ENOENT, errno);
+  errno = 0;
+  EXPECT_EQ(-1, tebako_get_cache_stats(0, NULL));
+  EXPECT_EQ(EFAULT, errno);
+}
+
+}  // namespace
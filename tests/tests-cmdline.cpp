@@ -344,6 +344,26 @@ TEST(CmdlineArgsTest, mount_handles_no_tebako_mount_argument)
   EXPECT_EQ(other_args[2], "arg2");
 }
 
+#ifndef _WIN32
+// '?' is a valid character of image paths, only "?key=" after the image starts the options
+TEST(CmdlineArgsTest, memfs_options_after_image_path)
+{
+  stdfs::path dir = stdfs::path(__TMP__) / "tebako-cmdline?dir";
+  stdfs::create_directories(dir);
+  std::string image = (dir / "image?v=2.bin").string();
+  std::ofstream(image) << "x";
+
+  EXPECT_EQ(std::string::npos, cmdline_args::find_memfs_options(image));
+  EXPECT_EQ(image.size(), cmdline_args::find_memfs_options(image + "?cachesize=16M,disk_cache=/tmp/a?b"));
+  std::string missing = (dir / "missing.bin").string();
+  EXPECT_EQ(missing.size(), cmdline_args::find_memfs_options(missing + "?workers=1"));
+  EXPECT_EQ(std::string::npos, cmdline_args::find_memfs_options(missing + "?"));
+
+  std::error_code ec;
+  stdfs::remove_all(dir, ec);
+}
+#endif
+
 // Test Case 1: Basic Case
 TEST(CmdlineArgsTest, mount_basic_case)
 {
@@ -287,6 +287,28 @@ TEST_F(DirIOTests, tebako_scandir)
   }
 }
 
+extern "C" int reverse_compar(const struct dirent** a, const struct dirent** b)
+{
+  return strcmp((*b)->d_name, (*a)->d_name);
+}
+
+TEST_F(DirIOTests, tebako_scandir_reverse)
+{
+  struct dirent** namelist = NULL;
+  int n = tebako_scandir(TEBAKIZE_PATH("directory-with-90-files"), &namelist, NULL, reverse_compar);
+  EXPECT_EQ(92, n);
+  EXPECT_TRUE(namelist != NULL);
+  if (n > 0 && namelist != NULL) {
+    EXPECT_STREQ("file-99.txt", namelist[0]->d_name);
+    EXPECT_STREQ(".", namelist[n - 1]->d_name);
+    for (int i = 0; i < n; i++) {
+      EXPECT_GE(namelist[i]->d_reclen, offsetof(struct dirent, d_name) + strlen(namelist[i]->d_name) + 1);
+      free(namelist[i]);
+    }
+    free(namelist);
+  }
+}
+
 extern "C" int zero_filter(const struct dirent*)
 {
   return 0;
@@ -304,6 +326,27 @@ TEST_F(DirIOTests, tebako_scandir_filter_empty)
   }
 }
 
+static std::thread::id filter_thread;
+
+extern "C" int thread_filter(const struct dirent*)
+{
+  return std::this_thread::get_id() == filter_thread;
+}
+
+TEST_F(DirIOTests, tebako_scandir_filter_calling_thread)
+{
+  struct dirent** namelist = NULL;
+  filter_thread = std::this_thread::get_id();
+  int n = tebako_scandir(TEBAKIZE_PATH("directory-with-90-files"), &namelist, thread_filter, alphasort);
+  EXPECT_EQ(92, n);
+  if (namelist != NULL) {
+    for (int i = 0; i < n; i++) {
+      free(namelist[i]);
+    }
+    free(namelist);
+  }
+}
+
 extern "C" int bash_filter(const struct dirent* entry)
 {
   return (strcmp(entry->d_name, "bash") == 0);
@@ -324,6 +367,262 @@ TEST_F(DirIOTests, tebako_scandir_filter_pass_through)
 }
 #endif
 
+#if defined(TEBAKO_HAS_READDIR) && !defined(RB_W32)
+TEST_F(DirIOTests, tebako_readdir_plus)
+{
+  DIR* dirp = tebako_opendir(TEBAKIZE_PATH("directory-1"));
+  EXPECT_TRUE(dirp != NULL);
+  if (dirp != NULL) {
+    int n = 0;
+    struct stat st;
+    struct dirent* entry;
+    while ((entry = tebako_readdir_plus(dirp, &st)) != NULL) {
+      std::string path = TEBAKIZE_PATH("directory-1/");
+      path += entry->d_name;
+      struct stat st_l;
+      EXPECT_EQ(0, tebako_lstat(path.c_str(), &st_l));
+      EXPECT_EQ(st_l.st_ino, st.st_ino);
+      EXPECT_EQ(st_l.st_mode, st.st_mode);
+      EXPECT_EQ(st_l.st_size, st.st_size);
+      ++n;
+    }
+    EXPECT_LT(4, n);
+    EXPECT_EQ(0, tebako_closedir(dirp));
+  }
+}
+
+TEST_F(DirIOTests, tebako_readdir_plus_pass_through)
+{
+  DIR* dirp = tebako_opendir("/bin");
+  EXPECT_TRUE(dirp != NULL);
+  if (dirp != NULL) {
+    struct stat st;
+    struct dirent* entry;
+    while ((entry = tebako_readdir_plus(dirp, &st)) != NULL) {
+      if (strcmp(entry->d_name, "bash") == 0) {
+        break;
+      }
+    }
+    EXPECT_TRUE(entry != NULL);
+    EXPECT_NE(0, st.st_mode);
+    EXPECT_EQ(0, tebako_closedir(dirp));
+  }
+}
+
+TEST_F(DirIOTests, tebako_readdir_plus_pass_through_removed)
+{
+  // Entries removed after readdir has fetched them are returned with st zeroed
+  std::string tmpl = (stdfs::temp_directory_path() / "libdwarfs.tests.XXXXXX").string();
+  ASSERT_TRUE(mkdtemp(&tmpl[0]) != NULL);
+  stdfs::path dir = tmpl;
+  for (const char* name : {"file-1", "file-2", "file-3"}) {
+    std::ofstream(dir / name) << name;
+  }
+
+  DIR* dirp = tebako_opendir(dir.string().c_str());
+  EXPECT_TRUE(dirp != NULL);
+  if (dirp != NULL) {
+    struct stat st;
+    struct dirent* entry = tebako_readdir_plus(dirp, &st);
+    EXPECT_TRUE(entry != NULL);
+    for (const char* name : {"file-1", "file-2", "file-3"}) {
+      stdfs::remove(dir / name);
+    }
+    int n = 1;
+    int zeroed = 0;
+    while ((entry = tebako_readdir_plus(dirp, &st)) != NULL) {
+      n++;
+      zeroed += st.st_mode == 0 ? 1 : 0;
+    }
+    EXPECT_EQ(5, n);
+    EXPECT_LE(2, zeroed);
+    EXPECT_EQ(0, tebako_closedir(dirp));
+  }
+  stdfs::remove_all(dir);
+}
+
+#if defined(TEBAKO_HAS_OPENDIR) && defined(TEBAKO_HAS_CLOSEDIR)
+extern "C" int dir_plus_filter(const struct tebako_dirent_plus* entry)
+{
+  return S_ISDIR(entry->d_stat.st_mode) && entry->d_ent.d_name[0] != '.';
+}
+
+extern "C" int dir_plus_compar(const struct tebako_dirent_plus** a, const struct tebako_dirent_plus** b)
+{
+  return strcmp((*a)->d_ent.d_name, (*b)->d_ent.d_name);
+}
+
+TEST_F(DirIOTests, tebako_scandir_plus)
+{
+  struct tebako_dirent_plus** namelist = NULL;
+  int n = tebako_scandir_plus(TEBAKO_MOUNT_POINT, &namelist, dir_plus_filter, dir_plus_compar);
+  EXPECT_EQ(4, n);
+  EXPECT_TRUE(namelist != NULL);
+  if (n > 0 && namelist != NULL) {
+    EXPECT_STREQ("directory-1", namelist[0]->d_ent.d_name);
+    EXPECT_STREQ("directory-with-90-files", namelist[3]->d_ent.d_name);
+    for (int i = 0; i < n; i++) {
+      EXPECT_TRUE(S_ISDIR(namelist[i]->d_stat.st_mode));
+    }
+    tebako_scandir_plus_free(namelist);
+  }
+}
+
+TEST_F(DirIOTests, tebako_scandir_plus_no_dir)
+{
+  struct tebako_dirent_plus** namelist = NULL;
+  EXPECT_EQ(-1, tebako_scandir_plus(TEBAKIZE_PATH("no_directory"), &namelist, NULL, NULL));
+  EXPECT_EQ(ENOENT, errno);
+}
+#endif
+#endif
+
+#ifndef RB_W32
+TEST_F(DirIOTests, tebako_getdents)
+{
+  const off_t start_fnum = 10; /* The first filename is 'file-10.txt' */
+  const size_t size_dir = 90;
+  int fh = tebako_open(2, TEBAKIZE_PATH("directory-with-90-files"), O_RDONLY | O_DIRECTORY);
+  EXPECT_LT(0, fh);
+  if (fh > 0) {
+    alignas(8) char buf[512];
+    std::vector<std::string> names;
+    ssize_t n;
+    while ((n = tebako_getdents(fh, buf, sizeof(buf))) > 0) {
+      for (ssize_t off = 0; off < n;) {
+        struct tebako_dirent64* rec = reinterpret_cast<struct tebako_dirent64*>(buf + off);
+        EXPECT_EQ(0, rec->d_reclen % 8);
+        EXPECT_EQ(names.size() + 1, rec->d_off);
+        EXPECT_EQ(names.size() < 2 ? DT_DIR : DT_REG, rec->d_type);
+        names.push_back(rec->d_name);
+        off += rec->d_reclen;
+      }
+    }
+    EXPECT_EQ(0, n);
+    EXPECT_EQ(size_dir + 2, names.size());
+    if (names.size() == size_dir + 2) {
+      EXPECT_EQ(".", names[0]);
+      EXPECT_EQ("..", names[1]);
+      for (size_t i = 2; i < names.size(); i++) {
+        EXPECT_EQ("file-" + std::to_string(i + start_fnum - 2) + ".txt", names[i]);
+      }
+    }
+
+    EXPECT_EQ(0, tebako_lseek(fh, 2, SEEK_SET));
+    n = tebako_getdents(fh, buf, sizeof(buf));
+    EXPECT_LT(0, n);
+    if (n > 0) {
+      EXPECT_STREQ("file-10.txt", reinterpret_cast<struct tebako_dirent64*>(buf)->d_name);
+    }
+    EXPECT_EQ(0, tebako_close(fh));
+  }
+}
+
+TEST_F(DirIOTests, tebako_getdents_small_buffer)
+{
+  int fh = tebako_open(2, TEBAKIZE_PATH("directory-with-90-files"), O_RDONLY | O_DIRECTORY);
+  EXPECT_LT(0, fh);
+  if (fh > 0) {
+    alignas(8) char buf[16];
+    errno = 0;
+    EXPECT_EQ(-1, tebako_getdents(fh, buf, sizeof(buf)));
+    EXPECT_EQ(EINVAL, errno);
+    EXPECT_EQ(0, tebako_close(fh));
+  }
+}
+
+TEST_F(DirIOTests, tebako_getdents_not_dir)
+{
+  int fh = tebako_open(2, TEBAKIZE_PATH("file.txt"), O_RDONLY);
+  EXPECT_LT(0, fh);
+  if (fh > 0) {
+    alignas(8) char buf[512];
+    errno = 0;
+    EXPECT_EQ(-1, tebako_getdents(fh, buf, sizeof(buf)));
+    EXPECT_EQ(ENOTDIR, errno);
+    EXPECT_EQ(0, tebako_close(fh));
+  }
+}
+#endif
+
+extern "C" int walk_collect(const char* path, const struct stat* st, int level, void* ctx)
+{
+  auto entries = static_cast<std::map<std::string, std::pair<bool, int>>*>(ctx);
+  (*entries)[path] = std::make_pair(S_ISDIR(st->st_mode), level);
+  return TEBAKO_WALK_CONTINUE;
+}
+
+TEST_F(DirIOTests, tebako_walk)
+{
+  std::map<std::string, std::pair<bool, int>> entries;
+  EXPECT_EQ(0, tebako_walk(TEBAKIZE_PATH("directory-3"), walk_collect, 0, &entries));
+  EXPECT_EQ(6, entries.size());
+  EXPECT_EQ(std::make_pair(true, 1), entries["level-1"]);
+  EXPECT_EQ(std::make_pair(true, 2), entries["level-1/level-2"]);
+  EXPECT_EQ(std::make_pair(false, 3), entries["level-1/level-2/test-file-at-level-2.txt"]);
+  EXPECT_EQ(std::make_pair(true, 3), entries["level-1/level-2/level-3"]);
+  EXPECT_EQ(std::make_pair(true, 4), entries["level-1/level-2/level-3/level-4"]);
+  EXPECT_EQ(std::make_pair(false, 5), entries["level-1/level-2/level-3/level-4/test-file-at-level-4.txt"]);
+}
+
+extern "C" int walk_prune(const char* path, const struct stat* st, int level, void* ctx)
+{
+  ++*static_cast<int*>(ctx);
+  return strcmp(path, "level-1/level-2") == 0 ? TEBAKO_WALK_PRUNE : TEBAKO_WALK_CONTINUE;
+}
+
+TEST_F(DirIOTests, tebako_walk_prune)
+{
+  int count = 0;
+  EXPECT_EQ(0, tebako_walk(TEBAKIZE_PATH("directory-3"), walk_prune, 0, &count));
+  EXPECT_EQ(2, count);
+}
+
+extern "C" int walk_stop(const char* path, const struct stat* st, int level, void* ctx)
+{
+  return 42;
+}
+
+TEST_F(DirIOTests, tebako_walk_stop)
+{
+  EXPECT_EQ(42, tebako_walk(TEBAKIZE_PATH("directory-3"), walk_stop, 0, NULL));
+}
+
+extern "C" int walk_count(const char* path, const struct stat* st, int level, void* ctx)
+{
+  ++*static_cast<std::atomic<int>*>(ctx);
+  return TEBAKO_WALK_CONTINUE;
+}
+
+TEST_F(DirIOTests, tebako_walk_parallel)
+{
+  std::atomic<int> count{0};
+  std::atomic<int> count_parallel{0};
+  EXPECT_EQ(0, tebako_walk(TEBAKO_MOUNT_POINT, walk_count, 0, &count));
+  EXPECT_EQ(0, tebako_walk(TEBAKO_MOUNT_POINT, walk_count, TEBAKO_WALK_PARALLEL, &count_parallel));
+  EXPECT_LT(100, count.load());
+  EXPECT_EQ(count.load(), count_parallel.load());
+}
+
+TEST_F(DirIOTests, tebako_walk_errors)
+{
+  errno = 0;
+  EXPECT_EQ(-1, tebako_walk(TEBAKIZE_PATH("no_directory"), walk_count, 0, NULL));
+  EXPECT_EQ(ENOENT, errno);
+
+  errno = 0;
+  EXPECT_EQ(-1, tebako_walk(TEBAKIZE_PATH("file.txt"), walk_count, 0, NULL));
+  EXPECT_EQ(ENOTDIR, errno);
+
+  errno = 0;
+  EXPECT_EQ(-1, tebako_walk(__TMP__, walk_count, 0, NULL));
+  EXPECT_EQ(EXDEV, errno);
+
+  errno = 0;
+  EXPECT_EQ(-1, tebako_walk(TEBAKIZE_PATH("directory-3"), NULL, 0, NULL));
+  EXPECT_EQ(EINVAL, errno);
+}
+
 TEST_F(DirIOTests, tebako_dir_io_null_ptr)
 {
   errno = 0;
@@ -0,0 +1,204 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+
+#include <tebako-io-inner.h>
+#include <tebako-io-root.h>
+#include <tebako-memfs.h>
+#include <tebako-memfs-table.h>
+#include <tebako-disk-cache.h>
+#include <tebako-mfs.h>
+
+/*
+ *  Unit tests for the persistent disk cache ('tebako_set_disk_cache', tebako_disk_cache)
+ */
+namespace {
+
+class DiskCacheTests : public ::testing::Test {
+ protected:
+  stdfs::path root;
+
+  void SetUp() override
+  {
+    root = stdfs::path(__TMP__) / "tebako-disk-cache-tests";
+    stdfs::remove_all(root);
+  }
+
+  void TearDown() override
+  {
+    unmount_root_memfs();
+    tebako_set_disk_cache(NULL, NULL);
+    std::error_code ec;
+    stdfs::remove_all(root, ec);
+  }
+
+  static std::string read_file(const char* path)
+  {
+    std::string content;
+    char buf[7];  // Small buffer to cross chunk boundaries often
+    ssize_t n;
+    int fh = tebako_open(2, path, O_RDONLY);
+    EXPECT_LT(0, fh);
+    while ((n = tebako_read(fh, buf, sizeof(buf))) > 0) {
+      content.append(buf, n);
+    }
+    EXPECT_EQ(0, tebako_close(fh));
+    return content;
+  }
+
+  static void startup(std::vector<std::string>& contents)
+  {
+    contents.clear();
+    contents.push_back(read_file(TEBAKIZE_PATH("file.txt")));
+    contents.push_back(read_file(TEBAKIZE_PATH("directory-1/file-in-directory-1.txt")));
+    contents.push_back(read_file(TEBAKIZE_PATH("directory-2/file-in-directory-2.txt")));
+    contents.push_back(read_file(TEBAKIZE_PATH("directory-3/level-1/level-2/level-3/level-4/test-file-at-level-4.txt")));
+  }
+};
+
+TEST_F(DiskCacheTests, chunks)
+{
+  std::vector<char> image(4096, 'x');
+  tebako::tebako_disk_cache cache(root.string(), 1 << 20, image.data(), image.size());
+  std::vector<char> data;
+  size_t length;
+  EXPECT_FALSE(cache.get(1, 0, data, length));
+
+  std::string chunk(1000, 'a');
+  cache.put(1, 0, chunk.data(), chunk.size());
+  ASSERT_TRUE(cache.get(1, 0, data, length));
+  EXPECT_EQ(chunk, std::string(data.data(), length));
+
+  // Another image does not see the chunk
+  std::vector<char> image2(4096, 'y');
+  tebako::tebako_disk_cache cache2(root.string(), 1 << 20, image2.data(), image2.size());
+  EXPECT_NE(cache.get_identity(), cache2.get_identity());
+  EXPECT_FALSE(cache2.get(1, 0, data, length));
+}
+
+TEST_F(DiskCacheTests, identity_of_image_build)
+{
+  std::vector<char> image(reinterpret_cast<const char*>(&gfsData[0]),
+                          reinterpret_cast<const char*>(&gfsData[0]) + gfsSize);
+  uint64_t identity = tebako::tebako_disk_cache::image_identity(image.data(), image.size());
+  EXPECT_EQ(identity, tebako::tebako_disk_cache::image_identity(&gfsData[0], gfsSize));
+
+  // Another build of the same size that differs in a block: the section header
+  // carries the checksums of the block data
+  tebako::mfs mm(image.data(), image.size(), nullptr, false);
+  ASSERT_FALSE(mm.blocks().empty());
+  const auto& block = mm.blocks().front();
+  for (size_t i = 16; i < 48; ++i) {
+    image[block.first + i] ^= 0x5a;
+  }
+  EXPECT_NE(identity, tebako::tebako_disk_cache::image_identity(image.data(), image.size()));
+}
+
+TEST_F(DiskCacheTests, corrupted_chunk)
+{
+  std::vector<char> image(4096, 'x');
+  tebako::tebako_disk_cache cache(root.string(), 1 << 20, image.data(), image.size());
+  std::string chunk(100, 'z');
+  cache.put(3, 0, chunk.data(), chunk.size());
+  auto path = cache.get_dir() / "3-0";
+  {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(-1, std::ios::end);
+    file.put('q');
+  }
+  std::vector<char> data;
+  size_t length;
+  EXPECT_FALSE(cache.get(3, 0, data, length));
+  EXPECT_FALSE(stdfs::exists(path));
+}
+
+TEST_F(DiskCacheTests, trim)
+{
+  std::vector<char> image(4096, 'x');
+  {
+    tebako::tebako_disk_cache cache(root.string(), 1 << 30, image.data(), image.size());
+    std::string chunk(100000, 'b');
+    for (int i = 0; i < 10; ++i) {
+      cache.put(2, i, chunk.data(), chunk.size());
+    }
+  }
+  // Files that tebako_disk_cache did not write are not counted and not removed
+  auto image_dir = root / stdfs::path(*stdfs::directory_iterator(root)).filename();
+  std::vector<stdfs::path> foreign{root / "notes.txt", root / "other" / "1-2", image_dir / "readme.tmp"};
+  stdfs::create_directories(root / "other");
+  for (const auto& path : foreign) {
+    std::ofstream(path) << std::string(1000000, 'f');
+    stdfs::last_write_time(path, stdfs::file_time_type::clock::now() - std::chrono::hours(24));
+  }
+
+  tebako::tebako_disk_cache::trim(root, 500000);
+  uint64_t total = 0;
+  for (const auto& e : stdfs::directory_iterator(image_dir)) {
+    if (e.is_regular_file() && e.path().filename() != "readme.tmp") {
+      total += e.file_size();
+    }
+  }
+  EXPECT_GE(500000, total);
+  EXPECT_LT(0, total);
+  for (const auto& path : foreign) {
+    EXPECT_TRUE(stdfs::exists(path)) << path;
+  }
+}
+
+TEST_F(DiskCacheTests, repeated_runs)
+{
+  EXPECT_EQ(0, tebako_set_disk_cache(root.string().c_str(), "64M"));
+  std::vector<std::string> cold, warm;
+
+  EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL, NULL, NULL, NULL, "auto"));
+  startup(cold);
+  struct tebako_cache_stats st;
+  EXPECT_EQ(0, tebako_get_cache_stats(0, &st));
+  // One chunk per (small) file
+  EXPECT_EQ(cold.size(), st.disk_cache_misses);
+  unmount_root_memfs();
+
+  // The next "invocation" maps the chunks instead of decompressing them
+  EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL, NULL, NULL, NULL, "auto"));
+  startup(warm);
+  EXPECT_EQ(0, tebako_get_cache_stats(0, &st));
+  EXPECT_LT(0, st.disk_cache_hits);
+  EXPECT_EQ(0, st.disk_cache_misses);
+  EXPECT_EQ(cold, warm);
+}
+
+TEST_F(DiskCacheTests, invalid_size)
+{
+  errno = 0;
+  EXPECT_EQ(-1, tebako_set_disk_cache(root.string().c_str(), "lots"));
+  EXPECT_EQ(EINVAL, errno);
+}
+
+}  // namespace
@@ -0,0 +1,135 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+
+/*
+ *  Unit tests for eager decompression into a flat arena ('tebako_set_eager')
+ */
+namespace {
+
+class EagerTests : public ::testing::Test {
+ protected:
+  void TearDown() override
+  {
+    tebako_set_eager(NULL);
+    unmount_root_memfs();
+  }
+
+  static void mount(const char* mode)
+  {
+    unmount_root_memfs();
+    EXPECT_EQ(0, tebako_set_eager(mode));
+    EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL, NULL, NULL, NULL, "auto"));
+  }
+
+  static struct tebako_cache_stats stats(void)
+  {
+    struct tebako_cache_stats st;
+    EXPECT_EQ(0, tebako_get_cache_stats(0, &st));
+    return st;
+  }
+
+  static std::string read_file(const char* path, off_t offset = 0)
+  {
+    std::vector<char> buf(65536);
+    int fh = tebako_open(2, path, O_RDONLY);
+    EXPECT_LT(0, fh);
+    EXPECT_EQ(offset, tebako_lseek(fh, offset, SEEK_SET));
+    ssize_t n = tebako_read(fh, buf.data(), buf.size());
+    EXPECT_LE(0, n);
+    EXPECT_EQ(0, tebako_close(fh));
+    return std::string(buf.data(), n > 0 ? n : 0);
+  }
+};
+
+TEST_F(EagerTests, at_mount)
+{
+  mount(NULL);
+  std::string expected = read_file(TEBAKIZE_PATH("directory-1/file-in-directory-1.txt"));
+  std::string expected_tail = read_file(TEBAKIZE_PATH("file.txt"), 4);
+  EXPECT_EQ(0, stats().eager_bytes);
+
+  mount("mount");
+  auto before = stats();
+  EXPECT_LT(0, before.eager_bytes);
+  EXPECT_LT(0, before.eager_time_ns);
+  EXPECT_EQ(expected, read_file(TEBAKIZE_PATH("directory-1/file-in-directory-1.txt")));
+  EXPECT_EQ(expected_tail, read_file(TEBAKIZE_PATH("file.txt"), 4));
+  EXPECT_EQ("", read_file(TEBAKIZE_PATH("file.txt"), 1 << 20));
+
+  auto after = stats();
+  EXPECT_EQ(before.eager_hits + 3, after.eager_hits);
+  EXPECT_EQ(before.blocks_released, after.blocks_released);
+}
+
+TEST_F(EagerTests, in_background)
+{
+  mount(NULL);
+  std::string expected = read_file(TEBAKIZE_PATH("file2.txt"));
+
+  mount("background");
+  // Reads are served by the block cache until the arena is ready
+  EXPECT_EQ(expected, read_file(TEBAKIZE_PATH("file2.txt")));
+  for (int i = 0; i < 1000 && stats().eager_bytes == 0; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_LT(0, stats().eager_bytes);
+
+  auto before = stats();
+  EXPECT_EQ(expected, read_file(TEBAKIZE_PATH("file2.txt")));
+  EXPECT_EQ(before.eager_hits + 1, stats().eager_hits);
+}
+
+TEST_F(EagerTests, unmount_while_filling)
+{
+  mount("background");
+  unmount_root_memfs();
+  mount("2");
+  EXPECT_FALSE(read_file(TEBAKIZE_PATH("file.txt")).empty());
+}
+
+TEST_F(EagerTests, options)
+{
+  mount(NULL);
+  int ret = mount_memfs_with_options(&gfsData[0], gfsSize, "auto", 0, "dummy", "eager=mount");
+  EXPECT_LE(1, ret);
+  struct tebako_cache_stats st;
+  EXPECT_EQ(0, tebako_get_cache_stats(ret, &st));
+  EXPECT_LT(0, st.eager_bytes);
+
+  errno = 0;
+  EXPECT_EQ(-1, tebako_set_eager("always"));
+  EXPECT_EQ(EINVAL, errno);
+  errno = 0;
+  EXPECT_EQ(-1, tebako_set_eager("3"));
+  EXPECT_EQ(EINVAL, errno);
+}
+
+}  // namespace
@@ -121,6 +121,36 @@ TEST_F(LoadTests2, tebako_load_valid_filesystem)
   EXPECT_LE(1, ret);
 }
 
+TEST_F(LoadTests2, tebako_load_valid_filesystem_with_options)
+{
+  int ret = mount_memfs_with_options(buffer.data(), size, "auto", 0, "dummy", "cachesize=8M,workers=1,mlock=none");
+  EXPECT_LE(1, ret);
+}
+
+TEST_F(LoadTests2, tebako_load_valid_filesystem_with_page_options)
+{
+  int ret = mount_memfs_with_options(buffer.data(), size, "auto", 0, "dummy", "madvise=0,hugepages=1");
+  EXPECT_LE(1, ret);
+}
+
+TEST_F(LoadTests2, tebako_load_with_invalid_options)
+{
+  errno = 0;
+  int ret = mount_memfs_with_options(buffer.data(), size, "auto", 0, "dummy", "decompress_ratio=2");
+  EXPECT_EQ(-1, ret);
+  EXPECT_EQ(EINVAL, errno);
+
+  errno = 0;
+  ret = mount_memfs_with_options(buffer.data(), size, "auto", 0, "dummy", "workers");
+  EXPECT_EQ(-1, ret);
+  EXPECT_EQ(EINVAL, errno);
+
+  errno = 0;
+  ret = mount_memfs_with_options(buffer.data(), size, "auto", 0, "dummy", "cachesize=auto,target_hit_rate=1.5");
+  EXPECT_EQ(-1, ret);
+  EXPECT_EQ(EINVAL, errno);
+}
+
 TEST_F(LoadTests2, tebako_load_invalid_filesystem)
 {
   const unsigned char data[] = "This is broken filesystem image";
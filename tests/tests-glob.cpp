@@ -0,0 +1,215 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+#include <tebako-glob.h>
+
+namespace {
+class GlobTests : public testing::Test {
+ protected:
+  static void SetUpTestSuite()
+  {
+    mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL /* cachesize*/, NULL /* workers */, NULL /* mlock */,
+                     NULL /* decompress_ratio*/, NULL /* image_offset */
+    );
+  }
+
+  static void TearDownTestSuite()
+  {
+    unmount_root_memfs();
+  }
+};
+
+TEST_F(GlobTests, glob_segment_match)
+{
+  EXPECT_TRUE(tebako::glob_segment("*.txt", 0).match("file.txt"));
+  EXPECT_FALSE(tebako::glob_segment("*.txt", 0).match("file.txt2"));
+  EXPECT_TRUE(tebako::glob_segment("file-1?.txt", 0).match("file-10.txt"));
+  EXPECT_FALSE(tebako::glob_segment("file-1?.txt", 0).match("file-100.txt"));
+  EXPECT_TRUE(tebako::glob_segment("[a-c]x", 0).match("bx"));
+  EXPECT_FALSE(tebako::glob_segment("[!a-c]x", 0).match("bx"));
+  EXPECT_TRUE(tebako::glob_segment("*a*b*c", 0).match("xxaxxbxxc"));
+  EXPECT_FALSE(tebako::glob_segment("*a*b*c", 0).match("xxaxxbxxcd"));
+  EXPECT_TRUE(tebako::glob_segment("FILE*", TEBAKO_GLOB_CASEFOLD).match("file.txt"));
+  EXPECT_FALSE(tebako::glob_segment("FILE*", 0).match("file.txt"));
+}
+
+TEST_F(GlobTests, glob_segment_dotmatch)
+{
+  EXPECT_FALSE(tebako::glob_segment("*", 0).match(".hidden"));
+  EXPECT_TRUE(tebako::glob_segment("*", TEBAKO_GLOB_DOTMATCH).match(".hidden"));
+  EXPECT_TRUE(tebako::glob_segment(".*", 0).match(".hidden"));
+}
+
+TEST_F(GlobTests, glob_segment_kind)
+{
+  EXPECT_EQ(tebako::glob_segment::LITERAL, tebako::glob_segment("file.txt", 0).get_kind());
+  EXPECT_EQ(tebako::glob_segment::WILDCARD, tebako::glob_segment("file.txt", TEBAKO_GLOB_CASEFOLD).get_kind());
+  EXPECT_EQ(tebako::glob_segment::WILDCARD, tebako::glob_segment("file-*", 0).get_kind());
+  EXPECT_EQ(tebako::glob_segment::RECURSIVE, tebako::glob_segment("**", 0).get_kind());
+}
+
+TEST_F(GlobTests, glob_pattern_expand_braces)
+{
+  std::vector<std::string> expanded;
+  tebako::glob_pattern::expand_braces("a{b,c{d,e}}f{1,2}", false, expanded);
+  std::vector<std::string> expected = {"abf1", "abf2", "acdf1", "acdf2", "acef1", "acef2"};
+  EXPECT_EQ(expected, expanded);
+
+  expanded.clear();
+  tebako::glob_pattern::expand_braces("a{b", false, expanded);
+  EXPECT_EQ(std::vector<std::string>{"a{b"}, expanded);
+}
+
+TEST_F(GlobTests, glob_pattern_prefix)
+{
+  tebako::glob_pattern pattern("dir/sub/**/x/*.txt", 0);
+  EXPECT_EQ("dir/sub", pattern.get_prefix());
+  ASSERT_EQ(3, pattern.get_segments().size());
+  EXPECT_EQ(tebako::glob_segment::RECURSIVE, pattern.get_segments()[0].get_kind());
+  EXPECT_EQ(tebako::glob_segment::LITERAL, pattern.get_segments()[1].get_kind());
+  EXPECT_EQ(tebako::glob_segment::WILDCARD, pattern.get_segments()[2].get_kind());
+  EXPECT_FALSE(pattern.dirs_only());
+
+  tebako::glob_pattern trailing("dir/**/", 0);
+  EXPECT_TRUE(trailing.dirs_only());
+  ASSERT_EQ(1, trailing.get_segments().size());
+  EXPECT_EQ(tebako::glob_segment::WILDCARD, trailing.get_segments()[0].get_kind());
+}
+
+TEST_F(GlobTests, glob_pattern_casefold_prefix)
+{
+  // The mount point is matched literally, the names below it are case-folded
+  tebako::glob_pattern pattern(TEBAKIZE_PATH("Dir/*.TXT"), TEBAKO_GLOB_CASEFOLD);
+#ifdef _WIN32
+  EXPECT_EQ(TEBAKO_MOUNT_POINT_S, pattern.get_prefix());
+#else
+  EXPECT_EQ(TEBAKO_MOUNT_POINT, pattern.get_prefix());
+#endif
+  ASSERT_EQ(2, pattern.get_segments().size());
+  EXPECT_EQ(tebako::glob_segment::WILDCARD, pattern.get_segments()[0].get_kind());
+  EXPECT_TRUE(pattern.get_segments()[0].match("dir"));
+}
+
+extern "C" int glob_collect(const char* path, const struct stat* st, void* ctx)
+{
+  static_cast<std::set<std::string>*>(ctx)->insert(path);
+  return 0;
+}
+
+TEST_F(GlobTests, tebako_glob_wildcard)
+{
+  std::set<std::string> matches;
+  EXPECT_EQ(0, tebako_glob(TEBAKIZE_PATH("directory-with-90-files/file-1?.txt"), 0, glob_collect, &matches));
+  EXPECT_EQ(10, matches.size());
+  EXPECT_EQ(1, matches.count(TEBAKIZE_PATH("directory-with-90-files") "/file-10.txt"));
+  EXPECT_EQ(1, matches.count(TEBAKIZE_PATH("directory-with-90-files") "/file-19.txt"));
+}
+
+TEST_F(GlobTests, tebako_glob_recursive)
+{
+  std::set<std::string> matches;
+  EXPECT_EQ(0, tebako_glob(TEBAKIZE_PATH("directory-3/**/*.txt"), 0, glob_collect, &matches));
+  EXPECT_EQ(2, matches.size());
+  EXPECT_EQ(1, matches.count(TEBAKIZE_PATH("directory-3") "/level-1/level-2/test-file-at-level-2.txt"));
+  EXPECT_EQ(1,
+            matches.count(TEBAKIZE_PATH("directory-3") "/level-1/level-2/level-3/level-4/test-file-at-level-4.txt"));
+}
+
+TEST_F(GlobTests, tebako_glob_braces)
+{
+  std::set<std::string> matches;
+  EXPECT_EQ(0, tebako_glob(TEBAKIZE_PATH("{directory-1,directory-2}/*.txt"), 0, glob_collect, &matches));
+  EXPECT_EQ(3, matches.size());
+  EXPECT_EQ(1, matches.count(TEBAKIZE_PATH("directory-2") "/file-in-directory-2.txt"));
+}
+
+TEST_F(GlobTests, tebako_glob_dirs_only)
+{
+  std::set<std::string> matches;
+  EXPECT_EQ(0, tebako_glob(TEBAKIZE_PATH("directory-3/*/"), 0, glob_collect, &matches));
+  EXPECT_EQ(1, matches.size());
+  EXPECT_EQ(1, matches.count(TEBAKIZE_PATH("directory-3") "/level-1/"));
+}
+
+TEST_F(GlobTests, tebako_glob_literal)
+{
+  std::set<std::string> matches;
+  EXPECT_EQ(0, tebako_glob(TEBAKIZE_PATH("file.txt"), 0, glob_collect, &matches));
+  EXPECT_EQ(0, tebako_glob(TEBAKIZE_PATH("no-file.txt"), 0, glob_collect, &matches));
+  EXPECT_EQ(0, tebako_glob(TEBAKIZE_PATH("no-directory/*.txt"), 0, glob_collect, &matches));
+  EXPECT_EQ(1, matches.size());
+  EXPECT_EQ(1, matches.count(TEBAKIZE_PATH("file.txt")));
+}
+
+TEST_F(GlobTests, tebako_glob_casefold)
+{
+  std::set<std::string> matches;
+  EXPECT_EQ(0, tebako_glob(TEBAKIZE_PATH("Directory-With-90-Files/FILE-1?.TXT"), TEBAKO_GLOB_CASEFOLD, glob_collect,
+                           &matches));
+  EXPECT_EQ(0, tebako_glob(TEBAKIZE_PATH("FILE.TXT"), TEBAKO_GLOB_CASEFOLD, glob_collect, &matches));
+  EXPECT_EQ(11, matches.size());
+  EXPECT_EQ(1, matches.count(TEBAKIZE_PATH("directory-with-90-files") "/file-10.txt"));
+  EXPECT_EQ(1, matches.count(TEBAKIZE_PATH("file.txt")));
+
+  // Case matters without the flag
+  matches.clear();
+  EXPECT_EQ(0, tebako_glob(TEBAKIZE_PATH("FILE.TXT"), 0, glob_collect, &matches));
+  EXPECT_EQ(0, matches.size());
+}
+
+extern "C" int glob_stop(const char* path, const struct stat* st, void* ctx)
+{
+  ++*static_cast<int*>(ctx);
+  return 42;
+}
+
+TEST_F(GlobTests, tebako_glob_stop)
+{
+  int count = 0;
+  EXPECT_EQ(42, tebako_glob(TEBAKIZE_PATH("directory-with-90-files/*"), 0, glob_stop, &count));
+  EXPECT_EQ(1, count);
+}
+
+TEST_F(GlobTests, tebako_glob_errors)
+{
+  errno = 0;
+  EXPECT_EQ(-1, tebako_glob(NULL, 0, glob_collect, NULL));
+  EXPECT_EQ(ENOENT, errno);
+
+  errno = 0;
+  EXPECT_EQ(-1, tebako_glob(TEBAKIZE_PATH("*"), 0, NULL, NULL));
+  EXPECT_EQ(EINVAL, errno);
+
+  errno = 0;
+  EXPECT_EQ(-1, tebako_glob(__TMP__ "/*", 0, glob_collect, NULL));
+  EXPECT_EQ(EXDEV, errno);
+}
+
+}  // namespace
@@ -0,0 +1,149 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+
+#include <tebako-cache-stats.h>
+#include <tebako-mfs.h>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+/*
+ *  Unit tests for remapping the image metadata onto huge pages (mfs::use_huge_pages)
+ *  The test image is too small to have a huge page of metadata, a synthetic image
+ *  with the dwarfs section layout is mapped from a file instead
+ */
+namespace {
+
+#ifdef __linux__
+
+class HugePagesTests : public ::testing::Test {
+ protected:
+  static const size_t metadata_size = static_cast<size_t>(12) << 20;
+
+  stdfs::path path;
+  std::vector<uint8_t> image;
+  void* addr{nullptr};
+
+  void SetUp() override
+  {
+    std::vector<uint64_t> index;
+    section(0, 300000, index);
+    section(7, 1000, index);
+    section(8, metadata_size, index);
+    // The index points to itself in the last entry
+    index.push_back((static_cast<uint64_t>(9) << 48) | image.size());
+    header(9, index.size() * sizeof(uint64_t));
+    for (auto e : index) {
+      image.insert(image.end(), reinterpret_cast<uint8_t*>(&e), reinterpret_cast<uint8_t*>(&e) + sizeof(e));
+    }
+
+    path = stdfs::path(__TMP__) / "tebako-huge-pages.img";
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(image.data()), image.size());
+    file.close();
+    addr = map();
+    ASSERT_NE(nullptr, addr);
+  }
+
+  void TearDown() override
+  {
+    if (addr != nullptr) {
+      munmap(addr, image.size());
+    }
+    std::error_code ec;
+    stdfs::remove(path, ec);
+  }
+
+  void* map(void)
+  {
+    int fd = open(path.c_str(), O_RDONLY);
+    void* p = mmap(nullptr, image.size(), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    return p == MAP_FAILED ? nullptr : p;
+  }
+
+  void header(uint16_t type, uint64_t length)
+  {
+    uint8_t h[64] = {0};
+    memcpy(h, "DWARFS", 6);
+    h[6] = 2;
+    memcpy(h + 52, &type, sizeof(type));
+    memcpy(h + 56, &length, sizeof(length));
+    image.insert(image.end(), h, h + sizeof(h));
+  }
+
+  void section(uint16_t type, size_t length, std::vector<uint64_t>& index)
+  {
+    index.push_back((static_cast<uint64_t>(type) << 48) | image.size());
+    header(type, length);
+    size_t offset = image.size();
+    image.resize(offset + length);
+    for (size_t i = 0; i < length; i++) {
+      image[offset + i] = static_cast<uint8_t>((offset + i) * 131 >> 3);
+    }
+  }
+};
+
+TEST_F(HugePagesTests, sections)
+{
+  tebako::mfs mm(addr, image.size());
+  EXPECT_TRUE(mm.is_file_backed());
+  EXPECT_EQ(1, mm.blocks().size());
+  EXPECT_EQ(1000 + metadata_size + 128, mm.metadata().second);
+}
+
+TEST_F(HugePagesTests, remap_keeps_data)
+{
+  tebako::tebako_cache_counters counters;
+  tebako::mfs mm(addr, image.size(), &counters);
+  size_t remapped = mm.use_huge_pages();
+  // At least 5 of the huge pages are entirely within 12M of metadata
+  EXPECT_LE(5 * tebako::mfs::huge_page_size, remapped);
+  EXPECT_EQ(0, remapped % tebako::mfs::huge_page_size);
+  EXPECT_EQ(remapped, counters.get(tebako::tebako_cache_counters::huge_page_bytes));
+  EXPECT_EQ(0, memcmp(addr, image.data(), image.size()));
+
+  // Remapped already
+  tebako::mfs again(addr, image.size());
+  EXPECT_EQ(0, again.use_huge_pages());
+  EXPECT_EQ(0, memcmp(addr, image.data(), image.size()));
+}
+
+TEST_F(HugePagesTests, heap_image_is_not_remapped)
+{
+  tebako::mfs mm(image.data(), image.size());
+  EXPECT_EQ(0, mm.use_huge_pages());
+}
+
+#endif  // __linux__
+
+}  // namespace
@@ -0,0 +1,165 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+
+#include <tebako-idle-trimmer.h>
+
+/*
+ *  Unit tests for idle-time cache trimming ('tebako_set_idle_trim', tebako_idle_trimmer)
+ */
+namespace {
+
+class IdleTrimTests : public ::testing::Test {
+ protected:
+  void SetUp() override
+  {
+    EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL, NULL, NULL, NULL, "auto"));
+  }
+
+  void TearDown() override
+  {
+    tebako_set_idle_trim(0);
+    unmount_root_memfs();
+  }
+
+  static tebako::tebako_idle_trimmer& trimmer(void)
+  {
+    return tebako::tebako_idle_trimmer::get_tebako_idle_trimmer();
+  }
+
+  static void read_file(void)
+  {
+    char buf[16];
+    int fh = tebako_open(2, TEBAKIZE_PATH("file.txt"), O_RDONLY);
+    EXPECT_LT(0, fh);
+    EXPECT_LT(0, tebako_read(fh, buf, sizeof(buf)));
+    EXPECT_EQ(0, tebako_close(fh));
+  }
+};
+
+TEST_F(IdleTrimTests, trims_when_idle)
+{
+  // The background check is rare, the test checks explicitly
+  EXPECT_EQ(0, tebako_set_idle_trim(3600000));
+  trimmer().check();
+  uint64_t trims = trimmer().get_stats().trims;
+
+  read_file();
+  trimmer().check();
+  EXPECT_EQ(trims, trimmer().get_stats().trims);
+
+  // No reads since the previous check
+  trimmer().check();
+  EXPECT_EQ(trims + 1, trimmer().get_stats().trims);
+
+  // Reads are served after the trim
+  read_file();
+
+  struct tebako_idle_trim it;
+  EXPECT_EQ(0, tebako_get_idle_trim(&it));
+  EXPECT_EQ(1, it.enabled);
+  EXPECT_EQ(3600000, it.max_age_ms);
+  EXPECT_EQ(trims + 1, it.trims);
+  EXPECT_LE(it.trims, it.checks);
+}
+
+TEST_F(IdleTrimTests, background_timer)
+{
+  uint64_t checks = trimmer().get_stats().checks;
+  EXPECT_EQ(0, tebako_set_idle_trim(20));
+  read_file();
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (trimmer().get_stats().checks < checks + 3 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_LE(checks + 3, trimmer().get_stats().checks);
+
+  EXPECT_EQ(0, tebako_set_idle_trim(0));
+  struct tebako_idle_trim it;
+  EXPECT_EQ(0, tebako_get_idle_trim(&it));
+  EXPECT_EQ(0, it.enabled);
+  EXPECT_EQ(0, it.max_age_ms);
+}
+
+TEST_F(IdleTrimTests, reports_dropped_bytes)
+{
+  // The chunk cache data dropped by the trims is reported
+  unmount_root_memfs();
+  EXPECT_EQ(0, tebako_set_cache_policy("lru"));
+  EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL, NULL, NULL, NULL, "auto"));
+  uint64_t reclaimed = trimmer().get_stats().bytes_reclaimed;
+  EXPECT_EQ(0, tebako_set_idle_trim(20));
+  read_file();
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (trimmer().get_stats().bytes_reclaimed == reclaimed && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_LT(reclaimed, trimmer().get_stats().bytes_reclaimed);
+
+  struct tebako_cache_stats st;
+  EXPECT_EQ(0, tebako_get_cache_stats(-1, &st));
+  EXPECT_EQ(0, st.chunk_cache_bytes);
+  tebako_set_cache_policy(NULL);
+}
+
+#if defined(__linux__) && defined(__GLIBC__)
+TEST_F(IdleTrimTests, reports_rss_reclaimed)
+{
+  // The heap freed by the process is returned by the trim whatever the cache policy
+  EXPECT_EQ(0, tebako_set_idle_trim(3600000));
+  trimmer().check();
+  uint64_t reclaimed = trimmer().get_stats().rss_reclaimed;
+  std::vector<char*> blocks;
+  for (int i = 0; i < 1024; ++i) {
+    blocks.push_back(static_cast<char*>(malloc(32 * 1024)));
+    memset(blocks.back(), 1, 32 * 1024);
+  }
+  // Keeps the freed blocks off the top of the heap, so that free() does not trim them
+  char* guard = static_cast<char*>(malloc(64));
+  for (char* block : blocks) {
+    free(block);
+  }
+  trimmer().check();
+  free(guard);
+  EXPECT_LT(reclaimed, trimmer().get_stats().rss_reclaimed);
+
+  struct tebako_idle_trim it;
+  EXPECT_EQ(0, tebako_get_idle_trim(&it));
+  EXPECT_EQ(trimmer().get_stats().rss_reclaimed, it.rss_reclaimed);
+}
+#endif
+
+TEST_F(IdleTrimTests, null_stats)
+{
+  EXPECT_EQ(-1, tebako_get_idle_trim(NULL));
+  EXPECT_EQ(EFAULT, errno);
+}
+
+}  // namespace
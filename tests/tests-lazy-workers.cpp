@@ -0,0 +1,128 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+
+/*
+ *  Unit tests for lazy decompression worker startup ('tebako_set_lazy_workers')
+ */
+namespace {
+
+class LazyWorkersTests : public ::testing::Test {
+ protected:
+  void SetUp() override
+  {
+    EXPECT_EQ(0, tebako_set_lazy_workers(1, "64K"));
+    EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL, "4", NULL, NULL, "auto"));
+  }
+
+  void TearDown() override
+  {
+    tebako_set_lazy_workers(0, NULL);
+    unmount_root_memfs();
+  }
+
+  static struct tebako_cache_stats stats(void)
+  {
+    struct tebako_cache_stats st;
+    EXPECT_EQ(0, tebako_get_cache_stats(0, &st));
+    return st;
+  }
+
+  static std::string read_file(const char* path, size_t size)
+  {
+    std::vector<char> buf(size);
+    int fh = tebako_open(2, path, O_RDONLY);
+    EXPECT_LT(0, fh);
+    ssize_t n = tebako_read(fh, buf.data(), buf.size());
+    EXPECT_LT(0, n);
+    EXPECT_EQ(0, tebako_close(fh));
+    return std::string(buf.data(), n > 0 ? n : 0);
+  }
+};
+
+TEST_F(LazyWorkersTests, no_workers_at_mount)
+{
+  EXPECT_EQ(0, stats().workers_started);
+  struct stat st;
+  EXPECT_EQ(0, tebako_stat(TEBAKIZE_PATH("file.txt"), &st));
+  EXPECT_EQ(0, stats().workers_started);
+}
+
+TEST_F(LazyWorkersTests, small_read_starts_one)
+{
+  std::string content = read_file(TEBAKIZE_PATH("file.txt"), 16);
+  EXPECT_FALSE(content.empty());
+  EXPECT_EQ(1, stats().workers_started);
+}
+
+TEST_F(LazyWorkersTests, large_read_starts_all)
+{
+  std::string small = read_file(TEBAKIZE_PATH("file.txt"), 16);
+  std::string large = read_file(TEBAKIZE_PATH("file.txt"), 65536);
+  EXPECT_EQ(small, large);
+  auto st = stats();
+  EXPECT_EQ(st.workers, st.workers_started);
+}
+
+TEST_F(LazyWorkersTests, concurrent_reads)
+{
+  std::string expected = read_file(TEBAKIZE_PATH("directory-1/file-in-directory-1.txt"), 16384);
+  unmount_root_memfs();
+  EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL, "4", NULL, NULL, "auto"));
+  EXPECT_EQ(0, stats().workers_started);
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; i++) {
+    threads.emplace_back([&expected]() {
+      for (int j = 0; j < 20; j++) {
+        EXPECT_EQ(expected, read_file(TEBAKIZE_PATH("directory-1/file-in-directory-1.txt"), 16384));
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_LE(1, stats().workers_started);
+}
+
+TEST_F(LazyWorkersTests, options)
+{
+  int ret = mount_memfs_with_options(&gfsData[0], gfsSize, "auto", 0, "dummy", "lazy_workers=1,lazy_threshold=4K");
+  EXPECT_LE(1, ret);
+  struct tebako_cache_stats st;
+  EXPECT_EQ(0, tebako_get_cache_stats(ret, &st));
+  EXPECT_EQ(0, st.workers_started);
+
+  errno = 0;
+  EXPECT_EQ(-1, tebako_set_lazy_workers(1, "many"));
+  EXPECT_EQ(EINVAL, errno);
+}
+
+}  // namespace
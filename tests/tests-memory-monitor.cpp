@@ -0,0 +1,150 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+
+#include <tebako-memory-monitor.h>
+
+/*
+ *  Unit tests for memory pressure monitoring ('tebako_set_memory_monitor', tebako_memory_monitor)
+ *  A fake cgroup directory is used
+ */
+namespace {
+
+class MemoryMonitorTests : public ::testing::Test {
+ protected:
+  stdfs::path dir;
+
+  void SetUp() override
+  {
+    dir = stdfs::path(__TMP__) / "tebako-fake-cgroup";
+    stdfs::create_directories(dir);
+    write("memory.current", "1000");
+    write("memory.high", "max");
+    write("memory.max", "10000");
+    write("memory.pressure",
+          "some avg10=0.00 avg60=0.00 avg300=0.00 total=0\nfull avg10=0.00 avg60=0.00 avg300=0.00 total=0\n");
+    EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL, NULL, NULL, NULL, "auto"));
+  }
+
+  void TearDown() override
+  {
+    tebako_set_memory_monitor(NULL, 0);
+    unmount_root_memfs();
+    std::error_code ec;
+    stdfs::remove_all(dir, ec);
+  }
+
+  void write(const char* name, const std::string& content)
+  {
+    std::ofstream file(dir / name, std::ios::trunc);
+    file << content;
+  }
+
+  static tebako::tebako_memory_monitor& monitor(void)
+  {
+    return tebako::tebako_memory_monitor::get_tebako_memory_monitor();
+  }
+};
+
+TEST_F(MemoryMonitorTests, read_sample)
+{
+  auto s = tebako::tebako_memory_monitor::read_sample(dir.string());
+  EXPECT_TRUE(s.valid);
+  EXPECT_EQ(1000, s.current);
+  EXPECT_EQ(10000, s.limit);
+  EXPECT_DOUBLE_EQ(0.0, s.psi_some_avg10);
+
+  write("memory.high", "5000");
+  write("memory.pressure", "some avg10=12.50 avg60=3.00 avg300=1.00 total=100\n");
+  s = tebako::tebako_memory_monitor::read_sample(dir.string());
+  EXPECT_EQ(5000, s.limit);
+  EXPECT_DOUBLE_EQ(12.5, s.psi_some_avg10);
+
+  s = tebako::tebako_memory_monitor::read_sample((dir / "no-such-cgroup").string());
+  EXPECT_FALSE(s.valid);
+}
+
+TEST_F(MemoryMonitorTests, shrink_and_regrow)
+{
+  // The background check is rare, the test checks explicitly
+  EXPECT_EQ(0, tebako_set_memory_monitor(dir.string().c_str(), 3600000));
+  uint64_t shrink_events = monitor().get_stats().shrink_events;
+  monitor().check();
+  EXPECT_FALSE(monitor().is_under_pressure());
+
+  write("memory.current", "9500");
+  monitor().check();
+  EXPECT_TRUE(monitor().is_under_pressure());
+
+  // Reads are served under pressure
+  char buf[16];
+  int fh = tebako_open(2, TEBAKIZE_PATH("file.txt"), O_RDONLY);
+  EXPECT_LT(0, fh);
+  EXPECT_LT(0, tebako_read(fh, buf, sizeof(buf)));
+  EXPECT_EQ(0, tebako_close(fh));
+
+  // Hysteresis: still over the low watermark
+  write("memory.current", "8500");
+  monitor().check();
+  EXPECT_TRUE(monitor().is_under_pressure());
+
+  write("memory.current", "5000");
+  monitor().check();
+  EXPECT_FALSE(monitor().is_under_pressure());
+
+  struct tebako_memory_pressure mp;
+  EXPECT_EQ(0, tebako_get_memory_pressure(&mp));
+  EXPECT_EQ(1, mp.enabled);
+  EXPECT_EQ(0, mp.under_pressure);
+  EXPECT_EQ(shrink_events + 1, mp.shrink_events);
+  EXPECT_EQ(5000, mp.memory_current);
+  EXPECT_EQ(10000, mp.memory_limit);
+
+  struct tebako_cache_stats st;
+  EXPECT_EQ(0, tebako_get_cache_stats(0, &st));
+  EXPECT_EQ(1, st.pressure_shrinks);
+}
+
+TEST_F(MemoryMonitorTests, psi)
+{
+  EXPECT_EQ(0, tebako_set_memory_monitor(dir.string().c_str(), 3600000));
+  write("memory.pressure", "some avg10=25.00 avg60=10.00 avg300=2.00 total=12345\n");
+  monitor().check();
+  EXPECT_TRUE(monitor().is_under_pressure());
+
+  // Stopping the monitor lets the caches regrow
+  EXPECT_EQ(0, tebako_set_memory_monitor(NULL, 0));
+  EXPECT_FALSE(monitor().is_under_pressure());
+  struct tebako_memory_pressure mp;
+  EXPECT_EQ(0, tebako_get_memory_pressure(&mp));
+  EXPECT_EQ(0, mp.enabled);
+}
+
+}  // namespace
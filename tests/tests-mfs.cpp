@@ -27,74 +27,92 @@
  *
  */
 
-#include <cerrno>
-#include <string>
-
-#include <folly/portability/SysMman.h>
-#include <folly/portability/Unistd.h>
-#include <boost/system/error_code.hpp>
-
-#include <tebako-pch.h>
-#include <tebako-common.h>
+#include "tests.h"
 
+#include <tebako-cache-stats.h>
 #include <tebako-mfs.h>
 
-namespace tebako {
+/*
+ *  Unit tests for tebako::mfs image sections and page management hints
+ */
+namespace {
 
-std::error_code mfs::lock(dwarfs::file_off_t offset, size_t size)
+TEST(MfsTests, sections)
 {
-  std::error_code ec;
-  auto addr = reinterpret_cast<const uint8_t*>(addr_) + offset;
-  if (::mlock(addr, size) != 0) {
-    ec.assign(errno, boost::system::generic_category());
+  tebako::mfs mm(&gfsData[0], gfsSize);
+  ASSERT_FALSE(mm.blocks().empty());
+  EXPECT_LT(0, mm.metadata().second);
+
+  size_t end = 0;
+  for (const auto& b : mm.blocks()) {
+    EXPECT_LE(end, b.first);
+    EXPECT_LT(0, b.second);
+    end = b.first + b.second;
   }
-  return ec;
+  // Metadata follows the blocks
+  EXPECT_LE(end, mm.metadata().first);
+  EXPECT_LE(mm.metadata().first + mm.metadata().second, gfsSize);
+#ifdef __linux__
+  EXPECT_TRUE(mm.is_file_backed());
+#endif
 }
 
-std::error_code mfs::release(dwarfs::file_off_t offset, size_t size)
+TEST(MfsTests, no_hints)
 {
-  std::error_code ec;
-  auto misalign = offset % page_size_;
-
-  offset -= misalign;
-  size += misalign;
-  size -= size % page_size_;
-
-  auto addr = reinterpret_cast<const uint8_t*>(addr_) + offset;
-  if (::munlock(addr, size) != 0) {
-    ec.assign(errno, boost::system::generic_category());
-  }
-  return ec;
+  // Sections are found, the mapping type is not looked up
+  tebako::mfs mm(&gfsData[0], gfsSize, nullptr, false);
+  EXPECT_FALSE(mm.blocks().empty());
+  EXPECT_LT(0, mm.metadata().second);
+  EXPECT_FALSE(mm.is_file_backed());
+
+  // Not a dwarfs image
+  std::vector<char> data(65536, 'x');
+  tebako::mfs other(data.data(), data.size());
+  EXPECT_TRUE(other.blocks().empty());
+  EXPECT_EQ(0, other.metadata().second);
 }
 
-std::error_code mfs::release_until(dwarfs::file_off_t offset)
+TEST(MfsTests, view_of_image)
 {
-  std::error_code ec;
-
-  offset -= offset % page_size_;
-
-  if (::munlock(addr_, offset) != 0) {
-    ec.assign(errno, boost::system::generic_category());
-  }
-  return ec;
-}
-
-void const* mfs::addr() const
-{
-  return addr_;
+  tebako::mfs mm(&gfsData[0], gfsSize);
+  tebako::mfs view(mm, nullptr, false);
+  EXPECT_EQ(mm.blocks(), view.blocks());
+  EXPECT_EQ(mm.metadata(), view.metadata());
+  EXPECT_EQ(mm.is_file_backed(), view.is_file_backed());
+
+  // A view that gives hints looks the mapping type up if the image view did not
+  tebako::mfs quiet(&gfsData[0], gfsSize, nullptr, false);
+  tebako::mfs advising(quiet, nullptr, true);
+  EXPECT_EQ(mm.is_file_backed(), advising.is_file_backed());
 }
 
-size_t mfs::size() const
+TEST(MfsTests, release_keeps_anonymous_data)
 {
-  return size_;
+  // Released pages of an image copy on the heap must not be dropped
+  std::vector<char> image(reinterpret_cast<const char*>(&gfsData[0]),
+                          reinterpret_cast<const char*>(&gfsData[0]) + gfsSize);
+  tebako::tebako_cache_counters counters;
+  tebako::mfs mm(image.data(), image.size(), &counters);
+  EXPECT_FALSE(mm.is_file_backed());
+  for (const auto& b : mm.blocks()) {
+    EXPECT_FALSE(mm.release(b.first, b.second));
+  }
+  EXPECT_EQ(mm.blocks().size(), counters.get(tebako::tebako_cache_counters::blocks_released));
+  EXPECT_EQ(0, memcmp(image.data(), &gfsData[0], gfsSize));
 }
 
-mfs::mfs(const void* addr, size_t size) : size_(size), addr_(addr), page_size_(sysconf(_SC_PAGESIZE)) {}
-
-std::filesystem::path const& mfs::path() const
+TEST(MfsTests, release_mounted_image)
 {
-  static std::filesystem::path p(TEBAKO_MOUNT_POINT);
-  return p;
+  // Decompressed blocks of the embedded image are released and read again
+  EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL, NULL, NULL, NULL, "auto"));
+  for (int i = 0; i < 2; i++) {
+    char buf[16];
+    int fh = tebako_open(2, TEBAKIZE_PATH("file.txt"), O_RDONLY);
+    EXPECT_LT(0, fh);
+    EXPECT_LT(0, tebako_read(fh, buf, sizeof(buf)));
+    EXPECT_EQ(0, tebako_close(fh));
+  }
+  unmount_root_memfs();
 }
 
-}  // namespace tebako
+}  // namespace
@@ -0,0 +1,120 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+
+/*
+ *  Unit tests for the asynchronous root memfs mount ('mount_root_memfs_async')
+ */
+namespace {
+
+class MountAsyncTests : public ::testing::Test {
+ protected:
+  void TearDown() override
+  {
+    mount_root_memfs_wait();
+    unmount_root_memfs();
+  }
+
+  static int mount_async(const void* data, unsigned int size)
+  {
+    return mount_root_memfs_async(data, size, tests_log_level(), NULL, NULL, NULL, NULL, "auto");
+  }
+
+  static void read_file(void)
+  {
+    char buf[16];
+    int fh = tebako_open(2, TEBAKIZE_PATH("file.txt"), O_RDONLY);
+    EXPECT_LT(0, fh);
+    EXPECT_LT(0, tebako_read(fh, buf, sizeof(buf)));
+    EXPECT_EQ(0, tebako_close(fh));
+  }
+};
+
+TEST_F(MountAsyncTests, first_call_waits)
+{
+  EXPECT_EQ(0, mount_async(&gfsData[0], gfsSize));
+  // No explicit wait: the first call waits on the ready latch
+  read_file();
+  struct stat st;
+  EXPECT_EQ(0, tebako_stat(TEBAKIZE_PATH("file.txt"), &st));
+  EXPECT_EQ(0, mount_root_memfs_wait());
+}
+
+TEST_F(MountAsyncTests, chdir_waits)
+{
+  EXPECT_EQ(0, mount_async(&gfsData[0], gfsSize));
+  EXPECT_EQ(0, tebako_chdir(TEBAKIZE_PATH("directory-1")));
+  EXPECT_NE(0, is_tebako_cwd());
+}
+
+TEST_F(MountAsyncTests, errors_are_deterministic)
+{
+  std::vector<char> garbage(4096, 'x');
+  EXPECT_EQ(0, mount_async(garbage.data(), static_cast<unsigned int>(garbage.size())));
+  errno = 0;
+  EXPECT_EQ(-1, mount_root_memfs_wait());
+  int err = errno;
+  EXPECT_NE(0, err);
+
+  // The same result however many times it is asked for
+  errno = 0;
+  EXPECT_EQ(-1, mount_root_memfs_wait());
+  EXPECT_EQ(err, errno);
+
+  // and memfs calls fail as if nothing was mounted
+  struct stat st;
+  errno = 0;
+  EXPECT_EQ(-1, tebako_stat(TEBAKIZE_PATH("file.txt"), &st));
+  EXPECT_EQ(ENOENT, errno);
+}
+
+TEST_F(MountAsyncTests, remount)
+{
+  EXPECT_EQ(0, mount_async(&gfsData[0], gfsSize));
+  EXPECT_EQ(0, mount_async(&gfsData[0], gfsSize));
+  read_file();
+  EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL, NULL, NULL, NULL, "auto"));
+  read_file();
+}
+
+TEST_F(MountAsyncTests, concurrent_mounts)
+{
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([]() { EXPECT_EQ(0, mount_async(&gfsData[0], gfsSize)); });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(0, mount_root_memfs_wait());
+  read_file();
+}
+
+}  // namespace
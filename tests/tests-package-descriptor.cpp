@@ -420,4 +420,76 @@ TEST(PackageDescriptorTest, construct_from_buffer_wrong_signature)
   EXPECT_THROW(package_descriptor pd(buffer), std::invalid_argument);
 }
 
-}  // namespace tebako
\ No newline at end of file
+TEST(PackageDescriptorTest, prefetch_manifest)
+{
+  prefetch_manifest manifest = {{3, 0, 4096}, {17, 65536, 100}, {3, 8192, 512}};
+  package_descriptor pd("3.1.2", "2.5.1", "/app", "start.rb", std::nullopt, manifest);
+
+  std::vector<char> buffer = pd.serialize();
+  // The descriptor is followed by the filesystem image in the package
+  const char image[] = "DWARFS";
+  buffer.insert(buffer.end(), image, image + sizeof(image));
+
+  package_descriptor pd2(buffer);
+  ASSERT_TRUE(pd2.get_prefetch_manifest().has_value());
+  EXPECT_EQ(*pd2.get_prefetch_manifest(), manifest);
+  EXPECT_EQ(pd2.get_entry_point(), "start.rb");
+}
+
+TEST(PackageDescriptorTest, no_prefetch_manifest)
+{
+  package_descriptor pd("3.1.2", "2.5.1", "/app", "start.rb", std::string("/var/www"));
+  std::vector<char> buffer = pd.serialize();
+  const char image[] = "DWARFS";
+  buffer.insert(buffer.end(), image, image + sizeof(image));
+
+  package_descriptor pd2(buffer);
+  EXPECT_EQ(pd2.get_prefetch_manifest(), std::nullopt);
+  EXPECT_EQ(pd2.get_cwd(), std::optional<std::string>("/var/www"));
+}
+
+TEST(PackageDescriptorTest, prefetch_manifest_alone)
+{
+  prefetch_manifest manifest = {{1, 0, 10}};
+  std::vector<char> buffer = package_descriptor::serialize_manifest(manifest);
+  EXPECT_EQ(package_descriptor::deserialize_manifest(buffer), manifest);
+
+  buffer.resize(buffer.size() - 1);
+  EXPECT_THROW(package_descriptor::deserialize_manifest(buffer), std::out_of_range);
+
+  std::vector<char> garbage = {'D', 'W', 'A', 'R', 'F', 'S'};
+  EXPECT_THROW(package_descriptor::deserialize_manifest(garbage), std::invalid_argument);
+}
+
+TEST(PackageDescriptorTest, pin_list)
+{
+  std::vector<std::string> pins = {"config/locales/en.yml", "db/index.sqlite3"};
+  package_descriptor pd("3.1.2", "2.5.1", "/app", "start.rb", std::nullopt);
+  pd.set_pin_list(pins);
+  std::vector<char> buffer = pd.serialize();
+  const char image[] = "DWARFS";
+  buffer.insert(buffer.end(), image, image + sizeof(image));
+
+  package_descriptor pd2(buffer);
+  EXPECT_EQ(pd2.get_prefetch_manifest(), std::nullopt);
+  ASSERT_TRUE(pd2.get_pin_list().has_value());
+  EXPECT_EQ(*pd2.get_pin_list(), pins);
+
+  // With prefetch manifest
+  pd.set_prefetch_manifest(prefetch_manifest{{1, 0, 10}});
+  package_descriptor pd3(pd.serialize());
+  ASSERT_TRUE(pd3.get_prefetch_manifest().has_value());
+  ASSERT_TRUE(pd3.get_pin_list().has_value());
+  EXPECT_EQ(*pd3.get_pin_list(), pins);
+}
+
+TEST(PackageDescriptorTest, pin_list_truncated)
+{
+  package_descriptor pd("3.1.2", "2.5.1", "/app", "start.rb", std::nullopt);
+  pd.set_pin_list(std::vector<std::string>{"routes.rb"});
+  std::vector<char> buffer = pd.serialize();
+  buffer.resize(buffer.size() - 1);
+  EXPECT_THROW(package_descriptor pd2(buffer), std::out_of_range);
+}
+
+}  // namespace tebako
@@ -0,0 +1,100 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+
+/*
+ *  Unit tests for 'tebako_set_perfmon' and 'tebako_perfmon_summary'
+ */
+namespace {
+
+class PerfmonTests : public ::testing::Test {
+ protected:
+  void TearDown() override
+  {
+    unmount_root_memfs();
+    tebako_set_perfmon(0);
+  }
+
+  static void touch_memfs(void)
+  {
+    struct STAT_TYPE buf;
+    EXPECT_EQ(0, tebako_stat(TEBAKIZE_PATH("directory-1/file-in-directory-1.txt"), &buf));
+    int fh = tebako_open(2, TEBAKIZE_PATH("directory-1/file-in-directory-1.txt"), O_RDONLY);
+    EXPECT_LT(0, fh);
+    char readbuf[32];
+    EXPECT_LT(0, tebako_read(fh, readbuf, sizeof(readbuf)));
+    EXPECT_EQ(0, tebako_close(fh));
+  }
+};
+
+TEST_F(PerfmonTests, disabled_by_default)
+{
+  EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL, NULL, NULL, NULL, "auto"));
+  touch_memfs();
+
+  char summary[16];
+  errno = 0;
+  EXPECT_EQ(-1, tebako_perfmon_summary(0, summary, sizeof(summary)));
+  EXPECT_EQ(ENOTSUP, errno);
+}
+
+TEST_F(PerfmonTests, summary)
+{
+  tebako_set_perfmon(1);
+  EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL, NULL, NULL, NULL, "auto"));
+  touch_memfs();
+
+  int len = tebako_perfmon_summary(0, NULL, 0);
+  EXPECT_LE(0, len);
+
+  std::vector<char> summary(len + 1, 'x');
+  EXPECT_EQ(len, tebako_perfmon_summary(0, summary.data(), summary.size()));
+  EXPECT_EQ('\0', summary[len]);
+  EXPECT_EQ(static_cast<size_t>(len), strlen(summary.data()));
+
+  if (len > 0) {
+    char small[2];
+    EXPECT_EQ(len, tebako_perfmon_summary(0, small, sizeof(small)));
+    EXPECT_EQ('\0', small[1]);
+  }
+}
+
+TEST_F(PerfmonTests, no_such_memfs)
+{
+  EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL, NULL, NULL, NULL, "auto"));
+  errno = 0;
+  EXPECT_EQ(-1, tebako_perfmon_summary(5, NULL, 0));
+  EXPECT_EQ(ENOENT, errno);
+  errno = 0;
+  EXPECT_EQ(-1, tebako_perfmon_summary(-1, NULL, 0));
+  EXPECT_EQ(ENOENT, errno);
+}
+
+}  // namespace
@@ -0,0 +1,121 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+
+/*
+ *  Unit tests for 'tebako_pin' and 'tebako_unpin'
+ */
+namespace {
+
+class PinTests : public ::testing::Test {
+ protected:
+  void SetUp() override
+  {
+    EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL, NULL, NULL, NULL, "auto"));
+  }
+
+  void TearDown() override { unmount_root_memfs(); }
+
+  static std::string read_file(const char* path)
+  {
+    std::string content;
+    char buf[5];
+    ssize_t n;
+    int fh = tebako_open(2, path, O_RDONLY);
+    EXPECT_LT(0, fh);
+    while ((n = tebako_read(fh, buf, sizeof(buf))) > 0) {
+      content.append(buf, n);
+    }
+    EXPECT_EQ(0, tebako_close(fh));
+    return content;
+  }
+
+  static struct tebako_cache_stats get_stats(void)
+  {
+    struct tebako_cache_stats st;
+    EXPECT_EQ(0, tebako_get_cache_stats(0, &st));
+    return st;
+  }
+};
+
+TEST_F(PinTests, pin_file)
+{
+  const char* path = TEBAKIZE_PATH("file.txt");
+  std::string unpinned = read_file(path);
+  EXPECT_EQ(0, get_stats().pinned_bytes);
+
+  EXPECT_EQ(0, tebako_pin(path));
+  auto st = get_stats();
+  EXPECT_EQ(unpinned.size(), st.pinned_bytes);
+  EXPECT_EQ(unpinned, read_file(path));
+  EXPECT_LT(st.pinned_hits, get_stats().pinned_hits);
+
+  // Pinning twice does not double count
+  EXPECT_EQ(0, tebako_pin(path));
+  EXPECT_EQ(unpinned.size(), get_stats().pinned_bytes);
+
+  EXPECT_EQ(0, tebako_unpin(path));
+  EXPECT_EQ(0, get_stats().pinned_bytes);
+  EXPECT_EQ(unpinned, read_file(path));
+
+  errno = 0;
+  EXPECT_EQ(-1, tebako_unpin(path));
+  EXPECT_EQ(ENOENT, errno);
+}
+
+TEST_F(PinTests, pin_directory)
+{
+  const char* dir = TEBAKIZE_PATH("directory-1");
+  EXPECT_EQ(0, tebako_pin(dir));
+  size_t pinned = get_stats().pinned_bytes;
+  EXPECT_LE(read_file(TEBAKIZE_PATH("directory-1/file-in-directory-1.txt")).size(), pinned);
+
+  EXPECT_EQ(0, tebako_pin(TEBAKIZE_PATH("file.txt")));
+  EXPECT_LT(pinned, get_stats().pinned_bytes);
+  EXPECT_EQ(0, tebako_unpin(dir));
+  EXPECT_EQ(read_file(TEBAKIZE_PATH("file.txt")).size(), get_stats().pinned_bytes);
+}
+
+TEST_F(PinTests, pin_errors)
+{
+  errno = 0;
+  EXPECT_EQ(-1, tebako_pin(TEBAKIZE_PATH("no-such-file.txt")));
+  EXPECT_EQ(ENOENT, errno);
+
+  errno = 0;
+  EXPECT_EQ(-1, tebako_pin(__TMP__));
+  EXPECT_EQ(EXDEV, errno);
+
+  errno = 0;
+  EXPECT_EQ(-1, tebako_pin(NULL));
+  EXPECT_EQ(ENOENT, errno);
+}
+
+}  // namespace
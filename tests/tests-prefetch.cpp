@@ -0,0 +1,240 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+
+#include <tebako-io-inner.h>
+#include <tebako-io-root.h>
+#include <tebako-memfs.h>
+#include <tebako-memfs-table.h>
+#include <tebako-package-descriptor.h>
+#include <tebako-prefetch.h>
+
+/*
+ *  Unit tests for startup prefetch manifest ('tebako_prefetch_record',
+ *  'tebako_prefetch_record_save', 'tebako_prefetch_manifest'), 'tebako_prefetch',
+ *  'tebako_prefetch_glob' and prefetch_job
+ */
+namespace {
+
+// Number of files read by startup()
+const size_t startup_files = 4;
+
+class PrefetchTests : public ::testing::Test {
+ protected:
+  void SetUp() override { mount(); }
+  void TearDown() override { unmount_root_memfs(); }
+
+  static void mount(void)
+  {
+    // Small cache and 'image' cache mode off, so that every mount starts cold
+    EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), "4M", NULL, NULL, NULL, "auto"));
+  }
+
+  static void read_file(const char* path)
+  {
+    char buf[4096];
+    int fh = tebako_open(2, path, O_RDONLY);
+    EXPECT_LT(0, fh);
+    while (tebako_read(fh, buf, sizeof(buf)) > 0) {
+    }
+    EXPECT_EQ(0, tebako_close(fh));
+  }
+
+  static void startup(void)
+  {
+    read_file(TEBAKIZE_PATH("file.txt"));
+    read_file(TEBAKIZE_PATH("directory-1/file-in-directory-1.txt"));
+    read_file(TEBAKIZE_PATH("directory-2/file-in-directory-2.txt"));
+    read_file(TEBAKIZE_PATH("directory-3/level-1/level-2/level-3/level-4/test-file-at-level-4.txt"));
+  }
+
+  static tebako::prefetch_manifest record(void)
+  {
+    EXPECT_EQ(0, tebako_prefetch_record(60));
+    startup();
+    auto fs = tebako::sync_tebako_memfs_table::get_tebako_memfs_table().get(0);
+    EXPECT_TRUE(fs != nullptr);
+    auto m = fs->get_training();
+    EXPECT_EQ(0, tebako_prefetch_record(0));
+    return m;
+  }
+};
+
+TEST_F(PrefetchTests, record)
+{
+  auto manifest = record();
+  // One coalesced range per file, in the order of the first touch
+  EXPECT_EQ(startup_files, manifest.size());
+  for (const auto& r : manifest) {
+    EXPECT_LT(0, r.length);
+    EXPECT_EQ(0, r.offset);
+  }
+
+  // Not recorded after training is stopped
+  read_file(TEBAKIZE_PATH("file2.txt"));
+  auto fs = tebako::sync_tebako_memfs_table::get_tebako_memfs_table().get(0);
+  EXPECT_EQ(manifest, fs->get_training());
+}
+
+TEST_F(PrefetchTests, record_save)
+{
+  record();
+  std::string path = (stdfs::path(__TMP__) / "tebako-prefetch-manifest.bin").string();
+  EXPECT_EQ(0, tebako_prefetch_record_save(path.c_str()));
+
+  std::ifstream file(path, std::ios::binary);
+  std::vector<char> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  auto fs = tebako::sync_tebako_memfs_table::get_tebako_memfs_table().get(0);
+  EXPECT_EQ(fs->get_training(), tebako::package_descriptor::deserialize_manifest(buffer));
+  int handle = tebako_prefetch_manifest(buffer.data(), buffer.size());
+  EXPECT_LT(0, handle);
+  EXPECT_EQ(0, tebako_prefetch_wait(handle));
+  stdfs::remove(path);
+}
+
+TEST_F(PrefetchTests, prefetch_job)
+{
+  auto manifest = record();
+  unmount_root_memfs();
+  mount();
+
+  auto job = tebako::prefetch_memfs(0, manifest);
+  ASSERT_TRUE(job != nullptr);
+  job->wait();
+  EXPECT_TRUE(job->is_done());
+  EXPECT_EQ(manifest.size(), job->get_completed());
+}
+
+TEST_F(PrefetchTests, prefetch_invalid)
+{
+  errno = 0;
+  EXPECT_EQ(-1, tebako_prefetch_manifest(NULL, 0));
+  EXPECT_EQ(EFAULT, errno);
+
+  const char garbage[] = "DWARFS";
+  errno = 0;
+  EXPECT_EQ(-1, tebako_prefetch_manifest(garbage, sizeof(garbage)));
+  EXPECT_EQ(EINVAL, errno);
+
+  errno = 0;
+  EXPECT_EQ(nullptr, tebako::prefetch_memfs(5, {}));
+  EXPECT_EQ(ENOENT, errno);
+}
+
+TEST_F(PrefetchTests, prefetch_file)
+{
+  int handle = tebako_prefetch(TEBAKIZE_PATH("file.txt"), 0);
+  EXPECT_LT(0, handle);
+  EXPECT_EQ(0, tebako_prefetch_wait(handle));
+  EXPECT_EQ(1, tebako_prefetch_done(handle));
+}
+
+TEST_F(PrefetchTests, prefetch_directory)
+{
+  struct tebako_pool_stats before, after;
+  EXPECT_EQ(0, tebako_get_pool_stats(&before));
+
+  int handle = tebako_prefetch(TEBAKIZE_PATH("directory-3"), 0);
+  EXPECT_LT(0, handle);
+  EXPECT_EQ(0, tebako_prefetch_wait(handle));
+
+  int handle2 = tebako_prefetch(TEBAKIZE_PATH("directory-with-90-files"), TEBAKO_PREFETCH_NORECURSE);
+  EXPECT_LT(handle, handle2);
+  EXPECT_EQ(0, tebako_prefetch_wait(handle2));
+
+  EXPECT_EQ(0, tebako_get_pool_stats(&after));
+  EXPECT_LT(before.tasks_completed, after.tasks_completed);
+}
+
+TEST_F(PrefetchTests, prefetch_job_collector)
+{
+  auto fs = tebako::sync_tebako_memfs_table::get_tebako_memfs_table().get(0);
+  ASSERT_TRUE(fs != nullptr);
+  struct STAT_TYPE st;
+  EXPECT_EQ(0, tebako_stat(TEBAKIZE_PATH("file2.txt"), &st));
+
+  auto job = tebako::prefetch_job::start([&st](tebako::prefetch_job& job) {
+    job.add(st.st_ino, 0, st.st_size);
+    job.add(st.st_ino, 0, st.st_size);
+  });
+  job->wait();
+  EXPECT_EQ(2, job->get_total());
+  EXPECT_EQ(2, job->get_completed());
+}
+
+TEST_F(PrefetchTests, prefetch_glob)
+{
+  int handle = tebako_prefetch_glob(TEBAKIZE_PATH("directory-with-90-files/file-1*.txt"), 0);
+  EXPECT_LT(0, handle);
+  EXPECT_EQ(0, tebako_prefetch_wait(handle));
+  EXPECT_EQ(1, tebako_prefetch_done(handle));
+}
+
+TEST_F(PrefetchTests, prefetch_cancel)
+{
+  int handle = tebako_prefetch(TEBAKIZE_PATH(""), 0);
+  EXPECT_LT(0, handle);
+  EXPECT_EQ(0, tebako_prefetch_cancel(handle));
+  EXPECT_EQ(1, tebako_prefetch_done(handle));
+
+  // Unmount cancels the jobs in progress
+  handle = tebako_prefetch(TEBAKIZE_PATH(""), 0);
+  EXPECT_LT(0, handle);
+  unmount_root_memfs();
+  EXPECT_EQ(0, tebako_prefetch_wait(handle));
+}
+
+TEST_F(PrefetchTests, prefetch_errors)
+{
+  errno = 0;
+  EXPECT_EQ(-1, tebako_prefetch(NULL, 0));
+  EXPECT_EQ(ENOENT, errno);
+
+  errno = 0;
+  EXPECT_EQ(-1, tebako_prefetch(TEBAKIZE_PATH("no-such-file.txt"), 0));
+  EXPECT_EQ(ENOENT, errno);
+
+  errno = 0;
+  EXPECT_EQ(-1, tebako_prefetch(__TMP__, 0));
+  EXPECT_EQ(EXDEV, errno);
+
+  errno = 0;
+  EXPECT_EQ(-1, tebako_prefetch_glob(__TMP__ "/*", 0));
+  EXPECT_EQ(EXDEV, errno);
+
+  errno = 0;
+  EXPECT_EQ(-1, tebako_prefetch_wait(1000000));
+  EXPECT_EQ(EINVAL, errno);
+  errno = 0;
+  EXPECT_EQ(-1, tebako_prefetch_cancel(0));
+  EXPECT_EQ(EINVAL, errno);
+}
+
+}  // namespace
@@ -30,6 +30,8 @@
 #include "tests.h"
 #include <tebako-io-inner.h>
 #include <tebako-io-root.h>
+#include <tebako-memfs.h>
+#include <tebako-memfs-table.h>
 #include <tebako-mount-table.h>
 #include <tebako-cmdline.h>
 
@@ -209,6 +211,45 @@ TEST_F(ProcessMountpointsTest, valid_dwarfs_mount)
   EXPECT_TRUE(sync_tebako_mount_table::get_tebako_mount_table().check(test_dir_ino, "dfs-link"));
 }
 
+TEST_F(ProcessMountpointsTest, valid_dwarfs_mount_with_options)
+{
+  auto mp = std::string("--tebako-mount=directory-1/dfs-link>") + tests_the_other_memfs_image() +
+            "?cachesize=16M,workers=1";
+
+  const int argc = 2;
+  const char* argv[argc] = {"program", mp.c_str()};
+
+  cmdline_args args(argc, argv);
+  args.parse_arguments();
+
+  EXPECT_NO_THROW(args.process_mountpoints());
+  auto target = sync_tebako_mount_table::get_tebako_mount_table().get(test_dir_ino, "dfs-link");
+  ASSERT_TRUE(target.has_value());
+  ASSERT_TRUE(std::holds_alternative<uint32_t>(*target));
+
+  auto fs = sync_tebako_memfs_table::get_tebako_memfs_table().get(std::get<uint32_t>(*target));
+  ASSERT_TRUE(fs != nullptr);
+  EXPECT_EQ(static_cast<size_t>(16) << 20, fs->get_options().cachesize);
+  EXPECT_EQ(1, fs->get_options().workers);
+  EXPECT_EQ(memfs::options().decompress_ratio, fs->get_options().decompress_ratio);
+
+  auto root = sync_tebako_memfs_table::get_tebako_memfs_table().get(0);
+  EXPECT_EQ(memfs::options().cachesize, root->get_options().cachesize);
+}
+
+TEST_F(ProcessMountpointsTest, invalid_dwarfs_mount_options)
+{
+  auto mp = std::string("--tebako-mount=directory-1/dfs-link>") + tests_the_other_memfs_image() + "?nosuchoption=1";
+
+  const int argc = 2;
+  const char* argv[argc] = {"program", mp.c_str()};
+
+  cmdline_args args(argc, argv);
+  args.parse_arguments();
+
+  EXPECT_THROW(args.process_mountpoints(), std::invalid_argument);
+}
+
 TEST_F(ProcessMountpointsTest, no_file_dwarfs_mount)
 {
   const int argc = 2;
@@ -0,0 +1,206 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+
+#include <tebako-io-inner.h>
+#include <tebako-io-root.h>
+#include <tebako-memfs.h>
+#include <tebako-memfs-table.h>
+#include <tebako-disk-cache.h>
+#include <tebako-shm-cache.h>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+
+/*
+ *  Unit tests for the shared memory cache ('tebako_set_shm_cache', tebako_shm_cache)
+ */
+namespace {
+
+class ShmCacheTests : public ::testing::Test {
+ protected:
+  uint64_t identity;
+
+  void SetUp() override
+  {
+    identity = 0x7e8a0000ULL + ::getpid();
+    tebako::tebako_shm_cache::unlink(identity);
+  }
+
+  void TearDown() override
+  {
+    tebako_unlink_shm_cache(0);
+    unmount_root_memfs();
+    tebako_set_shm_cache(NULL);
+    tebako::tebako_shm_cache::unlink(identity);
+  }
+
+  static std::string read_file(const char* path)
+  {
+    std::string content;
+    char buf[7];  // Small buffer to cross chunk boundaries often
+    ssize_t n;
+    int fh = tebako_open(2, path, O_RDONLY);
+    EXPECT_LT(0, fh);
+    while ((n = tebako_read(fh, buf, sizeof(buf))) > 0) {
+      content.append(buf, n);
+    }
+    EXPECT_EQ(0, tebako_close(fh));
+    return content;
+  }
+};
+
+TEST_F(ShmCacheTests, attach)
+{
+  tebako::tebako_shm_cache first(1 << 20, identity);
+  EXPECT_TRUE(first.is_creator());
+  // The creator fixes the capacity
+  tebako::tebako_shm_cache second(64 << 20, identity);
+  EXPECT_FALSE(second.is_creator());
+  EXPECT_EQ(first.get_slot_count(), second.get_slot_count());
+
+  char buf[16];
+  size_t length;
+  EXPECT_FALSE(second.get(1, 0, 0, buf, sizeof(buf), length));
+  std::string chunk(1000, 'a');
+  chunk[10] = 'b';
+  first.put(1, 0, chunk.data(), chunk.size());
+  ASSERT_TRUE(second.get(1, 0, 10, buf, 3, length));
+  EXPECT_EQ(chunk.size(), length);
+  EXPECT_EQ("baa", std::string(buf, 3));
+}
+
+TEST_F(ShmCacheTests, another_process)
+{
+  tebako::tebako_shm_cache cache(1 << 20, identity);
+  pid_t pid = fork();
+  if (pid == 0) {
+    bool creator;
+    {
+      tebako::tebako_shm_cache child(1 << 20, identity);
+      std::string chunk(5000, 'c');
+      child.put(7, 3, chunk.data(), chunk.size());
+      creator = child.is_creator();
+    }
+    _exit(creator ? 1 : 0);
+  }
+  ASSERT_LT(0, pid);
+  int status;
+  ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  EXPECT_EQ(0, WEXITSTATUS(status));
+
+  std::vector<char> buf(tebako::tebako_shm_cache::chunk_size);
+  size_t length;
+  ASSERT_TRUE(cache.get(7, 3, 0, buf.data(), buf.size(), length));
+  EXPECT_EQ(5000u, length);
+  EXPECT_EQ('c', buf[4999]);
+}
+
+TEST_F(ShmCacheTests, unlinked_at_last_detach)
+{
+  std::string name = tebako::tebako_shm_cache::segment_name(identity);
+  auto first = std::make_unique<tebako::tebako_shm_cache>(1 << 20, identity);
+  auto second = std::make_unique<tebako::tebako_shm_cache>(1 << 20, identity);
+  first.reset();
+  int fd = shm_open(name.c_str(), O_RDONLY, 0600);
+  EXPECT_LE(0, fd);
+  close(fd);
+
+  second.reset();
+  errno = 0;
+  EXPECT_EQ(-1, shm_open(name.c_str(), O_RDONLY, 0600));
+  EXPECT_EQ(ENOENT, errno);
+}
+
+TEST_F(ShmCacheTests, writable_by_others)
+{
+  std::string name = tebako::tebako_shm_cache::segment_name(identity);
+  int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  ASSERT_LE(0, fd);
+  EXPECT_EQ(0, fchmod(fd, 0666));
+  EXPECT_EQ(0, ftruncate(fd, 1 << 20));
+  close(fd);
+  EXPECT_THROW(tebako::tebako_shm_cache(1 << 20, identity), std::runtime_error);
+}
+
+TEST_F(ShmCacheTests, size_cap)
+{
+  tebako::tebako_shm_cache cache(1 << 20, identity);
+  size_t slots = cache.get_slot_count();
+  std::string chunk(tebako::tebako_shm_cache::chunk_size, 'z');
+  for (uint64_t i = 0; i < 10 * slots; ++i) {
+    cache.put(2, i, chunk.data(), chunk.size());
+  }
+  char c;
+  size_t length;
+  size_t cached = 0;
+  for (uint64_t i = 0; i < 10 * slots; ++i) {
+    if (cache.get(2, i, 0, &c, 1, length)) {
+      ++cached;
+    }
+  }
+  EXPECT_GE(slots, cached);
+  EXPECT_LT(0, cached);
+}
+
+TEST_F(ShmCacheTests, memfs)
+{
+  // No segment left by an interrupted run
+  uint64_t image = tebako::tebako_disk_cache::image_identity(&gfsData[0], gfsSize);
+  tebako::tebako_shm_cache::unlink(image);
+  // Another worker stays attached, so the segment outlives the unmount below
+  tebako::tebako_shm_cache worker(16 << 20, image);
+  EXPECT_EQ(0, tebako_set_shm_cache("16M"));
+  EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL, NULL, NULL, NULL, "auto"));
+  std::string cold = read_file(TEBAKIZE_PATH("file.txt"));
+  struct tebako_cache_stats st;
+  EXPECT_EQ(0, tebako_get_cache_stats(0, &st));
+  EXPECT_LT(0, st.shm_cache_misses);
+
+  unmount_root_memfs();
+
+  // Another worker attaches to the segment and reads the chunk decompressed by the first one
+  EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL, NULL, NULL, NULL, "auto"));
+  EXPECT_EQ(cold, read_file(TEBAKIZE_PATH("file.txt")));
+  EXPECT_EQ(0, tebako_get_cache_stats(0, &st));
+  EXPECT_LT(0, st.shm_cache_hits);
+  EXPECT_EQ(0, st.shm_cache_misses);
+}
+
+TEST_F(ShmCacheTests, not_enabled)
+{
+  EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), NULL, NULL, NULL, NULL, "auto"));
+  errno = 0;
+  EXPECT_EQ(-1, tebako_unlink_shm_cache(0));
+  EXPECT_EQ(ENOENT, errno);
+}
+
+}  // namespace
+#endif  // !_WIN32
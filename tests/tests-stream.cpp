@@ -0,0 +1,121 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+
+/*
+ *  Unit tests for the reads that bypass the block cache ('tebako_set_stream')
+ */
+namespace {
+
+class StreamTests : public ::testing::Test {
+ protected:
+  void TearDown() override
+  {
+    tebako_set_stream(NULL, NULL);
+    unmount_root_memfs();
+  }
+
+  static void mount(const char* threshold, const char* cachesize = NULL)
+  {
+    unmount_root_memfs();
+    EXPECT_EQ(0, tebako_set_stream(threshold, "64K"));
+    EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), cachesize, NULL, NULL, NULL, "auto"));
+  }
+
+  static struct tebako_cache_stats stats(void)
+  {
+    struct tebako_cache_stats st;
+    EXPECT_EQ(0, tebako_get_cache_stats(0, &st));
+    return st;
+  }
+
+  static std::string read_file(const char* path, int flags = O_RDONLY)
+  {
+    std::string content;
+    char buf[16];
+    ssize_t n;
+    int fh = tebako_open(2, path, flags);
+    EXPECT_LT(0, fh);
+    while ((n = tebako_read(fh, buf, sizeof(buf))) > 0) {
+      content.append(buf, n);
+    }
+    EXPECT_EQ(0, tebako_close(fh));
+    return content;
+  }
+};
+
+TEST_F(StreamTests, below_threshold)
+{
+  mount("1M");
+  EXPECT_FALSE(read_file(TEBAKIZE_PATH("file.txt")).empty());
+  EXPECT_EQ(0, stats().stream_reads);
+}
+
+TEST_F(StreamTests, above_threshold)
+{
+  mount(NULL);
+  std::string expected = read_file(TEBAKIZE_PATH("directory-1/file-in-directory-1.txt"));
+
+  mount("1");
+  auto before = stats();
+  EXPECT_EQ(expected, read_file(TEBAKIZE_PATH("directory-1/file-in-directory-1.txt")));
+  auto after = stats();
+  EXPECT_LT(before.stream_reads, after.stream_reads);
+  EXPECT_EQ(before.stream_bytes + expected.size(), after.stream_bytes);
+  // Blocks of the streamed files are not decompressed into the block cache
+  EXPECT_EQ(before.blocks_released, after.blocks_released);
+}
+
+#ifdef O_DIRECT
+TEST_F(StreamTests, o_direct_hint)
+{
+  mount(NULL);
+  std::string expected = read_file(TEBAKIZE_PATH("file2.txt"));
+  auto before = stats();
+  EXPECT_EQ(expected, read_file(TEBAKIZE_PATH("file2.txt"), O_RDONLY | O_DIRECT));
+  EXPECT_LT(before.stream_reads, stats().stream_reads);
+}
+#endif
+
+TEST_F(StreamTests, options)
+{
+  mount(NULL);
+  int ret = mount_memfs_with_options(&gfsData[0], gfsSize, "auto", 0, "dummy", "stream_threshold=1,stream_buffers=1M");
+  EXPECT_LE(1, ret);
+  struct tebako_cache_stats st;
+  EXPECT_EQ(0, tebako_get_cache_stats(ret, &st));
+  EXPECT_EQ(0, st.stream_reads);
+
+  errno = 0;
+  EXPECT_EQ(-1, tebako_set_stream("huge", NULL));
+  EXPECT_EQ(EINVAL, errno);
+}
+
+}  // namespace
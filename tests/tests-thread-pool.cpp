@@ -0,0 +1,125 @@
+/**
+ *
+ * Copyright (c) 2026 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ * This file is a part of the Tebako project. (libdwarfs-wr)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "tests.h"
+
+#include <tebako-io-inner.h>
+#include <tebako-io-root.h>
+#include <tebako-memfs.h>
+#include <tebako-memfs-table.h>
+#include <tebako-thread-pool.h>
+
+namespace tebako {
+
+class ThreadPoolTests : public ::testing::Test {
+ protected:
+  tebako_thread_pool& pool = tebako_thread_pool::get_tebako_thread_pool();
+
+  void TearDown() override { unmount_root_memfs(); }
+};
+
+TEST_F(ThreadPoolTests, cpu_quota)
+{
+  EXPECT_GE(tebako_thread_pool::detect_cpu_quota(), 1);
+  EXPECT_EQ(tebako_thread_pool::detect_cpu_quota(), pool.get_size());
+}
+
+TEST_F(ThreadPoolTests, submit)
+{
+  std::mutex mtx;
+  std::condition_variable cv;
+  int done = 0;
+  for (int i = 0; i < 16; ++i) {
+    pool.submit([&]() {
+      std::lock_guard<std::mutex> lock(mtx);
+      if (++done == 16) {
+        cv.notify_one();
+      }
+    });
+  }
+  std::unique_lock<std::mutex> lock(mtx);
+  EXPECT_TRUE(cv.wait_for(lock, std::chrono::seconds(10), [&] { return done == 16; }));
+}
+
+TEST_F(ThreadPoolTests, parallel_run)
+{
+  std::atomic<size_t> next{0};
+  std::vector<int> seen(1000, 0);
+  pool.parallel_run(pool.get_size(), [&]() {
+    size_t i;
+    while ((i = next++) < seen.size()) {
+      seen[i]++;
+    }
+  });
+  for (auto s : seen) {
+    EXPECT_EQ(1, s);
+  }
+
+  struct tebako_pool_stats st;
+  EXPECT_EQ(0, tebako_get_pool_stats(&st));
+  EXPECT_EQ(pool.get_size(), st.cpu_quota);
+  EXPECT_LE(st.threads, st.cpu_quota);
+}
+
+TEST_F(ThreadPoolTests, reserve_workers)
+{
+  size_t quota = pool.get_size();
+  size_t first = pool.reserve_workers(quota + 10);
+  size_t second = pool.reserve_workers(2);
+  EXPECT_EQ(quota - 1, first);
+  EXPECT_EQ(0, second);
+  EXPECT_FALSE(pool.share_worker(first).owns_lock());
+  EXPECT_TRUE(pool.share_worker(second).owns_lock());
+  pool.release_workers(first);
+  pool.release_workers(second);
+  EXPECT_EQ(0, pool.get_stats().decompression_workers);
+}
+
+TEST_F(ThreadPoolTests, memfs_workers)
+{
+  EXPECT_EQ(0, mount_root_memfs(&gfsData[0], gfsSize, tests_log_level(), nullptr, nullptr, nullptr, nullptr, nullptr));
+  auto fs = sync_tebako_memfs_table::get_tebako_memfs_table().get(0);
+  ASSERT_TRUE(fs != nullptr);
+  EXPECT_GE(fs->get_workers(), 1);
+  EXPECT_LE(fs->get_workers(), pool.get_size());
+  EXPECT_LE(pool.get_stats().decompression_workers, fs->get_workers());
+  EXPECT_LT(pool.get_stats().decompression_workers, pool.get_size() > 1 ? pool.get_size() : 1);
+
+  unmount_root_memfs();
+  EXPECT_EQ(0, pool.get_stats().decompression_workers);
+}
+
+TEST_F(ThreadPoolTests, pool_stats_null)
+{
+  errno = 0;
+  EXPECT_EQ(-1, tebako_get_pool_stats(nullptr));
+  EXPECT_EQ(EFAULT, errno);
+}
+
+}  // namespace tebako